@@ -36,6 +36,7 @@ SOURCES = AlbumEasy.cpp                               \
           aeasy_flistwindow.cpp                       \
           aeasy_config.cpp                            \
           aeasy_fonts.cpp                             \
+          aeasy_layout.cpp                            \
           libhpdf-2.3.0RC2/src/hpdf_3dmeasure.c       \
           libhpdf-2.3.0RC2/src/hpdf_annotation.c      \
           libhpdf-2.3.0RC2/src/hpdf_array.c           \
@@ -102,7 +103,9 @@ HEADERS = AlbumEasy.h           \
           aeasy_flistwindow.h   \
           aeasy_config.h        \
           aeasy_fonts.h         \
-          aeasy_ttf_structs.h
+          aeasy_layout.h        \
+          aeasy_ttf_structs.h   \
+          aeasy_codepages.h
 
 QMAKE_CXXFLAGS += -Wall
 
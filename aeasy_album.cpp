@@ -23,6 +23,7 @@
 #include "aeasy_version.h"
 #include "aeasy_fonts.h"
 #include "aeasy_album.h"
+#include "aeasy_layout.h"
 
 
 /************************************************************************************************/
@@ -40,6 +41,10 @@ void CAlbumData::reset(void)
   m_hasBorders=false;
   m_spacingSet=false;
   m_rowAlign=ROW_ALIGN_TOP;
+  m_compression=PDF_COMPRESSION_BALANCED;
+  m_objectStreams=false;
+  m_fastWebView=false;
+  m_memoryBudget=0;
 
   if(m_title!=0)
     {
@@ -179,6 +184,70 @@ void CAlbumData::setRowAlignment(ROW_ALIGN rowAlign)
 }
 
 
+/************************************************************************************************/
+void CAlbumData::setCompression(PDF_COMPRESSION compression)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: set the compression of the page content and fonts in the PDF file
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  compression: none, fast, balanced or max compression
+   --------------------------------------------------------------------------------------------
+       RETURNS:  none
+   -------------------------------------------------------------------------------------------- */
+{
+  m_compression=compression;
+}
+
+
+/************************************************************************************************/
+void CAlbumData::setObjectStreams(bool objectStreams)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: set whether the PDF objects are packed into compressed object streams, which
+                needs PDF 1.5
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  objectStreams: true => use object streams and a cross-reference stream
+   --------------------------------------------------------------------------------------------
+       RETURNS:  none
+   -------------------------------------------------------------------------------------------- */
+{
+  m_objectStreams=objectStreams;
+}
+
+
+/************************************************************************************************/
+void CAlbumData::setFastWebView(bool fastWebView)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: set whether the PDF file is linearized, so that viewers can show the first page
+                before the whole file has been downloaded
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  fastWebView: true => linearize the file
+   --------------------------------------------------------------------------------------------
+       RETURNS:  none
+   -------------------------------------------------------------------------------------------- */
+{
+  m_fastWebView=fastWebView;
+}
+
+
+/************************************************************************************************/
+void CAlbumData::setMemoryBudget(int megabytes)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: set the memory the PDF page contents, forms and fonts may use while the album is
+                generated, beyond which they are kept in a temporary file
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  megabytes: the memory budget, 0 => no limit, at most PDF_MAX_MEMORY_BUDGET
+   --------------------------------------------------------------------------------------------
+       RETURNS:  none
+   -------------------------------------------------------------------------------------------- */
+{
+  if(megabytes<0)
+    megabytes=0;
+  else if(megabytes>PDF_MAX_MEMORY_BUDGET)
+    megabytes=PDF_MAX_MEMORY_BUDGET;
+  m_memoryBudget=megabytes;
+}
+
+
+
 /************************************************************************************************/
 bool CAlbumData::hasRow(void)
 /* --------------------------------------------------------------------------------------------
@@ -294,6 +363,9 @@ bool CAlbumData::generatePdf(QString file)
 {
   bool error=false;
 
+  QElapsedTimer timer;                                          //time taken, reported on success
+  timer.start();
+
   int pageno=0;
                                  //ensure that the mandatory page formatting options have been set
   if(m_sizeSet==false || m_mrgSet==false || m_spacingSet==false)
@@ -319,8 +391,48 @@ bool CAlbumData::generatePdf(QString file)
                      (QString("AlbumEasy v")+QString::number(VER_MAJOR)+"."+
                      QString::number(VER_MINOR)+VER_REV).toLatin1()
                      );
+                    //compress the page content, forms and embedded fonts (COMP_METADATA in Haru)
+    HPDF_UINT compressionMode=HPDF_COMP_NONE;
+    if(m_compression==PDF_COMPRESSION_FAST)
+      compressionMode=HPDF_COMP_ALL|HPDF_COMP_BEST_SPEED;
+    else if(m_compression==PDF_COMPRESSION_BALANCED)
+      compressionMode=HPDF_COMP_ALL;
+    else if(m_compression==PDF_COMPRESSION_MAX)
+      compressionMode=HPDF_COMP_ALL|HPDF_COMP_BEST_COMPRESS;
+    HPDF_SetCompressionMode(m_pdfDoc,compressionMode);
+    if(m_fastWebView==true)                         //first page before the rest (PDF linearization)
+      HPDF_SetLinearized(m_pdfDoc,HPDF_TRUE);
+    else if(m_objectStreams==true)           //PDF 1.5 object streams, not used by a linearized file
+      HPDF_SetObjectStreams(m_pdfDoc,HPDF_TRUE);
+                       //balanced page tree, so large albums open quickly and any page is found fast
+    HPDF_SetPageTreeFanout(m_pdfDoc,PDF_PAGE_TREE_FANOUT);
+    if(m_memoryBudget>0)                      //move stream data past the budget to a temporary file
+      HPDF_SetMemoryBudget(m_pdfDoc,(HPDF_UINT)m_memoryBudget*1024u*1024u);
+
+    bool streamed=false;                       //finished pages written to the file as they are done
+    bool keepStream=false;                        //the finished album couldn't replace the pdf file
+    QString streamFile=file+".part";        //replaces the pdf file only once the album is complete
+    HPDF_STATUS saved=HPDF_OK;                                      //status of writing the pdf file
+                                  //object streams and fast web view need the whole document to save
+    if(m_objectStreams==false && m_fastWebView==false)
+      {
+      saved=HPDF_BeginStreamToFile(m_pdfDoc,streamFile.toLatin1());
+      streamed=(saved==HPDF_OK);
+      }
+    else
+      {
+      emit(logMessage(tr("All the pages are kept in memory until the PDF file is written, "
+                         "as object streams and fast web view need the whole album.")));
+      }
+
+    CFormList forms;
+    compilePageMasters(forms,error);           //geometry, border and title shared by all the pages
+
+    CPdfEmitter emitter(m_pdfDoc,&forms);
+    HPDF_SetParallelHandler(m_pdfDoc,CPdfEmitter::runParallel,&emitter);      //deflate on all cores
+    CDisplayList dlist;                                //reused for every page to avoid reallocation
                                            //iterate through the list of pages generating each one
-    for(int i=0;i<m_pages.size() && error==false;i++)
+    for(int i=0;i<m_pages.size() && error==false && saved==HPDF_OK;i++)
       {
       HPDF_Page pdfPage=HPDF_AddPage(m_pdfDoc);                               //add a new pdf page
       pageno++;
@@ -331,46 +443,45 @@ bool CAlbumData::generatePdf(QString file)
         }
       else
         {
-        CAlbumPage *page=m_pages.at(i);                                //get the data for the page
-
         HPDF_Page_SetWidth(pdfPage,m_width);
         HPDF_Page_SetHeight(pdfPage,m_height);
 
-        bool odd=((pageno%2)!=0)?true:false;
-
-        double hspacing;
-        double vspacing;
-                                                            //if no page specific spacing override
-        if(page->pageSpacingOverride(hspacing,vspacing)==false)
-          {
-          hspacing=m_hspace;                                           //use album default spacing
-          vspacing=m_vspace;
-          }
-
-        double ypos=m_height;                        //initial drawing position at the top of page
-                                                         //draw page background - border and title
-        ypos=drawPageToPdf(page,pageno,ypos,pdfPage,error);
-
-        double drawWidth;
-        double xpos=pageHorizontalDrawArea(drawWidth,hspacing,odd);
+        dlist.clear();
+        layoutPage(m_pages.at(i),m_pageMaster[pageno%2],dlist,forms,error);    //position the items
 
-        QList<CPageItem *> items=page->items();      //iterate through the list of items on a page
-        for(int j=0;j<items.size() && error==false;j++)                        //drawing each item
+        if(error==false && emitter.emitPage(dlist,pdfPage)==true)  //then write them to the pdf page
           {
-          CPageItem *item=items.at(j);
-
-          if(ypos>0.0)                                //if not below bottom of page, draw the item
-            ypos=item->drawToPdf(m_pdfDoc,pdfPage,error,
-                                 xpos,ypos,drawWidth,m_width,hspacing,vspacing);
-          if(error==true)                                   //if an error while generating the pdf
-            displayError(CFontManager::getError());                            //display the error
+          error=true;
+          displayError(emitter.getError());
           }
+        else if(error==false && streamed==true && (i+1)%PDF_FLUSH_PAGES==0)
+          saved=HPDF_FlushPages(m_pdfDoc);                         //write the pages finished so far
         }
       }
 
     if(error==false)
       {
-      if(HPDF_SaveToFile(m_pdfDoc, file.toLatin1())!=HPDF_OK)                  //save the pdf file
+      if(saved==HPDF_OK)                                                         //save the pdf file
+        saved=(streamed==true ? HPDF_EndStreamToFile(m_pdfDoc) :
+                                HPDF_SaveToFile(m_pdfDoc, file.toLatin1()));
+      if(saved==HPDF_OK && streamed==true)        //replace the previous pdf with the finished file
+        {
+                       //the previous pdf is only removed when it is there to be replaced, and the
+                       //finished file is kept if it can't take its place
+        if(QFile::exists(file)==true && QFile::remove(file)==false)
+          keepStream=true;
+        else if(QFile::rename(streamFile,file)==false)
+          keepStream=true;
+        }
+      if(keepStream==true)
+        {
+        error=true;
+        displayError(tr("Unable to replace file %1.<br />"
+                        "The generated album has been saved as %2.<br />"
+                        "If you have the file open for viewing, please close the viewer.")
+                        .arg(file).arg(streamFile));
+        }
+      else if(saved!=HPDF_OK)
         {
         error=true;       //if an error while saving the pdf, display an appropriate error message
 
@@ -395,8 +506,20 @@ bool CAlbumData::generatePdf(QString file)
           }
 
         }
+      else                     //report the size and generation time for the chosen compression
+        {
+        static const char *compressionNames[]={"none","fast","balanced","max"};
+
+        emit(logMessage(tr("%1 pages, %2 KB, generated in %3 ms with %4 compression.")
+                        .arg(m_pages.size())
+                        .arg((QFileInfo(file).size()+1023)/1024)
+                        .arg(timer.elapsed())
+                        .arg(compressionNames[m_compression])));
+        }
       }
     HPDF_Free (m_pdfDoc);
+    if(error==true && streamed==true && keepStream==false)       //don't leave a partial file behind
+      QFile::remove(streamFile);
     }
   return error;
 }
@@ -503,22 +626,53 @@ double CAlbumData::pageHorizontalCentre(bool odd)
 
 
 /************************************************************************************************/
-double CAlbumData::drawPageToPdf(CAlbumPage *page,int pageno,double ypos,HPDF_Page pdfPage,
-                                 bool &error)
+void CAlbumData::compilePageMasters(CFormList &forms,bool &error)
 /* --------------------------------------------------------------------------------------------
-   DESCRIPTION: Draw page common items i.e border and title to the pdf page
+   DESCRIPTION: Compile the page masters of the odd and even pages, before any page is laid
+                out. Each holds the margins and drawing area of its pages, and the border and
+                title laid out as a form. The form is written to the PDF once, and then placed
+                on every page, instead of repeating the same drawing operators in the content
+                of each page. The masters don't change after this, pages only read them.
    --------------------------------------------------------------------------------------------
-    PARAMETERS:    page: page date
-                 pageno: number of the page
-                   ypos: vertical position to start drawing from
-                pdfPage: pdf being output
-                  error: flag set to true if there are any errors while generating the page
+    PARAMETERS: forms: form list receiving the odd and even page forms
+                error: flag set to true if there are any errors while laying out the forms
    --------------------------------------------------------------------------------------------
-       RETURNS:  double: vertical position to start drawing the items on the page
+       RETURNS:  none
    -------------------------------------------------------------------------------------------- */
 {
-  bool odd=((pageno%2)!=0) ? true : false;
+  for(int i=0;i<2 && error==false;i++)                                     //[0]even and [1]odd
+    {
+    bool odd=(i==1)?true:false;
+    PAGE_MASTER &master=m_pageMaster[i];
+
+    master.left=pageHorizontalDrawArea(master.width,0.0,odd);         //page spacing added per page
 
+    int form=forms.addForm(m_width,m_height);
+    CDisplayList &dlist=forms.displayList(form);
+
+    master.top=layoutPageChrome(odd,dlist,error);
+    master.form=(dlist.count()>0)?form:-1;                 //no border or title => nothing to place
+    }
+}
+
+
+/************************************************************************************************/
+void CAlbumData::layoutPage(CAlbumPage *page,const PAGE_MASTER &master,CDisplayList &dlist,
+                            CFormList &forms,bool &error)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Layout pass for a page. Places the border and title form of the page master
+                and positions all the items on the page, adding them to the display list.
+                Nothing is written to the PDF page here.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:    page: page data
+                 master: page master of the odd or even pages
+                  dlist: display list receiving the laid out page
+                  forms: forms shared between pages, receives any new stamp templates
+                  error: flag set to true if there are any errors while laying out the page
+   --------------------------------------------------------------------------------------------
+       RETURNS:  none
+   -------------------------------------------------------------------------------------------- */
+{
   double hspacing;
   double vspacing;
   if(page->pageSpacingOverride(hspacing,vspacing)==false)   //if no page specific spacing override
@@ -527,6 +681,47 @@ double CAlbumData::drawPageToPdf(CAlbumPage *page,int pageno,double ypos,HPDF_Pa
     vspacing=m_vspace;
     }
 
+  if(master.form>=0)                                           //page background - border and title
+    dlist.addForm(master.form,0.0,0.0);
+
+  double ypos=master.top;                                //initial drawing position below the title
+  if(m_title!=0)
+    ypos=ypos-vspacing;
+
+  double xpos=master.left+hspacing;                          //drawing area inside the page spacing
+  double drawWidth=master.width-2*hspacing;
+
+  QList<CPageItem *> items=page->items();              //iterate through the list of items on a page
+  for(int j=0;j<items.size() && error==false;j++)                           //laying out each item
+    {
+    CPageItem *item=items.at(j);
+
+    if(ypos>0.0)                                   //if not below bottom of page, lay out the item
+      ypos=item->layout(dlist,forms,m_pdfDoc,error,xpos,ypos,drawWidth,m_width,
+                        hspacing,vspacing);
+    if(error==true)                                          //if an error while laying out the page
+      displayError(CFontManager::getError());                                  //display the error
+    }
+}
+
+
+/************************************************************************************************/
+double CAlbumData::layoutPageChrome(bool odd,CDisplayList &dlist,bool &error)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Lay out the page common items i.e border and title. These are the same on
+                every odd or every even page, so they do not depend on the page spacing.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:     odd: true  => odd numbered page
+                         false => even numbered page
+                  dlist: display list receiving the border and title
+                  error: flag set to true if there are any errors while laying out the page
+   --------------------------------------------------------------------------------------------
+       RETURNS:  double: vertical position below the title, the page vertical spacing still
+                         has to be subtracted if there is a title
+   -------------------------------------------------------------------------------------------- */
+{
+  double ypos=m_height;                              //initial drawing position at the top of page
+
   if(m_hasBorders==true)            //if borders have been defined for the album, draw the borders
     {
     QRectF rect;
@@ -534,19 +729,13 @@ double CAlbumData::drawPageToPdf(CAlbumPage *page,int pageno,double ypos,HPDF_Pa
       {
       bool inner=false;
       pageBorderRect(rect,odd,inner);                                 //the outer border rectangle
-                                                                                         //draw it
-      HPDF_Page_SetLineWidth(pdfPage,m_outerBorder);
-      HPDF_Page_Rectangle(pdfPage,rect.x(),rect.y(),rect.width(),rect.height());
-      HPDF_Page_Stroke (pdfPage);
+      dlist.addRect(m_outerBorder,rect.x(),rect.y(),rect.width(),rect.height());
       }
     if(m_innerBorder>0.0)                   //if the inner border line thickness is greater than 0
       {
       bool inner=true;
       pageBorderRect(rect,odd,inner);                                 //the inner border rectangle
-                                                                                         //draw it
-      HPDF_Page_SetLineWidth(pdfPage,m_innerBorder);
-      HPDF_Page_Rectangle(pdfPage,rect.x(),rect.y(),rect.width(),rect.height());
-      HPDF_Page_Stroke (pdfPage);
+      dlist.addRect(m_innerBorder,rect.x(),rect.y(),rect.width(),rect.height());
       }
     }
 
@@ -557,17 +746,15 @@ double CAlbumData::drawPageToPdf(CAlbumPage *page,int pageno,double ypos,HPDF_Pa
   if(m_title!=0)                                                         //if a title has been set
     {
     HPDF_Font font=CFontManager::getFont(m_pdfDoc,m_title->findex());
-    QTextCodec *qtCodec=CFontManager::getCodec(m_title->findex());
+    const CTextEncoder *encoder=CFontManager::getEncoder(m_title->findex());
 
-    if(font==NULL || qtCodec==NULL)
+    if(font==NULL || encoder==NULL)
       {
       error=true;
       displayError(CFontManager::getError());
       }
     else
       {
-      HPDF_Page_SetFontAndSize(pdfPage,font,m_title->fontSize());
-
       double pageCentre=pageHorizontalCentre(odd);
 
       const QList<QString> strings=m_title->strings();
@@ -576,19 +763,19 @@ double CAlbumData::drawPageToPdf(CAlbumPage *page,int pageno,double ypos,HPDF_Pa
                  //the title will always be in the same position on all pages in an album
       ypos=ypos-m_vspace;
 
+      CTextRuns str;                                 //buffers reused for each line of the title
       for(int i=0;i<strings.size();i++)
         {
         ypos=ypos-m_title->fontSize();
 
-        QString str=strings.at(i);
+        str.set(m_pdfDoc,m_title->findex(),font,encoder,strings.at(i).constData(),
+                strings.at(i).length());
 
-        double strWidth=HPDF_Page_TextWidth(pdfPage,qtCodec->fromUnicode(str));
-        HPDF_Page_BeginText(pdfPage);
-        HPDF_Page_TextOut(pdfPage, pageCentre-strWidth/2.0,ypos,qtCodec->fromUnicode(str));
-        HPDF_Page_EndText(pdfPage);
+        double strWidth=str.width(m_title->fontSize());
+        dlist.addText(str,m_title->fontSize(),pageCentre-strWidth/2.0,ypos);
         }
-      ypos=ypos-vspacing;
       }
+
     }
 
   return ypos;
@@ -741,7 +928,6 @@ CPageText::CPageText(int findex,double fsize,QString text,bool centre)
 }
 
 
-
 /************************************************************************************************/
 CPageText::~CPageText()
 /* --------------------------------------------------------------------------------------------
@@ -757,13 +943,13 @@ CPageText::~CPageText()
 
 
 /************************************************************************************************/
-double CPageText::drawToPdf(HPDF_Doc pdfDoc,HPDF_Page pdfPage,bool &error,double xpos,double ypos,
-                            double drawWidth,double,double,double vspacing)
+double CPageText::layout(CDisplayList &dlist,CFormList &,HPDF_Doc pdfDoc,bool &error,
+                         double xpos,double ypos,double drawWidth,double,double,double vspacing)
 /* --------------------------------------------------------------------------------------------
-   DESCRIPTION: Draw the text on the PDF page
+   DESCRIPTION: Lay out the text, wrapping or truncating it to fit the drawing area
    --------------------------------------------------------------------------------------------
-    PARAMETERS:    pdfDoc: PDF document being generated
-                  pdfPage: PDF page in the document
+    PARAMETERS:     dlist: display list receiving the lines of text
+                   pdfDoc: PDF document being generated, provides the font metrics
                     error: error flag return
                      xpos: the horizontal position of the text
                      ypos: the vertical position  of the text
@@ -774,73 +960,75 @@ double CPageText::drawToPdf(HPDF_Doc pdfDoc,HPDF_Page pdfPage,bool &error,double
    -------------------------------------------------------------------------------------------- */
 {
   HPDF_Font font=CFontManager::getFont(pdfDoc,m_ftext->findex());
-  QTextCodec *qtCodec=CFontManager::getCodec(m_ftext->findex());
+  const CTextEncoder *encoder=CFontManager::getEncoder(m_ftext->findex());
 
-  if(font==NULL || qtCodec==NULL)
+  if(font==NULL || encoder==NULL)
     {
     error=true;
     }
   else
     {
-    HPDF_Page_SetFontAndSize(pdfPage,font,m_ftext->fontSize());
+    int findex=m_ftext->findex();
+    double fsize=m_ftext->fontSize();
 
     const QList<QString> strings=m_ftext->strings();
 
+    CTextRuns encStr;               //buffers reused for every width measured while fitting text
     for(int i=0;i<strings.size();i++)
       {
-      ypos=ypos-m_ftext->fontSize();
+      ypos=ypos-fsize;
 
       QString str=strings.at(i);
 
       if(m_ftext->centred()==true && ypos>0.0)   //draw centred text if not below bottom of page
         {
-        double strWidth=HPDF_Page_TextWidth(pdfPage,qtCodec->fromUnicode(str));
+        int length=str.length();
+        encStr.set(pdfDoc,findex,font,encoder,str.constData(),length);
+        double strWidth=encStr.width(fsize);
 
-        while(strWidth>drawWidth && str.length()>0)  //reduce string width to fit the draw width
-          {
-          str=str.left(str.length()-1);
-          strWidth=HPDF_Page_TextWidth(pdfPage,qtCodec->fromUnicode(str));
-          }
-        if(strWidth>0 &&  str.length()>0)
+        while(strWidth>drawWidth && length>0)        //reduce string width to fit the draw width
           {
-          HPDF_Page_BeginText(pdfPage);
-          HPDF_Page_TextOut(pdfPage,xpos+(drawWidth-strWidth)/2,ypos,qtCodec->fromUnicode(str));
-          HPDF_Page_EndText(pdfPage);
+          length--;
+          encStr.set(pdfDoc,findex,font,encoder,str.constData(),length);
+          strWidth=encStr.width(fsize);
           }
+        if(strWidth>0 &&  length>0)
+          dlist.addText(encStr,fsize,xpos+(drawWidth-strWidth)/2,ypos);
         }
       else if(ypos>0.0)              //draw text that is not centred if not below bottom of page
         {
         while(ypos>0.0 && str.length()>0)
           {
-          QString tmpStr=str;
+          int length=str.length();                       //length of the part drawn on this line
 
-          double strWidth=HPDF_Page_TextWidth(pdfPage,qtCodec->fromUnicode(tmpStr));
+          encStr.set(pdfDoc,findex,font,encoder,str.constData(),length);
+          double strWidth=encStr.width(fsize);
           bool shortened=false;
                                                //reduce string width until it fits in draw width
-          while(strWidth>drawWidth && tmpStr.length()>0)
+          while(strWidth>drawWidth && length>0)
             {
-            tmpStr=tmpStr.left(tmpStr.length()-1);
-            strWidth=HPDF_Page_TextWidth(pdfPage, qtCodec->fromUnicode(tmpStr));
+            length--;
+            encStr.set(pdfDoc,findex,font,encoder,str.constData(),length);
+            strWidth=encStr.width(fsize);
             shortened=true;
             }
 
           if(shortened==true)
             {
                                                      //step back to the end of the previous word
-            while(tmpStr.length()>0 && tmpStr.at(tmpStr.length()-1).isSpace()==false)
+            while(length>0 && str.at(length-1).isSpace()==false)
               {
-              tmpStr.chop(1);                                        //remove the last character
+              length--;                                              //remove the last character
               }
+            encStr.set(pdfDoc,findex,font,encoder,str.constData(),length);
             }
 
-          HPDF_Page_BeginText (pdfPage);
-          HPDF_Page_TextOut (pdfPage, xpos, ypos,qtCodec->fromUnicode(tmpStr));
-          HPDF_Page_EndText (pdfPage);
+          dlist.addText(encStr,fsize,xpos,ypos);
 
-          if(tmpStr.length()<str.length())     //if the whole text string has not yet been drawn
+          if(length<str.length())              //if the whole text string has not yet been drawn
             {
-            str=str.right(str.length()-tmpStr.length());       //get the remainder of the string
-            ypos=ypos-m_ftext->fontSize();
+            str=str.right(str.length()-length);                //get the remainder of the string
+            ypos=ypos-fsize;
             }
           else
             str="";                                                //finished drawing the string
@@ -925,14 +1113,18 @@ void CPageStampRow::addStamp(STAMP_STYLE style,double width,double height,QStrin
 
 
 /************************************************************************************************/
-double CPageStampRow::drawToPdf(HPDF_Doc pdfDoc,HPDF_Page pdfPage,bool &error,
-                               double xpos,double ypos,double drawWidth,double pageWidth,
-                               double hspacing,double vspacing)
+double CPageStampRow::layout(CDisplayList &dlist,CFormList &forms,HPDF_Doc pdfDoc,bool &error,
+                             double xpos,double ypos,double drawWidth,double pageWidth,
+                             double hspacing,double vspacing)
 /* --------------------------------------------------------------------------------------------
-   DESCRIPTION: Draw the row of stamps on the PDF page
-   --------------------------------------------------------------------------------------------
-    PARAMETERS:    pdfDoc: PDF document being generated
-                  pdfPage: PDF page in the document
+   DESCRIPTION: Lay out the row of stamps, spacing them according to the row style.
+                A stamp that repeats an earlier stamp, including its text, is placed as a
+                shared template form. Frames on their own are laid out in place, so that the
+                outlines of a row are still painted with a single stroke.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:     dlist: display list receiving the stamps
+                    forms: stamp templates shared by the whole album
+                   pdfDoc: PDF document being generated, provides the font metrics
                     error: error flag return
                      xpos: the horizontal position
                      ypos: the vertical position
@@ -1021,21 +1213,51 @@ double CPageStampRow::drawToPdf(HPDF_Doc pdfDoc,HPDF_Page pdfPage,bool &error,
     }
                                   //get the font used for drawing text inside and under the stamps
   HPDF_Font font=CFontManager::getFont(pdfDoc,m_findex);
-  QTextCodec *qtCodec=CFontManager::getCodec(m_findex);
+  const CTextEncoder *encoder=CFontManager::getEncoder(m_findex);
 
-  if(font==NULL || qtCodec==NULL)
+  if(font==NULL || encoder==NULL)
     error=true;
   else
     {
-    HPDF_Page_SetFontAndSize(pdfPage, font, m_fsize);
-
+    double rowStart=sxpos;
+    QVector<bool> placed(m_stamps.size(),false);         //stamps placed complete with their text
+                  //lay out all the outlines in the row first, so that they are adjacent in the
+                  //display list and can be painted with a single stroke
     for(int i=0;i<m_stamps.size() ;i++)                       //iterate through the list of stamps
       {
       CStamp *stamp=m_stamps.at(i);
       if(sxpos<(xpos+pageWidth) && ypos>0.0)            //only draw stamps that  start on the page
         {
-        double h=drawStamp(stamp,pdfPage,qtCodec,sxpos,ypos);            //actually draw the stamp
+        double voffset=stampVerticalOffset(stamp);
+        double top=ypos-voffset;
+
+        if(stampHasText(stamp)==true)
+          {
+          QByteArray key=stampKey(stamp);
+          if(forms.repeated(key)==true)          //an identical stamp has already been laid out
+            {
+            dlist.addForm(stampForm(stamp,forms,key,pdfDoc,font,encoder),sxpos,top);
+            placed[i]=true;
+            }
+          }
+        if(placed.at(i)==false && stamp->style()!=STAMP_STYLE_BLANK)
+          layoutStampFrame(stamp,dlist,sxpos,top);
+
+        double h=stampHeight(stamp)+voffset;
         rowHeight=(rowHeight>h) ?rowHeight:h;
+
+        sxpos=sxpos+stamp->width()+stampSpace;
+        }
+      }
+
+    sxpos=rowStart;                                     //then the text inside and under the stamps
+    for(int i=0;i<m_stamps.size() ;i++)
+      {
+      CStamp *stamp=m_stamps.at(i);
+      if(sxpos<(xpos+pageWidth) && ypos>0.0)
+        {
+        if(placed.at(i)==false)
+          layoutStampText(stamp,dlist,pdfDoc,font,encoder,sxpos,ypos-stampVerticalOffset(stamp));
         sxpos=sxpos+stamp->width()+stampSpace;
         }
       }
@@ -1048,18 +1270,14 @@ double CPageStampRow::drawToPdf(HPDF_Doc pdfDoc,HPDF_Page pdfPage,bool &error,
 
 
 /************************************************************************************************/
-double CPageStampRow::drawStamp(CStamp *stamp,HPDF_Page pdfPage,QTextCodec *qtCodec,
-                                double xpos,double ypos)
+double CPageStampRow::stampVerticalOffset(CStamp *stamp)
 /* --------------------------------------------------------------------------------------------
-   DESCRIPTION: Draw a stamp
+   DESCRIPTION: Get the vertical offset of a stamp from the top of the row, which depends on
+                the row alignment
    --------------------------------------------------------------------------------------------
-    PARAMETERS:   stamp: The stamp to draw
-                pdfPage: PDF page in the document
-                qtCodec: Codec to use for the text in the stamp
-                   xpos: the horizontal position of the stamp
-                   ypos: the vertical position of the stamp
+    PARAMETERS:   stamp: The stamp
    --------------------------------------------------------------------------------------------
-       RETURNS:  double: the height of the stamp including the text below it
+       RETURNS:  double: the offset below the top of the row
    -------------------------------------------------------------------------------------------- */
 {
   double voffset=0.0;
@@ -1069,66 +1287,200 @@ double CPageStampRow::drawStamp(CStamp *stamp,HPDF_Page pdfPage,QTextCodec *qtCo
   else if(m_rowAlign==ROW_ALIGN_MIDDLE)
     voffset=(m_maxStampHeight-stamp->height())/2.0;
 
-  HPDF_Page_SetLineWidth(pdfPage,m_lineWidth);
+  return voffset;
+}
+
+
+/************************************************************************************************/
+double CPageStampRow::stampHeight(CStamp *stamp)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Get the height of a stamp including the rows of text under it
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:   stamp: The stamp
+   --------------------------------------------------------------------------------------------
+       RETURNS:  double: the height of the stamp and the text below it
+   -------------------------------------------------------------------------------------------- */
+{
+  double height=stamp->height();
+
+  if(stamp->style()!=STAMP_STYLE_BLANK)                   //text is not drawn for a blank stamp
+    {
+    if(stamp->text(3).length()>0 || stamp->text(4).length()>0 || stamp->text(5).length()>0)
+      height=height+m_fsize+2;                         //leave a 2mm space under stamp before text
+    if(stamp->text(6).length()>0 || stamp->text(7).length()>0 || stamp->text(8).length()>0)
+      height=height+m_fsize+1;                      //leave a 1mm space under previous row of text
+    }
+
+  return height;
+}
+
+
+/************************************************************************************************/
+bool CPageStampRow::stampHasText(CStamp *stamp)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Check if any text is drawn inside or under a stamp
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:   stamp: The stamp
+   --------------------------------------------------------------------------------------------
+       RETURNS:    true: the stamp has text
+                  false: only the frame of the stamp is drawn
+   -------------------------------------------------------------------------------------------- */
+{
+  if(stamp->style()==STAMP_STYLE_BLANK)
+    return false;
+
+  for(int i=0;i<9;i++)
+    {
+    if(stamp->text(i).length()>0)
+      return true;
+    }
+  return false;
+}
+
+
+/************************************************************************************************/
+QByteArray CPageStampRow::stampKey(CStamp *stamp)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Get the key identifying the appearance of a stamp, stamps with the same key
+                can share a template form
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:    stamp: The stamp
+   --------------------------------------------------------------------------------------------
+       RETURNS:  QByteArray: the key for the frame and the text of the stamp
+   -------------------------------------------------------------------------------------------- */
+{
+  QString key=QString("stamp:%1,%2,%3,%4,%5,%6").arg((int)stamp->style())
+                                                .arg(stamp->width(),0,'g',17)
+                                                .arg(stamp->height(),0,'g',17)
+                                                .arg(m_lineWidth,0,'g',17)
+                                                .arg(m_findex)
+                                                .arg(m_fsize,0,'g',17);
+  for(int i=0;i<9;i++)                                   //the strings never contain line breaks
+    key=key+"\n"+stamp->text(i);
+
+  return key.toUtf8();
+}
+
+
+/************************************************************************************************/
+int CPageStampRow::stampForm(CStamp *stamp,CFormList &forms,const QByteArray &key,HPDF_Doc pdfDoc,
+                             HPDF_Font font,const CTextEncoder *encoder)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Get the template form for a stamp, laying it out the first time that it is
+                needed. The origin of the form is the top left corner of the stamp.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:   stamp: The stamp
+                  forms: the album form list
+                    key: key of the stamp from stampKey()
+                 pdfDoc: PDF document being generated
+                   font: Font used for the text in the stamp
+                encoder: Encoder to use for the text in the stamp
+   --------------------------------------------------------------------------------------------
+       RETURNS:     int: the form id
+   -------------------------------------------------------------------------------------------- */
+{
+  int form=forms.findForm(key);
+
+  if(form<0)
+    {
+                              //the form bounding box clips its content, so allow for the stroke
+                              //and mitred corners outside the frame, and for text that is wider
+                              //than the stamp, or extends above or below it
+    double left=m_lineWidth*5.0+1.0;
+    double above=left+m_fsize*3;
+    double below=left+stampHeight(stamp)-stamp->height()+m_fsize;
+
+    CTextRuns encStr;
+    for(int i=0;i<9;i++)
+      {
+      QString str=stamp->text(i);
+      encStr.set(pdfDoc,m_findex,font,encoder,str.constData(),str.length());
+      double swidth=encStr.width(m_fsize);
+      left=(left>swidth) ? left:swidth;
+      }
+    double right=left;
+
+    double top=below+stamp->height();
+    form=forms.addForm(left+stamp->width()+right,top+above,left,top,key);
+
+    CDisplayList &fdlist=forms.displayList(form);
+    layoutStampFrame(stamp,fdlist,left,top);
+    layoutStampText(stamp,fdlist,pdfDoc,font,encoder,left,top);
+    }
+
+  return form;
+}
+
+
+/************************************************************************************************/
+void CPageStampRow::layoutStampFrame(CStamp *stamp,CDisplayList &dlist,double xpos,double top)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Lay out the outline of a stamp as a single closed shape
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:   stamp: The stamp to lay out
+                  dlist: display list receiving the outline
+                   xpos: the horizontal position of the stamp
+                    top: the vertical position of the top of the stamp
+   --------------------------------------------------------------------------------------------
+       RETURNS:  none
+   -------------------------------------------------------------------------------------------- */
+{
+  double bottom=top-stamp->height();
+  double left=xpos;
+  double right=xpos+stamp->width();
+  double hcentre=xpos+stamp->width()/2;
+  double vcentre=top-stamp->height()/2;
 
   if(stamp->style()==STAMP_STYLE_BLOCK || stamp->style()==STAMP_STYLE_BLOCKX)
     {
-    HPDF_Page_Rectangle(pdfPage,xpos,ypos-stamp->height()-voffset,stamp->width(),stamp->height());
-    HPDF_Page_Stroke (pdfPage);
+    dlist.addRect(m_lineWidth,xpos,bottom,stamp->width(),stamp->height());
     }
   else if(stamp->style()==STAMP_STYLE_TRIANGLE)
     {
-    HPDF_Page_MoveTo(pdfPage,xpos,ypos-stamp->height()-voffset);             //move to bottom left
-    HPDF_Page_LineTo(pdfPage,xpos+stamp->width()/2,ypos-voffset);             //line to centre top
-    HPDF_Page_Stroke(pdfPage);
-
-    HPDF_Page_MoveTo(pdfPage,xpos+stamp->width()/2,ypos-voffset);             //move to centre top
-                                                                            //line to bottom right
-    HPDF_Page_LineTo(pdfPage,xpos+stamp->width(),ypos-stamp->height()-voffset);
-    HPDF_Page_Stroke(pdfPage);
-                                                                           //move  to bottom right
-    HPDF_Page_MoveTo(pdfPage,xpos+stamp->width(),ypos-stamp->height()-voffset);
-    HPDF_Page_LineTo(pdfPage,xpos,ypos-stamp->height()-voffset);             //line to bottom left
-    HPDF_Page_Stroke(pdfPage);
+    const double points[]={left,bottom,                                              //bottom left
+                           hcentre,top,                                               //centre top
+                           right,bottom};                                           //bottom right
+    dlist.addPolygon(m_lineWidth,points,3);
     }
   else if(stamp->style()==STAMP_STYLE_TRIANGLE_INV)
     {
-    HPDF_Page_MoveTo(pdfPage,xpos,ypos-voffset);                                //move to top left
-                                                                           //line to centre bottom
-    HPDF_Page_LineTo(pdfPage,xpos+stamp->width()/2,ypos-stamp->height()-voffset);
-    HPDF_Page_Stroke(pdfPage);
-                                                                           //move to centre bottom
-    HPDF_Page_MoveTo(pdfPage,xpos+stamp->width()/2,ypos-stamp->height()-voffset);
-    HPDF_Page_LineTo(pdfPage,xpos+stamp->width(),ypos-voffset);                //line to top right
-    HPDF_Page_Stroke(pdfPage);
-
-    HPDF_Page_MoveTo(pdfPage,xpos+stamp->width(),ypos-voffset);            //move to top right
-    HPDF_Page_LineTo(pdfPage,xpos,ypos-voffset);                                 //line to top left
-    HPDF_Page_Stroke(pdfPage);
+    const double points[]={left,top,                                                    //top left
+                           hcentre,bottom,                                         //centre bottom
+                           right,top};                                                 //top right
+    dlist.addPolygon(m_lineWidth,points,3);
     }
   else if(stamp->style()==STAMP_STYLE_DIAMOND)
     {
-    HPDF_Page_MoveTo(pdfPage,xpos+stamp->width()/2,ypos-voffset);             //move to centre top
-    HPDF_Page_LineTo(pdfPage,xpos,ypos-stamp->height()/2-voffset);           //line to centre left
-    HPDF_Page_Stroke(pdfPage);
-
-    HPDF_Page_MoveTo(pdfPage,xpos,ypos-stamp->height()/2-voffset);           //move to centre left
-                                                                           //line to centre bottom
-    HPDF_Page_LineTo(pdfPage,xpos+stamp->width()/2,ypos-stamp->height()-voffset);
-    HPDF_Page_Stroke(pdfPage);
-                                                                          //move to centre bottom
-    HPDF_Page_MoveTo(pdfPage,xpos+stamp->width()/2,ypos-stamp->height()-voffset);
-                                                                            //line to centre right
-    HPDF_Page_LineTo(pdfPage,xpos+stamp->width(),ypos-stamp->height()/2-voffset);
-    HPDF_Page_Stroke(pdfPage);
-                                                                           //move  to centre right
-    HPDF_Page_MoveTo(pdfPage,xpos+stamp->width(),ypos-stamp->height()/2-voffset);
-    HPDF_Page_LineTo(pdfPage,xpos+stamp->width()/2,ypos-voffset);             //line to centre top
-    HPDF_Page_Stroke(pdfPage);
+    const double points[]={hcentre,top,                                               //centre top
+                           left,vcentre,                                             //centre left
+                           hcentre,bottom,                                         //centre bottom
+                           right,vcentre};                                          //centre right
+    dlist.addPolygon(m_lineWidth,points,4);
     }
+}
+
 
+/************************************************************************************************/
+void CPageStampRow::layoutStampText(CStamp *stamp,CDisplayList &dlist,HPDF_Doc pdfDoc,
+                                    HPDF_Font font,const CTextEncoder *encoder,double xpos,
+                                    double top)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Lay out the text inside and under a stamp
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:   stamp: The stamp to lay out
+                  dlist: display list receiving the text
+                 pdfDoc: PDF document being generated
+                   font: Font used for measuring the text in the stamp
+                encoder: Encoder to use for the text in the stamp
+                   xpos: the horizontal position of the stamp
+                    top: the vertical position of the top of the stamp
+   --------------------------------------------------------------------------------------------
+       RETURNS:  none
+   -------------------------------------------------------------------------------------------- */
+{
   double txtHeight=0;
-  double stampHeight=stamp->height();
+
+  double height=stamp->height();
 
   if(stamp->style()!=STAMP_STYLE_BLANK)                      //if not a blank stamp, draw the text
     {
@@ -1140,18 +1492,18 @@ double CPageStampRow::drawStamp(CStamp *stamp,HPDF_Page pdfPage,QTextCodec *qtCo
         txtRows++;
       }
                                                            //y base position for first row of text
-    double txtYpos=ypos-(stamp->height()-(txtRows*m_fsize))/2-m_fsize;
+    double txtYpos=top-(stamp->height()-(txtRows*m_fsize))/2-m_fsize;
+    CTextRuns encStr;                                        //buffers reused for each line of text
     for(int i=0;i<3;i++)
       {
       QString str=stamp->text(i);
       if(str.length()>0)
         {
-        double swidth=HPDF_Page_TextWidth(pdfPage, qtCodec->fromUnicode(str));
+        encStr.set(pdfDoc,m_findex,font,encoder,str.constData(),str.length());
+        double swidth=encStr.width(m_fsize);
         double txtXpos=xpos+(stamp->width()-swidth)/2;
 
-        HPDF_Page_BeginText(pdfPage);
-        HPDF_Page_TextOut(pdfPage, txtXpos, txtYpos-voffset, qtCodec->fromUnicode(str));
-        HPDF_Page_EndText(pdfPage);
+        dlist.addText(encStr,m_fsize,txtXpos,txtYpos);
         txtYpos=txtYpos-m_fsize;
         }
       }
@@ -1162,7 +1514,8 @@ double CPageStampRow::drawStamp(CStamp *stamp,HPDF_Page pdfPage,QTextCodec *qtCo
         {
         txtHeight=m_fsize+2;                           //leave a 2mm space under stamp before text
 
-        double swidth=HPDF_Page_TextWidth(pdfPage,qtCodec->fromUnicode(str));
+        encStr.set(pdfDoc,m_findex,font,encoder,str.constData(),str.length());
+        double swidth=encStr.width(m_fsize);
         double txtXpos;
 
         if(i==3)                                                    //left text string under stamp
@@ -1172,14 +1525,11 @@ double CPageStampRow::drawStamp(CStamp *stamp,HPDF_Page pdfPage,QTextCodec *qtCo
         else                                                       //right text string under stamp
           txtXpos=xpos+stamp->width()-swidth;
 
-        HPDF_Page_BeginText(pdfPage);
-        HPDF_Page_TextOut(pdfPage,txtXpos,
-                          ypos-stampHeight-txtHeight-voffset,qtCodec->fromUnicode(str));
-        HPDF_Page_EndText(pdfPage);
+        dlist.addText(encStr,m_fsize,txtXpos,top-height-txtHeight);
         }
       }
 
-    stampHeight=stampHeight+txtHeight;
+    height=height+txtHeight;
     txtHeight=0;
 
     for(int i=6;i<9;i++)                      //draw the second row of three items under the stamp
@@ -1188,7 +1538,9 @@ double CPageStampRow::drawStamp(CStamp *stamp,HPDF_Page pdfPage,QTextCodec *qtCo
       if(str.length()>0)
         {
         txtHeight=m_fsize+1;                        //leave a 1mm space under previous row of text
-        double swidth=HPDF_Page_TextWidth(pdfPage, qtCodec->fromUnicode(str));
+
+        encStr.set(pdfDoc,m_findex,font,encoder,str.constData(),str.length());
+        double swidth=encStr.width(m_fsize);
         double txtXpos;
 
         if(i==6)                                                    //left text string under stamp
@@ -1198,14 +1550,10 @@ double CPageStampRow::drawStamp(CStamp *stamp,HPDF_Page pdfPage,QTextCodec *qtCo
         else                                                       //right text string under stamp
           txtXpos=xpos+stamp->width()-swidth;
 
-        HPDF_Page_BeginText(pdfPage);
-        HPDF_Page_TextOut(pdfPage,txtXpos,
-                          ypos-stampHeight-txtHeight-voffset,qtCodec->fromUnicode(str));
-        HPDF_Page_EndText(pdfPage);
+        dlist.addText(encStr,m_fsize,txtXpos,top-height-txtHeight);
         }
       }
     }
-  return  stampHeight+txtHeight+voffset ;
 }
 
 
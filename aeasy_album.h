@@ -27,6 +27,9 @@
 
 
 #define DOTS_PER_MM (72.0/25.4)                                                            //72dpi
+#define PDF_PAGE_TREE_FANOUT 32                                    //max kids of each page tree node
+#define PDF_FLUSH_PAGES 16                              //pages generated between writes to the file
+#define PDF_MAX_MEMORY_BUDGET 4095                     //megabytes, Haru holds the budget in 32 bits
 
 enum ROW_STYLE
   {
@@ -43,6 +46,14 @@ enum ROW_ALIGN
   ROW_ALIGN_BOTTOM
   };
 
+enum PDF_COMPRESSION
+  {
+  PDF_COMPRESSION_NONE,                                                   //largest file, fastest
+  PDF_COMPRESSION_FAST,                                 //deflate favouring speed over file size
+  PDF_COMPRESSION_BALANCED,                                           //default deflate level
+  PDF_COMPRESSION_MAX                                   //smallest file, slowest to generate
+  };
+
 enum STAMP_STYLE
   {
   STAMP_STYLE_BLANK,
@@ -54,12 +65,22 @@ enum STAMP_STYLE
   };
 
 
+struct PAGE_MASTER                                 //layout shared by every odd or every even page
+{
+  int form;                                                    //border and title form, -1 => none
+  double top;                                  //position below the title, before the page spacing
+  double left;                                   //drawing area left edge, before the page spacing
+  double width;                                      //drawing area width, before the page spacing
+};
+
 
 class CAlbumPage;
 class CPageItem;
 class CPageStampRow;
 class CStamp;
 class CFormattedText;
+class CDisplayList;
+class CFormList;
 
 
 /************************************************************************************************
@@ -80,6 +101,10 @@ public:
   void setSpacing(double hspace,double vspace);
   void setTitle(int findex,double fsize,QString title);
   void setRowAlignment(ROW_ALIGN rowAlign);
+  void setCompression(PDF_COMPRESSION compression);
+  void setObjectStreams(bool objectStreams);
+  void setFastWebView(bool fastWebView);
+  void setMemoryBudget(int megabytes);
   bool hasPage(void);
   bool hasRow(void);
   void startNewPage(double hspace=-1.0,double vspace=-1.0);
@@ -93,7 +118,10 @@ private:
   void displayError(QString msg);
   void pageBorderRect(QRectF &borders, bool odd, bool inner);
   double pageHorizontalDrawArea(double &drawWidth,double hspace,bool odd);
-  double drawPageToPdf(CAlbumPage *page,int pageno,double ypos,HPDF_Page pdfPage,bool &error);
+  void compilePageMasters(CFormList &forms,bool &error);
+  void layoutPage(CAlbumPage *page,const PAGE_MASTER &master,CDisplayList &dlist,
+                  CFormList &forms,bool &error);
+  double layoutPageChrome(bool odd,CDisplayList &dlist,bool &error);
   double pageHorizontalCentre(bool odd);
 private:
   bool m_sizeSet;
@@ -116,9 +144,14 @@ private:
   double m_hspace;
   double m_vspace;
   ROW_ALIGN m_rowAlign;
+  PDF_COMPRESSION m_compression;
+  bool m_objectStreams;
+  bool m_fastWebView;
+  int m_memoryBudget;
 
   CFormattedText *m_title;
   HPDF_Doc m_pdfDoc;
+  PAGE_MASTER m_pageMaster[2];                                      //page layouts, [0]even [1]odd
   QList<CAlbumPage *> m_pages;
   CAlbumPage *m_activeDrawingPage;
 
@@ -193,8 +226,9 @@ class CPageItem
 public:
   CPageItem(){;};
   virtual ~CPageItem(){;};
-  virtual double drawToPdf(HPDF_Doc pdfDoc,HPDF_Page pdfPage,bool &error,double xpos,double ypos,
-                           double drawWidth,double pageWidth,double hspacing,double vspacing)=0;
+  virtual double layout(CDisplayList &dlist,CFormList &forms,HPDF_Doc pdfDoc,bool &error,
+                        double xpos,double ypos,double drawWidth,double pageWidth,
+                        double hspacing,double vspacing)=0;
 };
 
 
@@ -203,8 +237,9 @@ class CPageText: public CPageItem
 public:
   CPageText(int findex,double fsize,QString text,bool centre);
   virtual ~CPageText();
-  virtual double drawToPdf(HPDF_Doc pdfDoc,HPDF_Page pdfPage,bool &error,double xpos,double ypos,
-                           double drawWidth,double pageWidth,double hspacing,double vspacing);
+  virtual double layout(CDisplayList &dlist,CFormList &forms,HPDF_Doc pdfDoc,bool &error,
+                        double xpos,double ypos,double drawWidth,double pageWidth,
+                        double hspacing,double vspacing);
 private:
   CFormattedText *m_ftext;
 };
@@ -217,9 +252,19 @@ public:
                 ROW_ALIGN rowAlign);
   virtual ~CPageStampRow();
   void addStamp(STAMP_STYLE style,double width,double height,QString stampText[]);
-  virtual double drawToPdf(HPDF_Doc pdfDoc,HPDF_Page pdfPage,bool &error,double xpos,double ypos,
-                           double drawWidth,double pageWidth,double hspacing,double vspacing);
-  double drawStamp(CStamp *stamp,HPDF_Page pdfPage,QTextCodec *qtCodec,double xpos,double ypos);
+  virtual double layout(CDisplayList &dlist,CFormList &forms,HPDF_Doc pdfDoc,bool &error,
+                        double xpos,double ypos,double drawWidth,double pageWidth,
+                        double hspacing,double vspacing);
+private:
+  double stampVerticalOffset(CStamp *stamp);
+  double stampHeight(CStamp *stamp);
+  bool stampHasText(CStamp *stamp);
+  QByteArray stampKey(CStamp *stamp);
+  int stampForm(CStamp *stamp,CFormList &forms,const QByteArray &key,HPDF_Doc pdfDoc,
+                HPDF_Font font,const CTextEncoder *encoder);
+  void layoutStampFrame(CStamp *stamp,CDisplayList &dlist,double xpos,double top);
+  void layoutStampText(CStamp *stamp,CDisplayList &dlist,HPDF_Doc pdfDoc,HPDF_Font font,
+                       const CTextEncoder *encoder,double xpos,double top);
 private:
   int m_findex;
   double m_fsize;
@@ -0,0 +1,440 @@
+/* --------------------------------------------------------------------------------------------
+ *              aeasy_codepages.h
+ * --------------------------------------------------------------------------------------------
+ * DESCRIPTION: Tables for the Windows CP1250 to CP1258 code pages used by CTextEncoder.
+ *              For each code page, the Unicode characters of the bytes 0x80 to 0xFF (0 =>
+ *              undefined), and the reverse map from those characters back to the bytes,
+ *              sorted by character. The bytes 0x00 to 0x7F are ASCII in all of the code pages.
+ *              The tables were generated from the code page mappings published by Microsoft.
+ * --------------------------------------------------------------------------------------------
+ * COPYRIGHT:   Copyright (c) 2005-2013
+ *              Clive Levinson <clivel@bundu.com>
+ *              Bundu Technology Ltd.
+ * --------------------------------------------------------------------------------------------
+ * LICENCE:     AlbumEasy is free software: you can redistribute it and/or modify it under
+ *              the terms of the GNU General Public License as published by the
+ *              Free Software Foundation, either version 3 of the License, or (at your option)
+ *              any later version.
+ * --------------------------------------------------------------------------------------------
+ * AUTHORS:     Clive Levinson
+ * --------------------------------------------------------------------------------------------
+ * REFERENCES:  https://www.unicode.org/Public/MAPPINGS/VENDORS/MICSFT/WINDOWS/
+ * --------------------------------------------------------------------------------------------
+ * REVISIONS:   Date          Version   Who    Comment
+ *
+ *              2011/04/26    3.0       cl     First QT Version
+ * -------------------------------------------------------------------------------------------- */
+
+#ifndef _AEASY_CODEPAGES_H_
+#define _AEASY_CODEPAGES_H_
+
+
+struct CODEPAGE_REVERSE
+{
+  quint16 unicode;
+  quint8 byte;
+};
+
+
+static const quint16 cp1250Upper[128]=
+{
+  0x20AC,0x0000,0x201A,0x0000,0x201E,0x2026,0x2020,0x2021,
+  0x0000,0x2030,0x0160,0x2039,0x015A,0x0164,0x017D,0x0179,
+  0x0000,0x2018,0x2019,0x201C,0x201D,0x2022,0x2013,0x2014,
+  0x0000,0x2122,0x0161,0x203A,0x015B,0x0165,0x017E,0x017A,
+  0x00A0,0x02C7,0x02D8,0x0141,0x00A4,0x0104,0x00A6,0x00A7,
+  0x00A8,0x00A9,0x015E,0x00AB,0x00AC,0x00AD,0x00AE,0x017B,
+  0x00B0,0x00B1,0x02DB,0x0142,0x00B4,0x00B5,0x00B6,0x00B7,
+  0x00B8,0x0105,0x015F,0x00BB,0x013D,0x02DD,0x013E,0x017C,
+  0x0154,0x00C1,0x00C2,0x0102,0x00C4,0x0139,0x0106,0x00C7,
+  0x010C,0x00C9,0x0118,0x00CB,0x011A,0x00CD,0x00CE,0x010E,
+  0x0110,0x0143,0x0147,0x00D3,0x00D4,0x0150,0x00D6,0x00D7,
+  0x0158,0x016E,0x00DA,0x0170,0x00DC,0x00DD,0x0162,0x00DF,
+  0x0155,0x00E1,0x00E2,0x0103,0x00E4,0x013A,0x0107,0x00E7,
+  0x010D,0x00E9,0x0119,0x00EB,0x011B,0x00ED,0x00EE,0x010F,
+  0x0111,0x0144,0x0148,0x00F3,0x00F4,0x0151,0x00F6,0x00F7,
+  0x0159,0x016F,0x00FA,0x0171,0x00FC,0x00FD,0x0163,0x02D9
+};
+
+static const CODEPAGE_REVERSE cp1250Reverse[]=
+{
+  {0x00A0,0xA0},{0x00A4,0xA4},{0x00A6,0xA6},{0x00A7,0xA7},{0x00A8,0xA8},{0x00A9,0xA9},
+  {0x00AB,0xAB},{0x00AC,0xAC},{0x00AD,0xAD},{0x00AE,0xAE},{0x00B0,0xB0},{0x00B1,0xB1},
+  {0x00B4,0xB4},{0x00B5,0xB5},{0x00B6,0xB6},{0x00B7,0xB7},{0x00B8,0xB8},{0x00BB,0xBB},
+  {0x00C1,0xC1},{0x00C2,0xC2},{0x00C4,0xC4},{0x00C7,0xC7},{0x00C9,0xC9},{0x00CB,0xCB},
+  {0x00CD,0xCD},{0x00CE,0xCE},{0x00D3,0xD3},{0x00D4,0xD4},{0x00D6,0xD6},{0x00D7,0xD7},
+  {0x00DA,0xDA},{0x00DC,0xDC},{0x00DD,0xDD},{0x00DF,0xDF},{0x00E1,0xE1},{0x00E2,0xE2},
+  {0x00E4,0xE4},{0x00E7,0xE7},{0x00E9,0xE9},{0x00EB,0xEB},{0x00ED,0xED},{0x00EE,0xEE},
+  {0x00F3,0xF3},{0x00F4,0xF4},{0x00F6,0xF6},{0x00F7,0xF7},{0x00FA,0xFA},{0x00FC,0xFC},
+  {0x00FD,0xFD},{0x0102,0xC3},{0x0103,0xE3},{0x0104,0xA5},{0x0105,0xB9},{0x0106,0xC6},
+  {0x0107,0xE6},{0x010C,0xC8},{0x010D,0xE8},{0x010E,0xCF},{0x010F,0xEF},{0x0110,0xD0},
+  {0x0111,0xF0},{0x0118,0xCA},{0x0119,0xEA},{0x011A,0xCC},{0x011B,0xEC},{0x0139,0xC5},
+  {0x013A,0xE5},{0x013D,0xBC},{0x013E,0xBE},{0x0141,0xA3},{0x0142,0xB3},{0x0143,0xD1},
+  {0x0144,0xF1},{0x0147,0xD2},{0x0148,0xF2},{0x0150,0xD5},{0x0151,0xF5},{0x0154,0xC0},
+  {0x0155,0xE0},{0x0158,0xD8},{0x0159,0xF8},{0x015A,0x8C},{0x015B,0x9C},{0x015E,0xAA},
+  {0x015F,0xBA},{0x0160,0x8A},{0x0161,0x9A},{0x0162,0xDE},{0x0163,0xFE},{0x0164,0x8D},
+  {0x0165,0x9D},{0x016E,0xD9},{0x016F,0xF9},{0x0170,0xDB},{0x0171,0xFB},{0x0179,0x8F},
+  {0x017A,0x9F},{0x017B,0xAF},{0x017C,0xBF},{0x017D,0x8E},{0x017E,0x9E},{0x02C7,0xA1},
+  {0x02D8,0xA2},{0x02D9,0xFF},{0x02DB,0xB2},{0x02DD,0xBD},{0x2013,0x96},{0x2014,0x97},
+  {0x2018,0x91},{0x2019,0x92},{0x201A,0x82},{0x201C,0x93},{0x201D,0x94},{0x201E,0x84},
+  {0x2020,0x86},{0x2021,0x87},{0x2022,0x95},{0x2026,0x85},{0x2030,0x89},{0x2039,0x8B},
+  {0x203A,0x9B},{0x20AC,0x80},{0x2122,0x99}
+};
+
+static const quint16 cp1251Upper[128]=
+{
+  0x0402,0x0403,0x201A,0x0453,0x201E,0x2026,0x2020,0x2021,
+  0x20AC,0x2030,0x0409,0x2039,0x040A,0x040C,0x040B,0x040F,
+  0x0452,0x2018,0x2019,0x201C,0x201D,0x2022,0x2013,0x2014,
+  0x0000,0x2122,0x0459,0x203A,0x045A,0x045C,0x045B,0x045F,
+  0x00A0,0x040E,0x045E,0x0408,0x00A4,0x0490,0x00A6,0x00A7,
+  0x0401,0x00A9,0x0404,0x00AB,0x00AC,0x00AD,0x00AE,0x0407,
+  0x00B0,0x00B1,0x0406,0x0456,0x0491,0x00B5,0x00B6,0x00B7,
+  0x0451,0x2116,0x0454,0x00BB,0x0458,0x0405,0x0455,0x0457,
+  0x0410,0x0411,0x0412,0x0413,0x0414,0x0415,0x0416,0x0417,
+  0x0418,0x0419,0x041A,0x041B,0x041C,0x041D,0x041E,0x041F,
+  0x0420,0x0421,0x0422,0x0423,0x0424,0x0425,0x0426,0x0427,
+  0x0428,0x0429,0x042A,0x042B,0x042C,0x042D,0x042E,0x042F,
+  0x0430,0x0431,0x0432,0x0433,0x0434,0x0435,0x0436,0x0437,
+  0x0438,0x0439,0x043A,0x043B,0x043C,0x043D,0x043E,0x043F,
+  0x0440,0x0441,0x0442,0x0443,0x0444,0x0445,0x0446,0x0447,
+  0x0448,0x0449,0x044A,0x044B,0x044C,0x044D,0x044E,0x044F
+};
+
+static const CODEPAGE_REVERSE cp1251Reverse[]=
+{
+  {0x00A0,0xA0},{0x00A4,0xA4},{0x00A6,0xA6},{0x00A7,0xA7},{0x00A9,0xA9},{0x00AB,0xAB},
+  {0x00AC,0xAC},{0x00AD,0xAD},{0x00AE,0xAE},{0x00B0,0xB0},{0x00B1,0xB1},{0x00B5,0xB5},
+  {0x00B6,0xB6},{0x00B7,0xB7},{0x00BB,0xBB},{0x0401,0xA8},{0x0402,0x80},{0x0403,0x81},
+  {0x0404,0xAA},{0x0405,0xBD},{0x0406,0xB2},{0x0407,0xAF},{0x0408,0xA3},{0x0409,0x8A},
+  {0x040A,0x8C},{0x040B,0x8E},{0x040C,0x8D},{0x040E,0xA1},{0x040F,0x8F},{0x0410,0xC0},
+  {0x0411,0xC1},{0x0412,0xC2},{0x0413,0xC3},{0x0414,0xC4},{0x0415,0xC5},{0x0416,0xC6},
+  {0x0417,0xC7},{0x0418,0xC8},{0x0419,0xC9},{0x041A,0xCA},{0x041B,0xCB},{0x041C,0xCC},
+  {0x041D,0xCD},{0x041E,0xCE},{0x041F,0xCF},{0x0420,0xD0},{0x0421,0xD1},{0x0422,0xD2},
+  {0x0423,0xD3},{0x0424,0xD4},{0x0425,0xD5},{0x0426,0xD6},{0x0427,0xD7},{0x0428,0xD8},
+  {0x0429,0xD9},{0x042A,0xDA},{0x042B,0xDB},{0x042C,0xDC},{0x042D,0xDD},{0x042E,0xDE},
+  {0x042F,0xDF},{0x0430,0xE0},{0x0431,0xE1},{0x0432,0xE2},{0x0433,0xE3},{0x0434,0xE4},
+  {0x0435,0xE5},{0x0436,0xE6},{0x0437,0xE7},{0x0438,0xE8},{0x0439,0xE9},{0x043A,0xEA},
+  {0x043B,0xEB},{0x043C,0xEC},{0x043D,0xED},{0x043E,0xEE},{0x043F,0xEF},{0x0440,0xF0},
+  {0x0441,0xF1},{0x0442,0xF2},{0x0443,0xF3},{0x0444,0xF4},{0x0445,0xF5},{0x0446,0xF6},
+  {0x0447,0xF7},{0x0448,0xF8},{0x0449,0xF9},{0x044A,0xFA},{0x044B,0xFB},{0x044C,0xFC},
+  {0x044D,0xFD},{0x044E,0xFE},{0x044F,0xFF},{0x0451,0xB8},{0x0452,0x90},{0x0453,0x83},
+  {0x0454,0xBA},{0x0455,0xBE},{0x0456,0xB3},{0x0457,0xBF},{0x0458,0xBC},{0x0459,0x9A},
+  {0x045A,0x9C},{0x045B,0x9E},{0x045C,0x9D},{0x045E,0xA2},{0x045F,0x9F},{0x0490,0xA5},
+  {0x0491,0xB4},{0x2013,0x96},{0x2014,0x97},{0x2018,0x91},{0x2019,0x92},{0x201A,0x82},
+  {0x201C,0x93},{0x201D,0x94},{0x201E,0x84},{0x2020,0x86},{0x2021,0x87},{0x2022,0x95},
+  {0x2026,0x85},{0x2030,0x89},{0x2039,0x8B},{0x203A,0x9B},{0x20AC,0x88},{0x2116,0xB9},
+  {0x2122,0x99}
+};
+
+static const quint16 cp1252Upper[128]=
+{
+  0x20AC,0x0000,0x201A,0x0192,0x201E,0x2026,0x2020,0x2021,
+  0x02C6,0x2030,0x0160,0x2039,0x0152,0x0000,0x017D,0x0000,
+  0x0000,0x2018,0x2019,0x201C,0x201D,0x2022,0x2013,0x2014,
+  0x02DC,0x2122,0x0161,0x203A,0x0153,0x0000,0x017E,0x0178,
+  0x00A0,0x00A1,0x00A2,0x00A3,0x00A4,0x00A5,0x00A6,0x00A7,
+  0x00A8,0x00A9,0x00AA,0x00AB,0x00AC,0x00AD,0x00AE,0x00AF,
+  0x00B0,0x00B1,0x00B2,0x00B3,0x00B4,0x00B5,0x00B6,0x00B7,
+  0x00B8,0x00B9,0x00BA,0x00BB,0x00BC,0x00BD,0x00BE,0x00BF,
+  0x00C0,0x00C1,0x00C2,0x00C3,0x00C4,0x00C5,0x00C6,0x00C7,
+  0x00C8,0x00C9,0x00CA,0x00CB,0x00CC,0x00CD,0x00CE,0x00CF,
+  0x00D0,0x00D1,0x00D2,0x00D3,0x00D4,0x00D5,0x00D6,0x00D7,
+  0x00D8,0x00D9,0x00DA,0x00DB,0x00DC,0x00DD,0x00DE,0x00DF,
+  0x00E0,0x00E1,0x00E2,0x00E3,0x00E4,0x00E5,0x00E6,0x00E7,
+  0x00E8,0x00E9,0x00EA,0x00EB,0x00EC,0x00ED,0x00EE,0x00EF,
+  0x00F0,0x00F1,0x00F2,0x00F3,0x00F4,0x00F5,0x00F6,0x00F7,
+  0x00F8,0x00F9,0x00FA,0x00FB,0x00FC,0x00FD,0x00FE,0x00FF
+};
+
+static const CODEPAGE_REVERSE cp1252Reverse[]=
+{
+  {0x00A0,0xA0},{0x00A1,0xA1},{0x00A2,0xA2},{0x00A3,0xA3},{0x00A4,0xA4},{0x00A5,0xA5},
+  {0x00A6,0xA6},{0x00A7,0xA7},{0x00A8,0xA8},{0x00A9,0xA9},{0x00AA,0xAA},{0x00AB,0xAB},
+  {0x00AC,0xAC},{0x00AD,0xAD},{0x00AE,0xAE},{0x00AF,0xAF},{0x00B0,0xB0},{0x00B1,0xB1},
+  {0x00B2,0xB2},{0x00B3,0xB3},{0x00B4,0xB4},{0x00B5,0xB5},{0x00B6,0xB6},{0x00B7,0xB7},
+  {0x00B8,0xB8},{0x00B9,0xB9},{0x00BA,0xBA},{0x00BB,0xBB},{0x00BC,0xBC},{0x00BD,0xBD},
+  {0x00BE,0xBE},{0x00BF,0xBF},{0x00C0,0xC0},{0x00C1,0xC1},{0x00C2,0xC2},{0x00C3,0xC3},
+  {0x00C4,0xC4},{0x00C5,0xC5},{0x00C6,0xC6},{0x00C7,0xC7},{0x00C8,0xC8},{0x00C9,0xC9},
+  {0x00CA,0xCA},{0x00CB,0xCB},{0x00CC,0xCC},{0x00CD,0xCD},{0x00CE,0xCE},{0x00CF,0xCF},
+  {0x00D0,0xD0},{0x00D1,0xD1},{0x00D2,0xD2},{0x00D3,0xD3},{0x00D4,0xD4},{0x00D5,0xD5},
+  {0x00D6,0xD6},{0x00D7,0xD7},{0x00D8,0xD8},{0x00D9,0xD9},{0x00DA,0xDA},{0x00DB,0xDB},
+  {0x00DC,0xDC},{0x00DD,0xDD},{0x00DE,0xDE},{0x00DF,0xDF},{0x00E0,0xE0},{0x00E1,0xE1},
+  {0x00E2,0xE2},{0x00E3,0xE3},{0x00E4,0xE4},{0x00E5,0xE5},{0x00E6,0xE6},{0x00E7,0xE7},
+  {0x00E8,0xE8},{0x00E9,0xE9},{0x00EA,0xEA},{0x00EB,0xEB},{0x00EC,0xEC},{0x00ED,0xED},
+  {0x00EE,0xEE},{0x00EF,0xEF},{0x00F0,0xF0},{0x00F1,0xF1},{0x00F2,0xF2},{0x00F3,0xF3},
+  {0x00F4,0xF4},{0x00F5,0xF5},{0x00F6,0xF6},{0x00F7,0xF7},{0x00F8,0xF8},{0x00F9,0xF9},
+  {0x00FA,0xFA},{0x00FB,0xFB},{0x00FC,0xFC},{0x00FD,0xFD},{0x00FE,0xFE},{0x00FF,0xFF},
+  {0x0152,0x8C},{0x0153,0x9C},{0x0160,0x8A},{0x0161,0x9A},{0x0178,0x9F},{0x017D,0x8E},
+  {0x017E,0x9E},{0x0192,0x83},{0x02C6,0x88},{0x02DC,0x98},{0x2013,0x96},{0x2014,0x97},
+  {0x2018,0x91},{0x2019,0x92},{0x201A,0x82},{0x201C,0x93},{0x201D,0x94},{0x201E,0x84},
+  {0x2020,0x86},{0x2021,0x87},{0x2022,0x95},{0x2026,0x85},{0x2030,0x89},{0x2039,0x8B},
+  {0x203A,0x9B},{0x20AC,0x80},{0x2122,0x99}
+};
+
+static const quint16 cp1253Upper[128]=
+{
+  0x20AC,0x0000,0x201A,0x0192,0x201E,0x2026,0x2020,0x2021,
+  0x0000,0x2030,0x0000,0x2039,0x0000,0x0000,0x0000,0x0000,
+  0x0000,0x2018,0x2019,0x201C,0x201D,0x2022,0x2013,0x2014,
+  0x0000,0x2122,0x0000,0x203A,0x0000,0x0000,0x0000,0x0000,
+  0x00A0,0x0385,0x0386,0x00A3,0x00A4,0x00A5,0x00A6,0x00A7,
+  0x00A8,0x00A9,0x0000,0x00AB,0x00AC,0x00AD,0x00AE,0x2015,
+  0x00B0,0x00B1,0x00B2,0x00B3,0x0384,0x00B5,0x00B6,0x00B7,
+  0x0388,0x0389,0x038A,0x00BB,0x038C,0x00BD,0x038E,0x038F,
+  0x0390,0x0391,0x0392,0x0393,0x0394,0x0395,0x0396,0x0397,
+  0x0398,0x0399,0x039A,0x039B,0x039C,0x039D,0x039E,0x039F,
+  0x03A0,0x03A1,0x0000,0x03A3,0x03A4,0x03A5,0x03A6,0x03A7,
+  0x03A8,0x03A9,0x03AA,0x03AB,0x03AC,0x03AD,0x03AE,0x03AF,
+  0x03B0,0x03B1,0x03B2,0x03B3,0x03B4,0x03B5,0x03B6,0x03B7,
+  0x03B8,0x03B9,0x03BA,0x03BB,0x03BC,0x03BD,0x03BE,0x03BF,
+  0x03C0,0x03C1,0x03C2,0x03C3,0x03C4,0x03C5,0x03C6,0x03C7,
+  0x03C8,0x03C9,0x03CA,0x03CB,0x03CC,0x03CD,0x03CE,0x0000
+};
+
+static const CODEPAGE_REVERSE cp1253Reverse[]=
+{
+  {0x00A0,0xA0},{0x00A3,0xA3},{0x00A4,0xA4},{0x00A5,0xA5},{0x00A6,0xA6},{0x00A7,0xA7},
+  {0x00A8,0xA8},{0x00A9,0xA9},{0x00AB,0xAB},{0x00AC,0xAC},{0x00AD,0xAD},{0x00AE,0xAE},
+  {0x00B0,0xB0},{0x00B1,0xB1},{0x00B2,0xB2},{0x00B3,0xB3},{0x00B5,0xB5},{0x00B6,0xB6},
+  {0x00B7,0xB7},{0x00BB,0xBB},{0x00BD,0xBD},{0x0192,0x83},{0x0384,0xB4},{0x0385,0xA1},
+  {0x0386,0xA2},{0x0388,0xB8},{0x0389,0xB9},{0x038A,0xBA},{0x038C,0xBC},{0x038E,0xBE},
+  {0x038F,0xBF},{0x0390,0xC0},{0x0391,0xC1},{0x0392,0xC2},{0x0393,0xC3},{0x0394,0xC4},
+  {0x0395,0xC5},{0x0396,0xC6},{0x0397,0xC7},{0x0398,0xC8},{0x0399,0xC9},{0x039A,0xCA},
+  {0x039B,0xCB},{0x039C,0xCC},{0x039D,0xCD},{0x039E,0xCE},{0x039F,0xCF},{0x03A0,0xD0},
+  {0x03A1,0xD1},{0x03A3,0xD3},{0x03A4,0xD4},{0x03A5,0xD5},{0x03A6,0xD6},{0x03A7,0xD7},
+  {0x03A8,0xD8},{0x03A9,0xD9},{0x03AA,0xDA},{0x03AB,0xDB},{0x03AC,0xDC},{0x03AD,0xDD},
+  {0x03AE,0xDE},{0x03AF,0xDF},{0x03B0,0xE0},{0x03B1,0xE1},{0x03B2,0xE2},{0x03B3,0xE3},
+  {0x03B4,0xE4},{0x03B5,0xE5},{0x03B6,0xE6},{0x03B7,0xE7},{0x03B8,0xE8},{0x03B9,0xE9},
+  {0x03BA,0xEA},{0x03BB,0xEB},{0x03BC,0xEC},{0x03BD,0xED},{0x03BE,0xEE},{0x03BF,0xEF},
+  {0x03C0,0xF0},{0x03C1,0xF1},{0x03C2,0xF2},{0x03C3,0xF3},{0x03C4,0xF4},{0x03C5,0xF5},
+  {0x03C6,0xF6},{0x03C7,0xF7},{0x03C8,0xF8},{0x03C9,0xF9},{0x03CA,0xFA},{0x03CB,0xFB},
+  {0x03CC,0xFC},{0x03CD,0xFD},{0x03CE,0xFE},{0x2013,0x96},{0x2014,0x97},{0x2015,0xAF},
+  {0x2018,0x91},{0x2019,0x92},{0x201A,0x82},{0x201C,0x93},{0x201D,0x94},{0x201E,0x84},
+  {0x2020,0x86},{0x2021,0x87},{0x2022,0x95},{0x2026,0x85},{0x2030,0x89},{0x2039,0x8B},
+  {0x203A,0x9B},{0x20AC,0x80},{0x2122,0x99}
+};
+
+static const quint16 cp1254Upper[128]=
+{
+  0x20AC,0x0000,0x201A,0x0192,0x201E,0x2026,0x2020,0x2021,
+  0x02C6,0x2030,0x0160,0x2039,0x0152,0x0000,0x0000,0x0000,
+  0x0000,0x2018,0x2019,0x201C,0x201D,0x2022,0x2013,0x2014,
+  0x02DC,0x2122,0x0161,0x203A,0x0153,0x0000,0x0000,0x0178,
+  0x00A0,0x00A1,0x00A2,0x00A3,0x00A4,0x00A5,0x00A6,0x00A7,
+  0x00A8,0x00A9,0x00AA,0x00AB,0x00AC,0x00AD,0x00AE,0x00AF,
+  0x00B0,0x00B1,0x00B2,0x00B3,0x00B4,0x00B5,0x00B6,0x00B7,
+  0x00B8,0x00B9,0x00BA,0x00BB,0x00BC,0x00BD,0x00BE,0x00BF,
+  0x00C0,0x00C1,0x00C2,0x00C3,0x00C4,0x00C5,0x00C6,0x00C7,
+  0x00C8,0x00C9,0x00CA,0x00CB,0x00CC,0x00CD,0x00CE,0x00CF,
+  0x011E,0x00D1,0x00D2,0x00D3,0x00D4,0x00D5,0x00D6,0x00D7,
+  0x00D8,0x00D9,0x00DA,0x00DB,0x00DC,0x0130,0x015E,0x00DF,
+  0x00E0,0x00E1,0x00E2,0x00E3,0x00E4,0x00E5,0x00E6,0x00E7,
+  0x00E8,0x00E9,0x00EA,0x00EB,0x00EC,0x00ED,0x00EE,0x00EF,
+  0x011F,0x00F1,0x00F2,0x00F3,0x00F4,0x00F5,0x00F6,0x00F7,
+  0x00F8,0x00F9,0x00FA,0x00FB,0x00FC,0x0131,0x015F,0x00FF
+};
+
+static const CODEPAGE_REVERSE cp1254Reverse[]=
+{
+  {0x00A0,0xA0},{0x00A1,0xA1},{0x00A2,0xA2},{0x00A3,0xA3},{0x00A4,0xA4},{0x00A5,0xA5},
+  {0x00A6,0xA6},{0x00A7,0xA7},{0x00A8,0xA8},{0x00A9,0xA9},{0x00AA,0xAA},{0x00AB,0xAB},
+  {0x00AC,0xAC},{0x00AD,0xAD},{0x00AE,0xAE},{0x00AF,0xAF},{0x00B0,0xB0},{0x00B1,0xB1},
+  {0x00B2,0xB2},{0x00B3,0xB3},{0x00B4,0xB4},{0x00B5,0xB5},{0x00B6,0xB6},{0x00B7,0xB7},
+  {0x00B8,0xB8},{0x00B9,0xB9},{0x00BA,0xBA},{0x00BB,0xBB},{0x00BC,0xBC},{0x00BD,0xBD},
+  {0x00BE,0xBE},{0x00BF,0xBF},{0x00C0,0xC0},{0x00C1,0xC1},{0x00C2,0xC2},{0x00C3,0xC3},
+  {0x00C4,0xC4},{0x00C5,0xC5},{0x00C6,0xC6},{0x00C7,0xC7},{0x00C8,0xC8},{0x00C9,0xC9},
+  {0x00CA,0xCA},{0x00CB,0xCB},{0x00CC,0xCC},{0x00CD,0xCD},{0x00CE,0xCE},{0x00CF,0xCF},
+  {0x00D1,0xD1},{0x00D2,0xD2},{0x00D3,0xD3},{0x00D4,0xD4},{0x00D5,0xD5},{0x00D6,0xD6},
+  {0x00D7,0xD7},{0x00D8,0xD8},{0x00D9,0xD9},{0x00DA,0xDA},{0x00DB,0xDB},{0x00DC,0xDC},
+  {0x00DF,0xDF},{0x00E0,0xE0},{0x00E1,0xE1},{0x00E2,0xE2},{0x00E3,0xE3},{0x00E4,0xE4},
+  {0x00E5,0xE5},{0x00E6,0xE6},{0x00E7,0xE7},{0x00E8,0xE8},{0x00E9,0xE9},{0x00EA,0xEA},
+  {0x00EB,0xEB},{0x00EC,0xEC},{0x00ED,0xED},{0x00EE,0xEE},{0x00EF,0xEF},{0x00F1,0xF1},
+  {0x00F2,0xF2},{0x00F3,0xF3},{0x00F4,0xF4},{0x00F5,0xF5},{0x00F6,0xF6},{0x00F7,0xF7},
+  {0x00F8,0xF8},{0x00F9,0xF9},{0x00FA,0xFA},{0x00FB,0xFB},{0x00FC,0xFC},{0x00FF,0xFF},
+  {0x011E,0xD0},{0x011F,0xF0},{0x0130,0xDD},{0x0131,0xFD},{0x0152,0x8C},{0x0153,0x9C},
+  {0x015E,0xDE},{0x015F,0xFE},{0x0160,0x8A},{0x0161,0x9A},{0x0178,0x9F},{0x0192,0x83},
+  {0x02C6,0x88},{0x02DC,0x98},{0x2013,0x96},{0x2014,0x97},{0x2018,0x91},{0x2019,0x92},
+  {0x201A,0x82},{0x201C,0x93},{0x201D,0x94},{0x201E,0x84},{0x2020,0x86},{0x2021,0x87},
+  {0x2022,0x95},{0x2026,0x85},{0x2030,0x89},{0x2039,0x8B},{0x203A,0x9B},{0x20AC,0x80},
+  {0x2122,0x99}
+};
+
+static const quint16 cp1255Upper[128]=
+{
+  0x20AC,0x0000,0x201A,0x0192,0x201E,0x2026,0x2020,0x2021,
+  0x02C6,0x2030,0x0000,0x2039,0x0000,0x0000,0x0000,0x0000,
+  0x0000,0x2018,0x2019,0x201C,0x201D,0x2022,0x2013,0x2014,
+  0x02DC,0x2122,0x0000,0x203A,0x0000,0x0000,0x0000,0x0000,
+  0x00A0,0x00A1,0x00A2,0x00A3,0x20AA,0x00A5,0x00A6,0x00A7,
+  0x00A8,0x00A9,0x00D7,0x00AB,0x00AC,0x00AD,0x00AE,0x00AF,
+  0x00B0,0x00B1,0x00B2,0x00B3,0x00B4,0x00B5,0x00B6,0x00B7,
+  0x00B8,0x00B9,0x00F7,0x00BB,0x00BC,0x00BD,0x00BE,0x00BF,
+  0x05B0,0x05B1,0x05B2,0x05B3,0x05B4,0x05B5,0x05B6,0x05B7,
+  0x05B8,0x05B9,0x0000,0x05BB,0x05BC,0x05BD,0x05BE,0x05BF,
+  0x05C0,0x05C1,0x05C2,0x05C3,0x05F0,0x05F1,0x05F2,0x05F3,
+  0x05F4,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,
+  0x05D0,0x05D1,0x05D2,0x05D3,0x05D4,0x05D5,0x05D6,0x05D7,
+  0x05D8,0x05D9,0x05DA,0x05DB,0x05DC,0x05DD,0x05DE,0x05DF,
+  0x05E0,0x05E1,0x05E2,0x05E3,0x05E4,0x05E5,0x05E6,0x05E7,
+  0x05E8,0x05E9,0x05EA,0x0000,0x0000,0x200E,0x200F,0x0000
+};
+
+static const CODEPAGE_REVERSE cp1255Reverse[]=
+{
+  {0x00A0,0xA0},{0x00A1,0xA1},{0x00A2,0xA2},{0x00A3,0xA3},{0x00A5,0xA5},{0x00A6,0xA6},
+  {0x00A7,0xA7},{0x00A8,0xA8},{0x00A9,0xA9},{0x00AB,0xAB},{0x00AC,0xAC},{0x00AD,0xAD},
+  {0x00AE,0xAE},{0x00AF,0xAF},{0x00B0,0xB0},{0x00B1,0xB1},{0x00B2,0xB2},{0x00B3,0xB3},
+  {0x00B4,0xB4},{0x00B5,0xB5},{0x00B6,0xB6},{0x00B7,0xB7},{0x00B8,0xB8},{0x00B9,0xB9},
+  {0x00BB,0xBB},{0x00BC,0xBC},{0x00BD,0xBD},{0x00BE,0xBE},{0x00BF,0xBF},{0x00D7,0xAA},
+  {0x00F7,0xBA},{0x0192,0x83},{0x02C6,0x88},{0x02DC,0x98},{0x05B0,0xC0},{0x05B1,0xC1},
+  {0x05B2,0xC2},{0x05B3,0xC3},{0x05B4,0xC4},{0x05B5,0xC5},{0x05B6,0xC6},{0x05B7,0xC7},
+  {0x05B8,0xC8},{0x05B9,0xC9},{0x05BB,0xCB},{0x05BC,0xCC},{0x05BD,0xCD},{0x05BE,0xCE},
+  {0x05BF,0xCF},{0x05C0,0xD0},{0x05C1,0xD1},{0x05C2,0xD2},{0x05C3,0xD3},{0x05D0,0xE0},
+  {0x05D1,0xE1},{0x05D2,0xE2},{0x05D3,0xE3},{0x05D4,0xE4},{0x05D5,0xE5},{0x05D6,0xE6},
+  {0x05D7,0xE7},{0x05D8,0xE8},{0x05D9,0xE9},{0x05DA,0xEA},{0x05DB,0xEB},{0x05DC,0xEC},
+  {0x05DD,0xED},{0x05DE,0xEE},{0x05DF,0xEF},{0x05E0,0xF0},{0x05E1,0xF1},{0x05E2,0xF2},
+  {0x05E3,0xF3},{0x05E4,0xF4},{0x05E5,0xF5},{0x05E6,0xF6},{0x05E7,0xF7},{0x05E8,0xF8},
+  {0x05E9,0xF9},{0x05EA,0xFA},{0x05F0,0xD4},{0x05F1,0xD5},{0x05F2,0xD6},{0x05F3,0xD7},
+  {0x05F4,0xD8},{0x200E,0xFD},{0x200F,0xFE},{0x2013,0x96},{0x2014,0x97},{0x2018,0x91},
+  {0x2019,0x92},{0x201A,0x82},{0x201C,0x93},{0x201D,0x94},{0x201E,0x84},{0x2020,0x86},
+  {0x2021,0x87},{0x2022,0x95},{0x2026,0x85},{0x2030,0x89},{0x2039,0x8B},{0x203A,0x9B},
+  {0x20AA,0xA4},{0x20AC,0x80},{0x2122,0x99}
+};
+
+static const quint16 cp1256Upper[128]=
+{
+  0x20AC,0x067E,0x201A,0x0192,0x201E,0x2026,0x2020,0x2021,
+  0x02C6,0x2030,0x0679,0x2039,0x0152,0x0686,0x0698,0x0688,
+  0x06AF,0x2018,0x2019,0x201C,0x201D,0x2022,0x2013,0x2014,
+  0x06A9,0x2122,0x0691,0x203A,0x0153,0x200C,0x200D,0x06BA,
+  0x00A0,0x060C,0x00A2,0x00A3,0x00A4,0x00A5,0x00A6,0x00A7,
+  0x00A8,0x00A9,0x06BE,0x00AB,0x00AC,0x00AD,0x00AE,0x00AF,
+  0x00B0,0x00B1,0x00B2,0x00B3,0x00B4,0x00B5,0x00B6,0x00B7,
+  0x00B8,0x00B9,0x061B,0x00BB,0x00BC,0x00BD,0x00BE,0x061F,
+  0x06C1,0x0621,0x0622,0x0623,0x0624,0x0625,0x0626,0x0627,
+  0x0628,0x0629,0x062A,0x062B,0x062C,0x062D,0x062E,0x062F,
+  0x0630,0x0631,0x0632,0x0633,0x0634,0x0635,0x0636,0x00D7,
+  0x0637,0x0638,0x0639,0x063A,0x0640,0x0641,0x0642,0x0643,
+  0x00E0,0x0644,0x00E2,0x0645,0x0646,0x0647,0x0648,0x00E7,
+  0x00E8,0x00E9,0x00EA,0x00EB,0x0649,0x064A,0x00EE,0x00EF,
+  0x064B,0x064C,0x064D,0x064E,0x00F4,0x064F,0x0650,0x00F7,
+  0x0651,0x00F9,0x0652,0x00FB,0x00FC,0x200E,0x200F,0x06D2
+};
+
+static const CODEPAGE_REVERSE cp1256Reverse[]=
+{
+  {0x00A0,0xA0},{0x00A2,0xA2},{0x00A3,0xA3},{0x00A4,0xA4},{0x00A5,0xA5},{0x00A6,0xA6},
+  {0x00A7,0xA7},{0x00A8,0xA8},{0x00A9,0xA9},{0x00AB,0xAB},{0x00AC,0xAC},{0x00AD,0xAD},
+  {0x00AE,0xAE},{0x00AF,0xAF},{0x00B0,0xB0},{0x00B1,0xB1},{0x00B2,0xB2},{0x00B3,0xB3},
+  {0x00B4,0xB4},{0x00B5,0xB5},{0x00B6,0xB6},{0x00B7,0xB7},{0x00B8,0xB8},{0x00B9,0xB9},
+  {0x00BB,0xBB},{0x00BC,0xBC},{0x00BD,0xBD},{0x00BE,0xBE},{0x00D7,0xD7},{0x00E0,0xE0},
+  {0x00E2,0xE2},{0x00E7,0xE7},{0x00E8,0xE8},{0x00E9,0xE9},{0x00EA,0xEA},{0x00EB,0xEB},
+  {0x00EE,0xEE},{0x00EF,0xEF},{0x00F4,0xF4},{0x00F7,0xF7},{0x00F9,0xF9},{0x00FB,0xFB},
+  {0x00FC,0xFC},{0x0152,0x8C},{0x0153,0x9C},{0x0192,0x83},{0x02C6,0x88},{0x060C,0xA1},
+  {0x061B,0xBA},{0x061F,0xBF},{0x0621,0xC1},{0x0622,0xC2},{0x0623,0xC3},{0x0624,0xC4},
+  {0x0625,0xC5},{0x0626,0xC6},{0x0627,0xC7},{0x0628,0xC8},{0x0629,0xC9},{0x062A,0xCA},
+  {0x062B,0xCB},{0x062C,0xCC},{0x062D,0xCD},{0x062E,0xCE},{0x062F,0xCF},{0x0630,0xD0},
+  {0x0631,0xD1},{0x0632,0xD2},{0x0633,0xD3},{0x0634,0xD4},{0x0635,0xD5},{0x0636,0xD6},
+  {0x0637,0xD8},{0x0638,0xD9},{0x0639,0xDA},{0x063A,0xDB},{0x0640,0xDC},{0x0641,0xDD},
+  {0x0642,0xDE},{0x0643,0xDF},{0x0644,0xE1},{0x0645,0xE3},{0x0646,0xE4},{0x0647,0xE5},
+  {0x0648,0xE6},{0x0649,0xEC},{0x064A,0xED},{0x064B,0xF0},{0x064C,0xF1},{0x064D,0xF2},
+  {0x064E,0xF3},{0x064F,0xF5},{0x0650,0xF6},{0x0651,0xF8},{0x0652,0xFA},{0x0679,0x8A},
+  {0x067E,0x81},{0x0686,0x8D},{0x0688,0x8F},{0x0691,0x9A},{0x0698,0x8E},{0x06A9,0x98},
+  {0x06AF,0x90},{0x06BA,0x9F},{0x06BE,0xAA},{0x06C1,0xC0},{0x06D2,0xFF},{0x200C,0x9D},
+  {0x200D,0x9E},{0x200E,0xFD},{0x200F,0xFE},{0x2013,0x96},{0x2014,0x97},{0x2018,0x91},
+  {0x2019,0x92},{0x201A,0x82},{0x201C,0x93},{0x201D,0x94},{0x201E,0x84},{0x2020,0x86},
+  {0x2021,0x87},{0x2022,0x95},{0x2026,0x85},{0x2030,0x89},{0x2039,0x8B},{0x203A,0x9B},
+  {0x20AC,0x80},{0x2122,0x99}
+};
+
+static const quint16 cp1257Upper[128]=
+{
+  0x20AC,0x0000,0x201A,0x0000,0x201E,0x2026,0x2020,0x2021,
+  0x0000,0x2030,0x0000,0x2039,0x0000,0x00A8,0x02C7,0x00B8,
+  0x0000,0x2018,0x2019,0x201C,0x201D,0x2022,0x2013,0x2014,
+  0x0000,0x2122,0x0000,0x203A,0x0000,0x00AF,0x02DB,0x0000,
+  0x00A0,0x0000,0x00A2,0x00A3,0x00A4,0x0000,0x00A6,0x00A7,
+  0x00D8,0x00A9,0x0156,0x00AB,0x00AC,0x00AD,0x00AE,0x00C6,
+  0x00B0,0x00B1,0x00B2,0x00B3,0x00B4,0x00B5,0x00B6,0x00B7,
+  0x00F8,0x00B9,0x0157,0x00BB,0x00BC,0x00BD,0x00BE,0x00E6,
+  0x0104,0x012E,0x0100,0x0106,0x00C4,0x00C5,0x0118,0x0112,
+  0x010C,0x00C9,0x0179,0x0116,0x0122,0x0136,0x012A,0x013B,
+  0x0160,0x0143,0x0145,0x00D3,0x014C,0x00D5,0x00D6,0x00D7,
+  0x0172,0x0141,0x015A,0x016A,0x00DC,0x017B,0x017D,0x00DF,
+  0x0105,0x012F,0x0101,0x0107,0x00E4,0x00E5,0x0119,0x0113,
+  0x010D,0x00E9,0x017A,0x0117,0x0123,0x0137,0x012B,0x013C,
+  0x0161,0x0144,0x0146,0x00F3,0x014D,0x00F5,0x00F6,0x00F7,
+  0x0173,0x0142,0x015B,0x016B,0x00FC,0x017C,0x017E,0x02D9
+};
+
+static const CODEPAGE_REVERSE cp1257Reverse[]=
+{
+  {0x00A0,0xA0},{0x00A2,0xA2},{0x00A3,0xA3},{0x00A4,0xA4},{0x00A6,0xA6},{0x00A7,0xA7},
+  {0x00A8,0x8D},{0x00A9,0xA9},{0x00AB,0xAB},{0x00AC,0xAC},{0x00AD,0xAD},{0x00AE,0xAE},
+  {0x00AF,0x9D},{0x00B0,0xB0},{0x00B1,0xB1},{0x00B2,0xB2},{0x00B3,0xB3},{0x00B4,0xB4},
+  {0x00B5,0xB5},{0x00B6,0xB6},{0x00B7,0xB7},{0x00B8,0x8F},{0x00B9,0xB9},{0x00BB,0xBB},
+  {0x00BC,0xBC},{0x00BD,0xBD},{0x00BE,0xBE},{0x00C4,0xC4},{0x00C5,0xC5},{0x00C6,0xAF},
+  {0x00C9,0xC9},{0x00D3,0xD3},{0x00D5,0xD5},{0x00D6,0xD6},{0x00D7,0xD7},{0x00D8,0xA8},
+  {0x00DC,0xDC},{0x00DF,0xDF},{0x00E4,0xE4},{0x00E5,0xE5},{0x00E6,0xBF},{0x00E9,0xE9},
+  {0x00F3,0xF3},{0x00F5,0xF5},{0x00F6,0xF6},{0x00F7,0xF7},{0x00F8,0xB8},{0x00FC,0xFC},
+  {0x0100,0xC2},{0x0101,0xE2},{0x0104,0xC0},{0x0105,0xE0},{0x0106,0xC3},{0x0107,0xE3},
+  {0x010C,0xC8},{0x010D,0xE8},{0x0112,0xC7},{0x0113,0xE7},{0x0116,0xCB},{0x0117,0xEB},
+  {0x0118,0xC6},{0x0119,0xE6},{0x0122,0xCC},{0x0123,0xEC},{0x012A,0xCE},{0x012B,0xEE},
+  {0x012E,0xC1},{0x012F,0xE1},{0x0136,0xCD},{0x0137,0xED},{0x013B,0xCF},{0x013C,0xEF},
+  {0x0141,0xD9},{0x0142,0xF9},{0x0143,0xD1},{0x0144,0xF1},{0x0145,0xD2},{0x0146,0xF2},
+  {0x014C,0xD4},{0x014D,0xF4},{0x0156,0xAA},{0x0157,0xBA},{0x015A,0xDA},{0x015B,0xFA},
+  {0x0160,0xD0},{0x0161,0xF0},{0x016A,0xDB},{0x016B,0xFB},{0x0172,0xD8},{0x0173,0xF8},
+  {0x0179,0xCA},{0x017A,0xEA},{0x017B,0xDD},{0x017C,0xFD},{0x017D,0xDE},{0x017E,0xFE},
+  {0x02C7,0x8E},{0x02D9,0xFF},{0x02DB,0x9E},{0x2013,0x96},{0x2014,0x97},{0x2018,0x91},
+  {0x2019,0x92},{0x201A,0x82},{0x201C,0x93},{0x201D,0x94},{0x201E,0x84},{0x2020,0x86},
+  {0x2021,0x87},{0x2022,0x95},{0x2026,0x85},{0x2030,0x89},{0x2039,0x8B},{0x203A,0x9B},
+  {0x20AC,0x80},{0x2122,0x99}
+};
+
+static const quint16 cp1258Upper[128]=
+{
+  0x20AC,0x0000,0x201A,0x0192,0x201E,0x2026,0x2020,0x2021,
+  0x02C6,0x2030,0x0000,0x2039,0x0152,0x0000,0x0000,0x0000,
+  0x0000,0x2018,0x2019,0x201C,0x201D,0x2022,0x2013,0x2014,
+  0x02DC,0x2122,0x0000,0x203A,0x0153,0x0000,0x0000,0x0178,
+  0x00A0,0x00A1,0x00A2,0x00A3,0x00A4,0x00A5,0x00A6,0x00A7,
+  0x00A8,0x00A9,0x00AA,0x00AB,0x00AC,0x00AD,0x00AE,0x00AF,
+  0x00B0,0x00B1,0x00B2,0x00B3,0x00B4,0x00B5,0x00B6,0x00B7,
+  0x00B8,0x00B9,0x00BA,0x00BB,0x00BC,0x00BD,0x00BE,0x00BF,
+  0x00C0,0x00C1,0x00C2,0x0102,0x00C4,0x00C5,0x00C6,0x00C7,
+  0x00C8,0x00C9,0x00CA,0x00CB,0x0300,0x00CD,0x00CE,0x00CF,
+  0x0110,0x00D1,0x0309,0x00D3,0x00D4,0x01A0,0x00D6,0x00D7,
+  0x00D8,0x00D9,0x00DA,0x00DB,0x00DC,0x01AF,0x0303,0x00DF,
+  0x00E0,0x00E1,0x00E2,0x0103,0x00E4,0x00E5,0x00E6,0x00E7,
+  0x00E8,0x00E9,0x00EA,0x00EB,0x0301,0x00ED,0x00EE,0x00EF,
+  0x0111,0x00F1,0x0323,0x00F3,0x00F4,0x01A1,0x00F6,0x00F7,
+  0x00F8,0x00F9,0x00FA,0x00FB,0x00FC,0x01B0,0x20AB,0x00FF
+};
+
+static const CODEPAGE_REVERSE cp1258Reverse[]=
+{
+  {0x00A0,0xA0},{0x00A1,0xA1},{0x00A2,0xA2},{0x00A3,0xA3},{0x00A4,0xA4},{0x00A5,0xA5},
+  {0x00A6,0xA6},{0x00A7,0xA7},{0x00A8,0xA8},{0x00A9,0xA9},{0x00AA,0xAA},{0x00AB,0xAB},
+  {0x00AC,0xAC},{0x00AD,0xAD},{0x00AE,0xAE},{0x00AF,0xAF},{0x00B0,0xB0},{0x00B1,0xB1},
+  {0x00B2,0xB2},{0x00B3,0xB3},{0x00B4,0xB4},{0x00B5,0xB5},{0x00B6,0xB6},{0x00B7,0xB7},
+  {0x00B8,0xB8},{0x00B9,0xB9},{0x00BA,0xBA},{0x00BB,0xBB},{0x00BC,0xBC},{0x00BD,0xBD},
+  {0x00BE,0xBE},{0x00BF,0xBF},{0x00C0,0xC0},{0x00C1,0xC1},{0x00C2,0xC2},{0x00C4,0xC4},
+  {0x00C5,0xC5},{0x00C6,0xC6},{0x00C7,0xC7},{0x00C8,0xC8},{0x00C9,0xC9},{0x00CA,0xCA},
+  {0x00CB,0xCB},{0x00CD,0xCD},{0x00CE,0xCE},{0x00CF,0xCF},{0x00D1,0xD1},{0x00D3,0xD3},
+  {0x00D4,0xD4},{0x00D6,0xD6},{0x00D7,0xD7},{0x00D8,0xD8},{0x00D9,0xD9},{0x00DA,0xDA},
+  {0x00DB,0xDB},{0x00DC,0xDC},{0x00DF,0xDF},{0x00E0,0xE0},{0x00E1,0xE1},{0x00E2,0xE2},
+  {0x00E4,0xE4},{0x00E5,0xE5},{0x00E6,0xE6},{0x00E7,0xE7},{0x00E8,0xE8},{0x00E9,0xE9},
+  {0x00EA,0xEA},{0x00EB,0xEB},{0x00ED,0xED},{0x00EE,0xEE},{0x00EF,0xEF},{0x00F1,0xF1},
+  {0x00F3,0xF3},{0x00F4,0xF4},{0x00F6,0xF6},{0x00F7,0xF7},{0x00F8,0xF8},{0x00F9,0xF9},
+  {0x00FA,0xFA},{0x00FB,0xFB},{0x00FC,0xFC},{0x00FF,0xFF},{0x0102,0xC3},{0x0103,0xE3},
+  {0x0110,0xD0},{0x0111,0xF0},{0x0152,0x8C},{0x0153,0x9C},{0x0178,0x9F},{0x0192,0x83},
+  {0x01A0,0xD5},{0x01A1,0xF5},{0x01AF,0xDD},{0x01B0,0xFD},{0x02C6,0x88},{0x02DC,0x98},
+  {0x0300,0xCC},{0x0301,0xEC},{0x0303,0xDE},{0x0309,0xD2},{0x0323,0xF2},{0x2013,0x96},
+  {0x2014,0x97},{0x2018,0x91},{0x2019,0x92},{0x201A,0x82},{0x201C,0x93},{0x201D,0x94},
+  {0x201E,0x84},{0x2020,0x86},{0x2021,0x87},{0x2022,0x95},{0x2026,0x85},{0x2030,0x89},
+  {0x2039,0x8B},{0x203A,0x9B},{0x20AB,0xFE},{0x20AC,0x80},{0x2122,0x99}
+};
+
+
+#endif // _AEASY_CODEPAGES_H_
@@ -5,12 +5,15 @@
  *
  *              CFontManager  - maintains the relationship between fonts defined in the album
  *                              and the font file and code page used by libharu
+ *              CTextRuns     - a line of text split into runs by font, using the fallback
+ *                              chain for the characters missing from the font of the line
+ *              CFontCoverage - the characters a font can draw
  *              CFontFileInfo - object containing the font name, file name, and code pages
  *              CFontFileList - list of CFontFileInfo records for the available TTF files
  *              CFontPathList - list of paths to search for TTF files
  *
  *              NOTE: The current version of AlbumEasy only support the CP1250 to CP1258 code
- *                    pages.
+ *                    pages, plus UTF-8 for TrueType fonts which are then used as CID fonts.
  *
  * --------------------------------------------------------------------------------------------
  * COPYRIGHT:   Copyright (c) 2005-2013
@@ -34,6 +37,7 @@
 
 #include "AlbumEasy.h"
 #include "aeasy_ttf_structs.h"
+#include "aeasy_codepages.h"
 #include "aeasy_flistwindow.h"
 #include "aeasy_fonts.h"
 
@@ -54,7 +58,8 @@ struct FONT_MAP
   int encoding;                                                //index into FONT_ENCODINGS array
   QString filePath;                                            //path for TT Font
   QString fileName;                                            //filename for TT Font
-
+  CFontCoverage coverage;                                      //characters drawn by a TT Font
+                                                               //with its encoding
 };
 
 
@@ -69,9 +74,13 @@ struct FONT_ENCODINGS
 {
   QString encodingId;
   QString languageName;
-  QString codec;
+  CTextEncoder encoder;
 };
 
+                                                           //encoder for the tables of a code page
+#define CODEPAGE_ENCODER(cp) CTextEncoder(cp##Upper,cp##Reverse,                                  \
+                                          (int)(sizeof(cp##Reverse)/sizeof(cp##Reverse[0])))
+
 
 /* ---------------------------------------------------------------------------------------------
 /  Local Globals
@@ -88,6 +97,10 @@ static const char * const requiredtags[]={"OS/2","cmap","cvt ","fpgm","glyf","he
 /  ---------------------------------------------------------------------------------------------*/
 
 QString CFontManager::m_error;
+HPDF_FontCache CFontManager::m_fontCache=NULL;
+QHash<QString,QDateTime> CFontManager::m_fontFileTimes;
+bool CFontManager::m_utfEncodings=false;
+QVector<int> CFontManager::m_fallback;
 
 /* ---------------------------------------------------------------------------------------------
 /  The FONT_MAP structure is used to map a font identifier to either a built in base14 font
@@ -100,6 +113,9 @@ QString CFontManager::m_error;
 /  error if an attempt is made to load the same file more than once on a per document basis.
 /  Thus necessitating the FONT_FILE_MAP structure which is used to ensure that each TTF file
 /  is only loaded once for each new PDF document.
+/
+/  The files themselves are only parsed once, by the libharu font cache which is shared by all
+/  documents, so loading a file again for a new document does not parse its tables again.
 /  ---------------------------------------------------------------------------------------------*/
 
 #define NUM_USER_FONTS       12                                //Allow up to 12 user defined fonts
@@ -152,27 +168,33 @@ static FONT_FILE_MAP fontFileMap[]=                          //enough room for N
 
 
 /* ---------------------------------------------------------------------------------------------
-/  Array that maps encoding identifiers to friendly language names and codec identifiers.
-/  The later are used to identify the necessary codec for converting Unicode encoded QStrings
-/  to an appropriate 8 bit encoding for the font.
+/  Array that maps encoding identifiers to friendly language names and text encoders.
+/  The later convert Unicode encoded QStrings to an appropriate 8 bit encoding for the font,
+/  using the code page tables in aeasy_codepages.h rather than a QTextCodec.
 /
 /  NOTE: The current implementation of CFontFileInfo::availableCodePages is based on the sequence
-/        of items in this array matching the bit sequence in the "OS/2" table ulCodePageRange1
+/        of items in this array matching the bit sequence in the "OS/2" table ulCodePageRange1,
+/        except for the UTF-8 entry at the end which is not a code page, and is available for
+/        any TrueType font. Fonts using it are loaded by libharu as CID fonts, so that text of
+/        any script the font covers can be mixed in a string, its UTF-8 encoder handles the
+/        characters up to U+07FF.
 /  ---------------------------------------------------------------------------------------------*/
 
 #define ENCODING_LATIN_1  0                  //index of the Latin1 font in the fontEncodings array
+#define ENCODING_UTF_8    9                  //index of the UTF-8 entry in the fontEncodings array
 
 static FONT_ENCODINGS fontEncodings[]=
 {
-{"CP1252", "Latin 1",        "Windows-1252"},
-{"CP1250", "Latin 2",        "Windows-1250"},
-{"CP1251", "Cyrillic",       "Windows-1251"},
-{"CP1253", "Greek",          "Windows-1253"},
-{"CP1254", "Turkish",        "Windows-1254"},
-{"CP1255", "Hebrew",         "Windows-1255"},
-{"CP1256", "Arabic",         "Windows-1256"},
-{"CP1257", "Windows Baltic", "Windows-1257"},
-{"CP1258", "Vietnamese",     "Windows-1258"}
+{"CP1252", "Latin 1",        CODEPAGE_ENCODER(cp1252)},
+{"CP1250", "Latin 2",        CODEPAGE_ENCODER(cp1250)},
+{"CP1251", "Cyrillic",       CODEPAGE_ENCODER(cp1251)},
+{"CP1253", "Greek",          CODEPAGE_ENCODER(cp1253)},
+{"CP1254", "Turkish",        CODEPAGE_ENCODER(cp1254)},
+{"CP1255", "Hebrew",         CODEPAGE_ENCODER(cp1255)},
+{"CP1256", "Arabic",         CODEPAGE_ENCODER(cp1256)},
+{"CP1257", "Windows Baltic", CODEPAGE_ENCODER(cp1257)},
+{"CP1258", "Vietnamese",     CODEPAGE_ENCODER(cp1258)},
+{"UTF-8",  "Unicode",        CTextEncoder()}
 };
 
 
@@ -183,7 +205,8 @@ void CFontManager::initialise(void)
    DESCRIPTION: Font files have to be loaded for each PDF document, this function is used
                 to clear out any font-file to font-name mappings from a previous document
                 so that they will be loaded for the new document.
-                It also clears any existing user defined fonts.
+                It also clears any existing user defined fonts and fallback chain, and notes
+                that the UTF-8 encoder has not yet been registered with the new document.
    --------------------------------------------------------------------------------------------
     PARAMETERS:  none
    --------------------------------------------------------------------------------------------
@@ -199,7 +222,10 @@ void CFontManager::initialise(void)
   for(unsigned int i=NUM_PREDEFINED_FONTS; i<(NUM_PREDEFINED_FONTS+NUM_USER_FONTS);i++)
     {
     fontMap[i].fontIdentifier="";
+    fontMap[i].coverage=CFontCoverage();
     }
+  m_fallback.clear();
+  m_utfEncodings=false;
 }
 
 
@@ -243,8 +269,9 @@ bool CFontManager::addUserDefinedFont(CFontFileList *fontFiles,QString fontId,QS
     {
     QString fileName;
     QString filePath;
+    CFontCoverage fileCoverage;
                       //search the list of available font files for one that matches the font name
-    if(fontFiles->find(fontName,fileName,filePath)==false)
+    if(fontFiles->find(fontName,fileName,filePath,&fileCoverage)==false)
       {
       error=true;
       m_error=QString(tr(" Error finding a True Type font file containing font %1").arg(fontName));
@@ -276,6 +303,9 @@ bool CFontManager::addUserDefinedFont(CFontFileList *fontFiles,QString fontId,QS
         }
       if(error==false)
         {
+                                       //the characters the font can draw with the chosen encoding
+        encodingCoverage(fontMap[id].encoding,&fileCoverage,fontMap[id].coverage);
+
         bool mapped=false;  //add font file with path to fontFileMap if not already in fontFileMap
 
         QString file=QDir::toNativeSeparators(fontMap[id].filePath+"/"+fontMap[id].fileName);
@@ -310,6 +340,91 @@ bool CFontManager::addUserDefinedFont(CFontFileList *fontFiles,QString fontId,QS
 }
 
 
+/************************************************************************************************/
+bool CFontManager::setFallbackFonts(const QStringList &fontIds)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Set the chain of fonts used to draw the characters that the font of a line of
+                text can't draw. The fonts are tried in the order given.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: fontIds: The font identifiers
+   --------------------------------------------------------------------------------------------
+       RETURNS:  true: error
+                false: success
+   -------------------------------------------------------------------------------------------- */
+{
+  bool error=false;
+  m_error="";                                                                 //clear error string
+
+  m_fallback.clear();
+  for(int i=0;i<fontIds.size() && error==false;i++)
+    {
+    int index=getFontIndex(fontIds.at(i));
+    if(index<0)
+      {
+      m_error=QString(tr(" Specified font \"%1\" not found.").arg(fontIds.at(i)));
+      error=true;
+      }
+    else
+      m_fallback.append(index);
+    }
+  if(error==true)
+    m_fallback.clear();
+
+  return error;
+}
+
+
+/************************************************************************************************/
+bool CFontManager::covers(int index,uint code)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Check if a font can draw a character with its encoding
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: index: The font identifier
+                 code: The Unicode character
+   --------------------------------------------------------------------------------------------
+       RETURNS:  true: the font can draw the character
+                false: the character is missing from the font or its encoding
+   -------------------------------------------------------------------------------------------- */
+{
+  static CFontCoverage base14;                               //the built-in fonts all draw Latin 1
+
+  if(index<0 || index>=(int)(sizeof(fontMap)/sizeof(fontMap[0])))
+    return false;
+
+  if(fontMap[index].base14==true)
+    {
+    if(base14.isEmpty())
+      encodingCoverage(ENCODING_LATIN_1,0,base14);
+    return base14.contains(code);
+    }
+  return fontMap[index].coverage.contains(code);
+}
+
+
+/************************************************************************************************/
+int CFontManager::fallbackFont(int index,uint code)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Choose the font to draw a character with, the font itself if it can draw the
+                character, else the first font of the fallback chain that can.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: index: The font identifier
+                 code: The Unicode character
+   --------------------------------------------------------------------------------------------
+       RETURNS:   int: The font identifier to use, index when no font can draw the character
+   -------------------------------------------------------------------------------------------- */
+{
+  if(covers(index,code)==true)
+    return index;
+
+  for(int i=0;i<m_fallback.size();i++)
+    {
+    if(covers(m_fallback.at(i),code)==true)
+      return m_fallback.at(i);
+    }
+  return index;
+}
+
+
 /************************************************************************************************/
 int CFontManager::getFontIndex(QString fontId)
 /* --------------------------------------------------------------------------------------------
@@ -384,8 +499,12 @@ HPDF_Font CFontManager::getFont(HPDF_Doc pdfDoc,int index)
         {
         if(fontFileMap[fmidx].fontName.length()==0)         //if font file has not yet been loaded
           {
+          QString cachedFile=cachedFontFile(file);
+          if(m_fontCache!=NULL)
+            HPDF_SetFontCache(pdfDoc,m_fontCache);
                                                                                          //load it
-          fontFileMap[fmidx].fontName=HPDF_LoadTTFontFromFile(pdfDoc,file.toLatin1(),HPDF_TRUE);
+          fontFileMap[fmidx].fontName=HPDF_LoadTTFontFromFile(pdfDoc,cachedFile.toLatin1(),
+                                                              HPDF_TRUE);
           }
 
         if(fontFileMap[fmidx].fontName.length()==0)     //if font file was not loaded successfully
@@ -402,6 +521,11 @@ HPDF_Font CFontManager::getFont(HPDF_Doc pdfDoc,int index)
           else
             {
             int i=fontMap[index].encoding;                       //else use the encoding ID string
+            if(i==ENCODING_UTF_8 && m_utfEncodings==false)       //register the UTF-8 encoder once
+              {
+              HPDF_UseUTFEncodings(pdfDoc);
+              m_utfEncodings=true;
+              }
             f=HPDF_GetFont(pdfDoc,fontFileMap[fmidx].fontName.toLatin1(),
                            fontEncodings[i].encodingId.toLatin1());
             }
@@ -427,38 +551,298 @@ HPDF_Font CFontManager::getFont(HPDF_Doc pdfDoc,int index)
 }
 
 /************************************************************************************************/
-QTextCodec *CFontManager::getCodec(int index)
+QString CFontManager::cachedFontFile(QString file)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: TTF files are parsed by the libharu font cache once for all documents, keyed by
+                the canonical path of the file. If the file has been modified since it was
+                cached, it is removed from the cache so that the new version is parsed.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: file: Path of the TTF file
+   --------------------------------------------------------------------------------------------
+       RETURNS: The path to load the file with
+   -------------------------------------------------------------------------------------------- */
+{
+  if(m_fontCache==NULL)
+    {
+    m_fontCache=HPDF_NewFontCache();
+    if(m_fontCache!=NULL)
+      qAddPostRoutine(freeFontCache);                         //free it when the application exits
+    }
+
+  QFileInfo info(file);
+  QString path=info.canonicalFilePath();
+  if(path.isEmpty())                              //the file does not exist, let libharu report it
+    return file;
+  path=QDir::toNativeSeparators(path);
+
+  QDateTime modified=info.lastModified();
+  if(m_fontCache!=NULL && m_fontFileTimes.contains(path) && m_fontFileTimes.value(path)!=modified)
+    HPDF_RemoveFromFontCache(m_fontCache,path.toLatin1());
+  m_fontFileTimes.insert(path,modified);
+
+  return path;
+}
+
+
+/************************************************************************************************/
+void CFontManager::freeFontCache(void)
 /* --------------------------------------------------------------------------------------------
-   DESCRIPTION: Get the codec for converting a QString (Unicode) to an appropriate 8 bit encoded
-                string for the font.
+   DESCRIPTION: Frees the libharu font cache when the application exits. Each PDF document is
+                freed as soon as it has been generated, so no document still uses the cache.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  none
+   --------------------------------------------------------------------------------------------
+       RETURNS:  none
+   -------------------------------------------------------------------------------------------- */
+{
+  if(m_fontCache!=NULL)
+    HPDF_FreeFontCache(m_fontCache);
+  m_fontCache=NULL;
+  m_fontFileTimes.clear();
+}
+
+
+/************************************************************************************************/
+void CFontManager::encodingCoverage(int encoding,const CFontCoverage *font,
+                                    CFontCoverage &coverage)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Find the characters of a font that can be drawn with an encoding, these are
+                the characters of the code page, or up to U+07FF for UTF-8.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: encoding: Index into the fontEncodings array, <0 => Latin 1
+                    font: Characters in the font file, 0 => all characters
+                coverage: Variable to return the characters in
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  coverage=CFontCoverage();
+
+  if(encoding<0)
+    encoding=ENCODING_LATIN_1;
+
+  if(encoding==ENCODING_UTF_8)                      //limited by the libharu UTF-8 encoder instead
+    {
+    for(uint code=0x20;code<0x800;code++)
+      {
+      if(font==0 || font->contains(code))
+        coverage.addRange(code,code);
+      }
+    }
+  else
+    {
+    for(int c=0x20;c<=0xff;c++)
+      {
+      uint code=fontEncodings[encoding].encoder.toUnicode((uchar)c);
+      if(code!=0 && (font==0 || font->contains(code)))           //0 => undefined in the code page
+        coverage.addRange(code,code);
+      }
+    }
+}
+
+
+/************************************************************************************************/
+const CTextEncoder *CFontManager::getEncoder(int index)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Get the encoder for converting a QString (Unicode) to an appropriate 8 bit
+                encoded string for the font.
    --------------------------------------------------------------------------------------------
     PARAMETERS: index: The font identifier
    --------------------------------------------------------------------------------------------
-       RETURNS:  QTextCodec *: The codec
-                               0 => no matching codec foung
+       RETURNS:  CTextEncoder *: The encoder
+                                 0 => font identifier not found
    -------------------------------------------------------------------------------------------- */
 {
-  QTextCodec *qtCodec=NULL;
+  const CTextEncoder *encoder=NULL;
 
   m_error="";                                                                 //clear error string
 
   if(index>=0 && index<(int)(sizeof(fontMap)/sizeof(fontMap[0])))
     {
-    const char *codecName;
-
     int f=fontMap[index].encoding;
     if(f>=0)                                                //if an encoding was specified, use it
-      codecName=fontEncodings[f].codec.toLatin1().data();
+      encoder=&fontEncodings[f].encoder;
     else
-      codecName=fontEncodings[ENCODING_LATIN_1].codec.toLatin1().data();  //else default to Latin1
-
-    if((qtCodec=QTextCodec::codecForName(codecName))==0)
-      m_error=QString(tr(" Font encoding \"%1\" was not found.")).arg(codecName);
+      encoder=&fontEncodings[ENCODING_LATIN_1].encoder;                   //else default to Latin1
     }
   else
     m_error=" Undefined error while loading font encoding.";
 
-  return qtCodec;
+  return encoder;
+}
+
+
+/************************************************************************************************/
+double CFontManager::textWidth(HPDF_Font font,double fsize,const char *text,int length)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Measure the width of an encoded string without requiring a PDF page, used by
+                the layout pass. Gives the same result as HPDF_Page_TextWidth with the default
+                character and word spacing.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  font: The font
+                fsize: The font size
+                 text: The text encoded for the font
+               length: The length of the encoded text in bytes
+   --------------------------------------------------------------------------------------------
+       RETURNS:  double: width of the text in points
+   -------------------------------------------------------------------------------------------- */
+{
+  if(length==0)
+    return 0.0;
+
+  HPDF_TextWidth tw=HPDF_Font_TextWidth(font,(const HPDF_BYTE *)text,length);
+  return tw.width*fsize/1000.0;
+}
+
+
+/************************************************************************************************/
+CTextRuns::CTextRuns(HPDF_Doc pdfDoc,int findex,HPDF_Font font,const CTextEncoder *encoder,
+                     const QString &text)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Constructor, splits a line of text into runs by font
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  pdfDoc: PDF document being generated
+                 findex: The font of the line
+                   font: The font handle for findex
+                encoder: The encoder for findex
+                   text: The line of text
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  set(pdfDoc,findex,font,encoder,text.constData(),text.length());
+}
+
+
+/************************************************************************************************/
+void CTextRuns::set(HPDF_Doc pdfDoc,int findex,HPDF_Font font,const CTextEncoder *encoder,
+                    const QChar *text,int length)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Split a line of text into runs by font, replacing the previous line. A
+                character stays in the current run while its font can draw it, so that spaces
+                and punctuation don't split runs. The buffers keep their capacity, so measuring
+                a line repeatedly while shortening it doesn't allocate.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  pdfDoc: PDF document being generated
+                 findex: The font of the line
+                   font: The font handle for findex
+                encoder: The encoder for findex
+                   text: The characters of the line
+                 length: The number of characters
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  m_primary=findex;
+  m_primaryFont=font;
+  m_primaryEncoder=encoder;
+
+  m_findex.resize(0);
+  m_font.resize(0);
+  m_start.resize(0);
+  m_start.append(0);
+  m_buffer.resize(0);
+
+  if(CFontManager::hasFallbackFonts()==false)                 //no chain, the line is a single run
+    {
+    addRun(pdfDoc,findex,text,length);
+    return;
+    }
+
+  int runFont=-1;
+  int start=0;
+  for(int i=0;i<length;i++)
+    {
+    uint code=text[i].unicode();
+    int f=runFont;
+
+    if(runFont<0 || CFontManager::covers(runFont,code)==false)
+      f=CFontManager::fallbackFont(findex,code);
+
+    if(f!=runFont)                                                               //start a new run
+      {
+      if(i>start)
+        addRun(pdfDoc,runFont,text+start,i-start);
+      start=i;
+      runFont=f;
+      }
+    }
+  if(length>start)
+    addRun(pdfDoc,runFont,text+start,length-start);
+}
+
+
+/************************************************************************************************/
+void CTextRuns::addRun(HPDF_Doc pdfDoc,int findex,const QChar *text,int length)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Add a run of text, encoding it for its font at the end of the buffer. A
+                fallback font that can't be loaded is replaced by the font of the line.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: pdfDoc: PDF document being generated
+                findex: The font of the run
+                  text: The characters of the run
+                length: The number of characters
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  HPDF_Font font=m_primaryFont;
+  const CTextEncoder *encoder=m_primaryEncoder;
+
+  if(findex!=m_primary)
+    {
+    font=CFontManager::getFont(pdfDoc,findex);
+    encoder=CFontManager::getEncoder(findex);
+    if(font==NULL || encoder==NULL)
+      {
+      findex=m_primary;
+      font=m_primaryFont;
+      encoder=m_primaryEncoder;
+      }
+    }
+
+  int start=m_buffer.size();
+  m_buffer.resize(start+encoder->maxLength(length)+1);                   //room for the worst case
+  int end=start+encoder->encode(text,length,m_buffer.data()+start);
+  m_buffer[end]=0;
+  m_buffer.resize(end+1);
+
+  m_findex.append(findex);
+  m_font.append(font);
+  m_start.append(end+1);
+}
+
+
+/************************************************************************************************/
+double CTextRuns::width(int run,double fsize) const
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Measure the width of a run of text
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:   run: The run
+                fsize: The font size
+   --------------------------------------------------------------------------------------------
+       RETURNS: double: width of the run in points
+   -------------------------------------------------------------------------------------------- */
+{
+  return CFontManager::textWidth(m_font.at(run),fsize,text(run),length(run));
+}
+
+
+/************************************************************************************************/
+double CTextRuns::width(double fsize) const
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Measure the width of the whole line of text
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: fsize: The font size
+   --------------------------------------------------------------------------------------------
+       RETURNS: double: width of the line in points
+   -------------------------------------------------------------------------------------------- */
+{
+  double w=0.0;
+
+  for(int i=0;i<m_text.size();i++)
+    w=w+width(i,fsize);
+  return w;
 }
 
 
@@ -536,13 +920,15 @@ void CFontFileList::populate(QWidget *parent,bool includeSystemFonts)
 }
 
 /************************************************************************************************/
-bool CFontFileList::find(QString fontName,QString &fileName,QString &filePath)
+bool CFontFileList::find(QString fontName,QString &fileName,QString &filePath,
+                         CFontCoverage *coverage)
 /* --------------------------------------------------------------------------------------------
    DESCRIPTION: find a font by name, returning the corresponding file and it's location.
    --------------------------------------------------------------------------------------------
     PARAMETERS: fontName:  Name of font to find
                 fileName:  Variable to return the file name in
                 filePath:  Variable to return the file location in
+                coverage:  Variable to return the characters in the file in, 0 => not needed
    --------------------------------------------------------------------------------------------
        RETURNS:  true: found
                 false: not found
@@ -555,6 +941,8 @@ bool CFontFileList::find(QString fontName,QString &fileName,QString &filePath)
       {
       fileName=f->fileName();
       filePath=f->filePath();
+      if(coverage!=0)
+        *coverage=f->coverage();
       if(fileName.length()>0 && filePath.length()>0 )
         return true;
       }
@@ -863,6 +1251,7 @@ void CFontFileList::parseFontFile(const QString fileName,const QString filePath)
   TTF_CMAP_FORMAT_RECORD   formatRecord;
 
   bool unicodeFormat=false;
+  CFontCoverage coverage;
 
   for(int i=0; i<cmapHeader.count && usable==true && unicodeFormat==false ;i++)
     {
@@ -883,7 +1272,12 @@ void CFontFileList::parseFontFile(const QString fileName,const QString filePath)
         formatRecord.language=qFromBigEndian(formatRecord.language);
                                                                          //if format is MS Unicode
         if(encodingRecord.platformId==3 && encodingRecord.encodingId==1 && formatRecord.format==4)
+          {
           unicodeFormat=true;
+                                      //record the characters it maps, for choosing fallback fonts
+          ttfFile.seek(cmapTableDir.offset+encodingRecord.offset);
+          coverage.addCmapFormat4(ttfFile.read(formatRecord.length));
+          }
         }
       if(unicodeFormat==false)
         ttfFile.seek(pos);    //seek to saved position in preparation for the next encoding record
@@ -925,6 +1319,7 @@ void CFontFileList::parseFontFile(const QString fileName,const QString filePath)
 
     finfo->setFileDetails(fontName,fileName,filePath,
                           os2Table.ulCodePageRange1,os2Table.ulCodePageRange2);
+    finfo->setCoverage(coverage);
 
     m_fontFileInfoRecs.append(finfo);                 //add it to the list of available font files
     }
@@ -1110,6 +1505,7 @@ void CFontFileInfo::availableCodePages(QString &codePages)
                 NOTE: This function expects the fontEncodings[] array defined near the top of
                       this file to be in the same sequence as the bit sequence in the
                       TrueType Font "OS/2" table ulCodePageRange1
+                UTF-8 is listed last for every font, as it is not a code page.
    --------------------------------------------------------------------------------------------
     PARAMETERS: codePages : variable in which to return the code pages.
    --------------------------------------------------------------------------------------------
@@ -1132,5 +1528,254 @@ void CFontFileInfo::availableCodePages(QString &codePages)
       }
     mask=mask<<1;                                                               //get the next bit
     }
+                                                        //UTF-8 is available for any TrueType font
+  QString cp=fontEncodings[ENCODING_UTF_8].encodingId + " ("
+             + fontEncodings[ENCODING_UTF_8].languageName + ")";
+  if(codePages.length()!=0)
+    codePages=codePages+"\n";
+  codePages=codePages+cp;
+}
+
+
+
+/************************************************************************************************/
+CTextEncoder::CTextEncoder(const quint16 *upper,const CODEPAGE_REVERSE *reverse,int reverseCount)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Constructor
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:        upper: The characters of the bytes 0x80 to 0xFF of the code page,
+                              0 => UTF-8
+                     reverse: The characters of the code page sorted, with their bytes
+                reverseCount: The number of entries in reverse
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  m_upper=upper;
+  m_reverse=reverse;
+  m_reverseCount=reverseCount;
+}
+
+
+/************************************************************************************************/
+int CTextEncoder::encode(const QChar *text,int length,char *buffer) const
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Encode text into a buffer. Runs of ASCII, the bulk of album text, are checked
+                and copied four characters at a time, the other characters are looked up in
+                the reverse map of the code page.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:   text: The characters to encode
+                length: The number of characters
+                buffer: Buffer of at least maxLength(length) bytes to encode the text into
+   --------------------------------------------------------------------------------------------
+       RETURNS: int: The number of bytes written to the buffer
+   -------------------------------------------------------------------------------------------- */
+{
+  const quint64 nonAscii=Q_UINT64_C(0xff80ff80ff80ff80);                     //bits set above 0x7F
+  const ushort *chars=reinterpret_cast<const ushort *>(text);
+  int i=0;
+  int n=0;
+
+  if(m_upper==0)
+    return encodeUtf8(text,length,buffer);
+
+  while(i<length)
+    {
+    if(i+4<=length)
+      {
+      quint64 four;
+      memcpy(&four,chars+i,sizeof(four));
+      if((four & nonAscii)==0)                                                //4 ASCII characters
+        {
+        buffer[n]=(char)chars[i];
+        buffer[n+1]=(char)chars[i+1];
+        buffer[n+2]=(char)chars[i+2];
+        buffer[n+3]=(char)chars[i+3];
+        n+=4;
+        i+=4;
+        continue;
+        }
+      }
+
+    ushort code=chars[i++];
+    if(code<0x80)
+      buffer[n++]=(char)code;
+    else
+      {
+      int low=0;                                                //binary search of the reverse map
+      int high=m_reverseCount-1;
+      char byte='?';                                                        //not in the code page
+      while(low<=high)
+        {
+        int mid=(low+high)/2;
+        if(m_reverse[mid].unicode<code)
+          low=mid+1;
+        else if(m_reverse[mid].unicode>code)
+          high=mid-1;
+        else
+          {
+          byte=(char)m_reverse[mid].byte;
+          break;
+          }
+        }
+      buffer[n++]=byte;
+      }
+    }
+
+  return n;
+}
+
+
+/************************************************************************************************/
+int CTextEncoder::encodeUtf8(const QChar *text,int length,char *buffer) const
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Encode text as UTF-8 into a buffer. Only the characters up to U+07FF are
+                encoded, as that is all the libharu UTF-8 encoder handles, the others are
+                replaced by '?'.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:   text: The characters to encode
+                length: The number of characters
+                buffer: Buffer of at least maxLength(length) bytes to encode the text into
+   --------------------------------------------------------------------------------------------
+       RETURNS: int: The number of bytes written to the buffer
+   -------------------------------------------------------------------------------------------- */
+{
+  int n=0;
+
+  for(int i=0;i<length;i++)
+    {
+    ushort code=text[i].unicode();
+    if(code<0x80)
+      buffer[n++]=(char)code;
+    else if(code<0x800)
+      {
+      buffer[n++]=(char)(0xc0 | (code>>6));
+      buffer[n++]=(char)(0x80 | (code & 0x3f));
+      }
+    else
+      buffer[n++]='?';
+    }
+
+  return n;
+}
+
+
+/************************************************************************************************/
+uint CTextEncoder::toUnicode(uchar byte) const
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Get the character of a byte of the code page
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: byte: The byte
+   --------------------------------------------------------------------------------------------
+       RETURNS: uint: The Unicode character, 0 => undefined in the code page
+   -------------------------------------------------------------------------------------------- */
+{
+  if(byte<0x80)
+    return byte;
+  if(m_upper==0)                                             //UTF-8 has no single byte above 0x7F
+    return 0;
+  return m_upper[byte-0x80];
 }
 
+
+/************************************************************************************************/
+void CFontCoverage::addRange(uint first,uint last)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Add a range of characters, characters outside the Basic Multilingual Plane
+                are ignored.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: first: The first character of the range
+                 last: The last character of the range
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  static const QBitArray fullPage(256,true);                        //shared by all the full pages
+
+  last=(last>0xffff)?0xffff:last;
+  if(first>last)
+    return;
+
+  if(m_pages.isEmpty())
+    m_pages.resize(256);
+
+  for(uint page=first>>8;page<=(last>>8);page++)
+    {
+    uint from=(page==(first>>8))?(first & 0xff):0;
+    uint to=(page==(last>>8))?(last & 0xff):0xff;
+
+    if(from==0 && to==0xff)
+      m_pages[page]=fullPage;
+    else
+      {
+      if(m_pages.at(page).isEmpty())
+        m_pages[page].resize(256);
+      m_pages[page].fill(true,from,to+1);
+      }
+    }
+}
+
+
+/************************************************************************************************/
+void CFontCoverage::addCmapFormat4(const QByteArray &subtable)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Add the characters mapped to a glyph by a format 4 "cmap" subtable
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: subtable: The subtable, starting with its format field
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  const uchar *data=(const uchar *)subtable.constData();
+  int size=subtable.size();
+
+  if(size<14)
+    return;
+                                     //offsets of the arrays of segments, each of segCount entries
+  int segCount=qFromBigEndian<quint16>(data+6)/2;
+  int endCodes=14;
+  int startCodes=endCodes+segCount*2+2;                              //after the reservedPad field
+  int idDeltas=startCodes+segCount*2;
+  int idRangeOffsets=idDeltas+segCount*2;
+
+  if(idRangeOffsets+segCount*2>size)
+    return;
+
+  for(int i=0;i<segCount;i++)
+    {
+    uint end=qFromBigEndian<quint16>(data+endCodes+i*2);
+    uint start=qFromBigEndian<quint16>(data+startCodes+i*2);
+    uint delta=qFromBigEndian<quint16>(data+idDeltas+i*2);
+    int rangeOffsetPos=idRangeOffsets+i*2;
+    uint rangeOffset=qFromBigEndian<quint16>(data+rangeOffsetPos);
+
+    if(start>end || start==0xffff)                                 //the last segment maps nothing
+      continue;
+
+    if(rangeOffset==0)                     //glyph is code+delta, only one code can map to glyph 0
+      {
+      uint missing=(0x10000-delta) & 0xffff;
+      if(missing<start || missing>end)
+        addRange(start,end);
+      else
+        {
+        if(missing>start)
+          addRange(start,missing-1);
+        if(missing<end)
+          addRange(missing+1,end);
+        }
+      }
+    else                                                  //glyph is looked up in the glyphIdArray
+      {
+      for(uint code=start;code<=end;code++)
+        {
+        int pos=rangeOffsetPos+rangeOffset+(code-start)*2;
+        if(pos+2>size)
+          break;
+        uint glyph=qFromBigEndian<quint16>(data+pos);
+        if(glyph!=0 && ((glyph+delta) & 0xffff)!=0)
+          addRange(code,code);
+        }
+      }
+    }
+}
@@ -28,6 +28,53 @@
 
 class CFontFileList;
 class CFontFileInfo;
+struct CODEPAGE_REVERSE;
+
+
+/************************************************************************************************
+ CTextEncoder: converts Unicode text to the encoding of a font, one of the CP1250 to CP1258
+               code pages or UTF-8, writing into a buffer supplied by the caller. Characters
+               the encoding doesn't have are replaced by '?'.
+ ************************************************************************************************/
+class CTextEncoder
+{
+public:
+  CTextEncoder(const quint16 *upper=0,const CODEPAGE_REVERSE *reverse=0,int reverseCount=0);
+  int maxLength(int length) const {return (m_upper==0)?length*2:length;};
+  int encode(const QChar *text,int length,char *buffer) const;
+  uint toUnicode(uchar byte) const;
+private:
+  int encodeUtf8(const QChar *text,int length,char *buffer) const;
+
+  const quint16 *m_upper;                              //characters of bytes 0x80-0xFF, 0 => UTF-8
+  const CODEPAGE_REVERSE *m_reverse;                                //sorted map back to the bytes
+  int m_reverseCount;
+};
+
+
+/************************************************************************************************
+ CFontCoverage: the characters of the Unicode Basic Multilingual Plane that a font can draw,
+                as 256 pages of 256 bits. Pages without characters take no space, and full
+                pages share one bit array.
+ ************************************************************************************************/
+class CFontCoverage
+{
+public:
+  void addRange(uint first,uint last);
+  void addCmapFormat4(const QByteArray &subtable);
+  bool contains(uint code) const;
+  bool isEmpty(void) const {return m_pages.isEmpty();};
+private:
+  QVector<QBitArray> m_pages;
+};
+
+inline bool CFontCoverage::contains(uint code) const
+{
+  if(code>0xffff || m_pages.isEmpty())
+    return false;
+  const QBitArray &page=m_pages.at(code>>8);
+  return (page.isEmpty()==false && page.testBit(code & 0xff))?true:false;
+}
 
 /************************************************************************************************
  CFontManager: maintains the relationship between fonts defined in the album and the actual
@@ -39,12 +86,58 @@ public:
   static void initialise(void);
   static bool addUserDefinedFont(CFontFileList *fontFiles,QString fontId,QString fontName,
                                  QString encoding);
+  static bool setFallbackFonts(const QStringList &fontIds);
+  static bool hasFallbackFonts(void) {return !m_fallback.isEmpty();};
+  static bool covers(int index,uint code);
+  static int fallbackFont(int index,uint code);
   static int getFontIndex(QString fontId);
   static HPDF_Font getFont(HPDF_Doc pdfDoc,int index);
-  static QTextCodec *getCodec(int index);
+  static const CTextEncoder *getEncoder(int index);
+  static double textWidth(HPDF_Font font,double fsize,const char *text,int length);
   static QString getError(void) {return m_error;};
 private:
+  static QString cachedFontFile(QString file);
+  static void freeFontCache(void);
+  static void encodingCoverage(int encoding,const CFontCoverage *font,CFontCoverage &coverage);
+
   static QString m_error;
+  static HPDF_FontCache m_fontCache;           //TTF files parsed once and shared by all documents
+  static QHash<QString,QDateTime> m_fontFileTimes;         //modification time of each cached file
+  static bool m_utfEncodings;                 //UTF-8 encoder registered with the current document
+  static QVector<int> m_fallback;                     //fonts tried in turn for missing characters
+};
+
+
+/************************************************************************************************
+ CTextRuns: a line of text split into runs by font, each run encoded for its font. Characters
+            that the font of the line can't draw are drawn with the first font of the album's
+            fallback chain that can, without a chain the whole line is a single run. The runs
+            are encoded into one buffer, which set() reuses for the next line.
+ ************************************************************************************************/
+class CTextRuns
+{
+public:
+  CTextRuns(void) {m_primary=-1; m_primaryFont=NULL; m_primaryEncoder=0;};
+  CTextRuns(HPDF_Doc pdfDoc,int findex,HPDF_Font font,const CTextEncoder *encoder,
+            const QString &text);
+  void set(HPDF_Doc pdfDoc,int findex,HPDF_Font font,const CTextEncoder *encoder,
+           const QChar *text,int length);
+  int count(void) const {return m_findex.size();};
+  int findex(int run) const {return m_findex.at(run);};
+  const char *text(int run) const {return m_buffer.constData()+m_start.at(run);};
+  int length(int run) const {return m_start.at(run+1)-m_start.at(run)-1;};
+  double width(int run,double fsize) const;
+  double width(double fsize) const;
+private:
+  void addRun(HPDF_Doc pdfDoc,int findex,const QChar *text,int length);
+
+  int m_primary;                                                                //font of the line
+  HPDF_Font m_primaryFont;
+  const CTextEncoder *m_primaryEncoder;
+  QVector<int> m_findex;                                                        //font of each run
+  QVector<HPDF_Font> m_font;
+  QVector<int> m_start;                   //offset of each run in m_buffer, then of the buffer end
+  QVector<char> m_buffer;                         //the runs encoded for their fonts, 0 terminated
 };
 
 /************************************************************************************************
@@ -57,7 +150,7 @@ public:
   CFontFileList(void){m_populated=false; m_badFontFiles=new QStringList;};
   void populate(QWidget *parent,bool includeSystemFonts);
   bool populated(void) {return m_populated;};
-  bool find(QString fontName,QString &fileName,QString &filePath);
+  bool find(QString fontName,QString &fileName,QString &filePath,CFontCoverage *coverage=0);
   int count(void) {return m_fontFileInfoRecs.count() ;};
   CFontFileInfo *at(int idx);
   QStringList *badFileList(void) {return m_badFontFiles; };
@@ -100,6 +193,8 @@ public:
   QString fileName(void) {return m_fileName;};
   QString filePath(void) {return m_filePath;};
   QString fontName(void) {return m_fontName;};
+  const CFontCoverage &coverage(void) {return m_coverage;};
+  void setCoverage(const CFontCoverage &coverage) {m_coverage=coverage;};
   void availableCodePages(QString &codePages);
 
 private:
@@ -108,6 +203,7 @@ private:
   QString m_filePath;                                                //path to the .ttf file
   quint32 m_codePageRange1;
   quint32 m_codePageRange2;
+  CFontCoverage m_coverage;                                //characters mapped by the "cmap"
 };
 
 
@@ -0,0 +1,528 @@
+/* --------------------------------------------------------------------------------------------
+ *              aeasy_layout.cpp
+ * --------------------------------------------------------------------------------------------
+ * DESCRIPTION: Page display list produced by the album layout pass, and the emitter that
+ *              writes a display list to a PDF page
+ * --------------------------------------------------------------------------------------------
+ * COPYRIGHT:   Copyright (c) 2005-2013
+ *              Clive Levinson <clivel@bundu.com>
+ *              Bundu Technology Ltd.
+ * --------------------------------------------------------------------------------------------
+ * LICENCE:     AlbumEasy is free software: you can redistribute it and/or modify it under
+ *              the terms of the GNU General Public License as published by the
+ *              Free Software Foundation, either version 3 of the License, or (at your option)
+ *              any later version.
+ * --------------------------------------------------------------------------------------------
+ * AUTHORS:     Clive Levinson
+ * -------------------------------------------------------------------------------------------- */
+
+#include "AlbumEasy.h"
+#include "aeasy_fonts.h"
+#include "aeasy_layout.h"
+
+
+/************************************************************************************************/
+void CDisplayList::clear(void)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Remove all items from the display list so that it can be reused for the next
+                page. The allocated storage is kept.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: none
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  m_items.resize(0);
+  m_coords.resize(0);
+  m_text.resize(0);
+}
+
+
+/************************************************************************************************/
+void CDisplayList::addRect(double lineWidth,double x,double y,double w,double h)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Add a stroked rectangle to the display list
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: lineWidth: width of the outline
+                     x, y: bottom left corner of the rectangle
+                     w, h: width and height of the rectangle
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  DL_ITEM item;
+
+  item.op=DL_OP_RECT;
+  item.findex=-1;
+  item.width=lineWidth;
+  item.coord=m_coords.size();
+  item.count=4;
+  item.text=-1;
+  item.form=-1;
+
+  m_coords.append(x);
+  m_coords.append(y);
+  m_coords.append(w);
+  m_coords.append(h);
+  m_items.append(item);
+}
+
+
+/************************************************************************************************/
+void CDisplayList::addPolygon(double lineWidth,const double *points,int npoints)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Add a stroked closed polygon to the display list
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: lineWidth: width of the outline
+                   points: x,y pairs of the polygon vertices
+                  npoints: number of vertices
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  DL_ITEM item;
+
+  item.op=DL_OP_POLYGON;
+  item.findex=-1;
+  item.width=lineWidth;
+  item.coord=m_coords.size();
+  item.count=npoints*2;
+  item.text=-1;
+  item.form=-1;
+
+  for(int i=0;i<npoints*2;i++)
+    m_coords.append(points[i]);
+  m_items.append(item);
+}
+
+
+/************************************************************************************************/
+void CDisplayList::addText(const CTextRuns &runs,double fsize,double x,double y)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Add a line of text that may be split into runs in different fonts, each run
+                starting where the previous one ends
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  runs: the runs of text, encoded for their fonts
+                fsize: font size
+                 x, y: start of the text base line
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  for(int i=0;i<runs.count();i++)
+    {
+    addText(runs.findex(i),fsize,x,y,runs.text(i),runs.length(i));
+    if(i<runs.count()-1)
+      x=x+runs.width(i,fsize);
+    }
+}
+
+
+/************************************************************************************************/
+void CDisplayList::addText(int findex,double fsize,double x,double y,const char *text,int length)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Add a single line run of text to the display list
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: findex: font index
+                 fsize: font size
+                  x, y: start of the text base line
+                  text: the text, encoded for the font
+                length: length of the text in bytes
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  DL_ITEM item;
+
+  item.op=DL_OP_TEXT;
+  item.findex=findex;
+  item.width=fsize;
+  item.coord=m_coords.size();
+  item.count=2;
+  item.text=m_text.size();
+  item.form=-1;
+
+  m_coords.append(x);
+  m_coords.append(y);
+  m_text.resize(item.text+length+1);
+  memcpy(m_text.data()+item.text,text,length);
+  m_text[item.text+length]=0;
+  m_items.append(item);
+}
+
+
+/************************************************************************************************/
+void CDisplayList::addForm(int form,double x,double y)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Add the placement of a form to the display list
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: form: form id in the CFormList
+                x, y: position of the bottom left corner of the form on the page
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  DL_ITEM item;
+
+  item.op=DL_OP_FORM;
+  item.findex=-1;
+  item.width=0.0;
+  item.coord=m_coords.size();
+  item.count=2;
+  item.text=-1;
+  item.form=form;
+
+  m_coords.append(x);
+  m_coords.append(y);
+  m_items.append(item);
+}
+
+
+/************************************************************************************************/
+void CFormList::clear(void)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Delete all the forms
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: none
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  while(m_lists.isEmpty()==false)
+    {
+    delete m_lists.takeFirst();
+    }
+  m_sizes.clear();
+  m_keys.clear();
+}
+
+
+/************************************************************************************************/
+int CFormList::addForm(double width,double height,double xorigin,double yorigin,
+                       const QByteArray &key)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Add a new empty form. The caller lays out the form content in the display list
+                returned by displayList(), using coordinates inside the form bounding box.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:   width: width of the form bounding box
+                 height: height of the form bounding box
+                xorigin: horizontal position in the form that is placed at the position given
+                         to CDisplayList::addForm()
+                yorigin: vertical position in the form that is placed at that position
+                    key: optional key identifying the form content, for findForm()
+   --------------------------------------------------------------------------------------------
+       RETURNS:    int: the form id
+   -------------------------------------------------------------------------------------------- */
+{
+  m_lists.append(new CDisplayList);
+  m_sizes.append(width);
+  m_sizes.append(height);
+  m_sizes.append(xorigin);
+  m_sizes.append(yorigin);
+
+  int form=m_lists.size()-1;
+  if(key.isEmpty()==false)
+    m_keys[key]=form;
+  return form;
+}
+
+
+/************************************************************************************************/
+bool CFormList::repeated(const QByteArray &key)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Record a use of some content identified by a key. Content that is only used
+                once is cheaper to draw in place, so a form is only worth creating once the
+                content is repeated.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:    key: key identifying the content
+   --------------------------------------------------------------------------------------------
+       RETURNS:   true: the content has been used before
+                 false: first use of the content
+   -------------------------------------------------------------------------------------------- */
+{
+  if(m_keys.contains(key)==true)
+    return true;
+
+  m_keys.insert(key,-1);                                          //seen, but no form created yet
+  return false;
+}
+
+
+/************************************************************************************************/
+int CFormList::findForm(const QByteArray &key)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Find the form created for some content
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: key: key identifying the content
+   --------------------------------------------------------------------------------------------
+       RETURNS: int: the form id, or -1 if no form has been created for the key
+   -------------------------------------------------------------------------------------------- */
+{
+  return m_keys.value(key,-1);
+}
+
+
+/************************************************************************************************/
+bool CPdfEmitter::emitPage(CDisplayList &dlist,HPDF_Page pdfPage)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Write all the items in the display list to the PDF page
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:   dlist: the laid out page
+                pdfPage: PDF page in the document
+   --------------------------------------------------------------------------------------------
+       RETURNS:  true: error
+                false: success
+   -------------------------------------------------------------------------------------------- */
+{
+  bool error=false;
+
+  m_error="";
+  resetState(pdfPage);                              //a new page starts with the default state
+
+  for(int i=0;i<dlist.count() && error==false;i++)
+    {
+    const DL_ITEM &item=dlist.at(i);
+    const double *c=dlist.coords(item);
+
+    if(item.op==DL_OP_RECT || item.op==DL_OP_POLYGON)
+      {
+      endText();                                       //paths may not be drawn inside BT/ET
+      setLineWidth(item.width);
+
+      if(item.op==DL_OP_RECT)
+        HPDF_Page_Rectangle(pdfPage,c[0],c[1],c[2],c[3]);
+      else                                             //a polygon is a single closed sub-path
+        {
+        HPDF_Page_MoveTo(pdfPage,c[0],c[1]);
+        for(int j=2;j<item.count;j+=2)
+          HPDF_Page_LineTo(pdfPage,c[j],c[j+1]);
+        HPDF_Page_ClosePath(pdfPage);
+        }
+                     //consecutive outlines of the same line width are painted by a single stroke
+      if(i+1>=dlist.count() || isOutline(dlist.at(i+1))==false ||
+         dlist.at(i+1).width!=item.width)
+        HPDF_Page_Stroke(pdfPage);
+      }
+    else if(item.op==DL_OP_TEXT)
+      {
+      if(setFont(item.findex,item.width)==true)
+        error=true;
+      else
+        {
+        beginText();                 //TextOut positions each run relative to the last with Td
+        HPDF_Page_TextOut(pdfPage,c[0],c[1],dlist.text(item));
+        }
+      }
+    else if(item.op==DL_OP_FORM)
+      {
+      endText();
+
+      HPDF_XObject xobj=formXObject(item.form);
+      double x=0.0;
+      double y=0.0;
+      if(xobj!=NULL)                                       //place the form origin at the position
+        {
+        x=c[0]-m_forms->xorigin(item.form);
+        y=c[1]-m_forms->yorigin(item.form);
+        }
+
+      if(xobj==NULL)
+        error=true;
+      else if(x==0.0 && y==0.0)
+        HPDF_Page_ExecuteXObject(pdfPage,xobj);
+      else                                       //translate the form to its position on the page
+        {
+        HPDF_Page_GSave(pdfPage);
+        HPDF_Page_Concat(pdfPage,1,0,0,1,x,y);
+        HPDF_Page_ExecuteXObject(pdfPage,xobj);
+        HPDF_Page_GRestore(pdfPage);
+        }
+      }
+    }
+  endText();
+
+  return error;
+}
+
+
+/************************************************************************************************/
+void HPDF_STDCALL CPdfEmitter::runParallel(HPDF_UINT count,HPDF_Task_Func func,void **tasks,
+                                           void *userData)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Parallel handler for libharu, runs the independent tasks on the thread pool
+                of the emitter and waits for all of them to complete. The pool is private to
+                the emitter, so only these tasks are waited for. libharu only calls this while
+                saving, and the tasks do not touch the document.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: count: number of tasks
+                func: function run for each task
+                tasks: the tasks
+                userData: the CPdfEmitter of the document
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  QThreadPool *pool=&((CPdfEmitter *)userData)->m_pool;
+  if(pool->maxThreadCount()<2 || count<2)                  //nothing to gain from the thread pool
+    {
+    for(HPDF_UINT i=0;i<count;i++)
+      func(tasks[i]);
+    return;
+    }
+
+  for(HPDF_UINT i=0;i<count;i++)
+    pool->start(new CPdfTask(func,tasks[i]));                  //the pool deletes the task when done
+  pool->waitForDone();
+}
+
+
+/************************************************************************************************/
+HPDF_XObject CPdfEmitter::formXObject(int form)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Get the Form XObject for a form, writing it to the PDF document the first time
+                that it is used
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: form: form id in the CFormList
+   --------------------------------------------------------------------------------------------
+       RETURNS: HPDF_XObject: the form
+                        NULL: error
+   -------------------------------------------------------------------------------------------- */
+{
+  if(m_forms==0 || form<0 || form>=m_forms->count())
+    {
+    m_error=TR("Reference to an undefined form.");
+    return NULL;
+    }
+
+  while(m_xobjects.size()<=form)
+    m_xobjects.append(NULL);
+
+  if(m_xobjects.at(form)==NULL)                                //if not yet written, write it now
+    {
+    HPDF_Page canvas=HPDF_BeginForm(m_pdfDoc,m_forms->width(form),m_forms->height(form));
+    if(canvas==NULL)
+      m_error=TR("Unable to create a PDF form object.");
+    else
+      {
+      EMITTER_STATE pageState=m_state;        //the form has its own graphics state, so save the
+                                              //state of the page that the form is placed on
+      QString pageError=m_error;
+      bool error=emitPage(m_forms->displayList(form),canvas);
+      m_state=pageState;
+
+      HPDF_XObject xobj=HPDF_EndForm(m_pdfDoc,canvas);
+      if(error==false)
+        {
+        m_error=pageError;
+        m_xobjects[form]=xobj;
+        }
+      }
+    }
+
+  return m_xobjects.at(form);
+}
+
+
+/************************************************************************************************/
+void CPdfEmitter::resetState(HPDF_Page pdfPage)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Forget the tracked graphics state, used when starting a new page
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: pdfPage: the page about to be written
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  m_state.pdfPage=pdfPage;
+  m_state.lineWidth=-1.0;
+  m_state.findex=-1;
+  m_state.fsize=0.0;
+  m_state.inText=false;
+}
+
+
+/************************************************************************************************/
+void CPdfEmitter::setLineWidth(double lineWidth)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Set the line width, only writing the operator if it has changed
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: lineWidth: the line width
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  if(lineWidth!=m_state.lineWidth)
+    {
+    HPDF_Page_SetLineWidth(m_state.pdfPage,lineWidth);
+    m_state.lineWidth=lineWidth;
+    }
+}
+
+
+/************************************************************************************************/
+bool CPdfEmitter::setFont(int findex,double fsize)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Select the font and size, only writing the operator if either has changed
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: findex: font index
+                 fsize: font size
+   --------------------------------------------------------------------------------------------
+       RETURNS:  true: error, the font could not be loaded
+                false: success
+   -------------------------------------------------------------------------------------------- */
+{
+  bool error=false;
+
+  if(findex!=m_state.findex || fsize!=m_state.fsize)
+    {
+    HPDF_Font font=CFontManager::getFont(m_pdfDoc,findex);
+    if(font==NULL)
+      {
+      error=true;
+      m_error=CFontManager::getError();
+      }
+    else
+      {
+      HPDF_Page_SetFontAndSize(m_state.pdfPage,font,fsize); //valid both inside and outside BT/ET
+      m_state.findex=findex;
+      m_state.fsize=fsize;
+      }
+    }
+  return error;
+}
+
+
+/************************************************************************************************/
+void CPdfEmitter::beginText(void)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Open a text object if one is not already open
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: none
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  if(m_state.inText==false)
+    {
+    HPDF_Page_BeginText(m_state.pdfPage);
+    m_state.inText=true;
+    }
+}
+
+
+/************************************************************************************************/
+void CPdfEmitter::endText(void)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Close the text object if one is open
+   --------------------------------------------------------------------------------------------
+    PARAMETERS: none
+   --------------------------------------------------------------------------------------------
+       RETURNS: none
+   -------------------------------------------------------------------------------------------- */
+{
+  if(m_state.inText==true)
+    {
+    HPDF_Page_EndText(m_state.pdfPage);
+    m_state.inText=false;
+    }
+}
@@ -0,0 +1,247 @@
+/* --------------------------------------------------------------------------------------------
+ *              aeasy_layout.h
+ * --------------------------------------------------------------------------------------------
+ * DESCRIPTION: Page display list produced by the album layout pass, and the emitter that
+ *              writes a display list to a PDF page
+ * --------------------------------------------------------------------------------------------
+ * COPYRIGHT:   Copyright (c) 2005-2013
+ *              Clive Levinson <clivel@bundu.com>
+ *              Bundu Technology Ltd.
+ * --------------------------------------------------------------------------------------------
+ * LICENCE:     AlbumEasy is free software: you can redistribute it and/or modify it under
+ *              the terms of the GNU General Public License as published by the
+ *              Free Software Foundation, either version 3 of the License, or (at your option)
+ *              any later version.
+ * --------------------------------------------------------------------------------------------
+ * AUTHORS:     Clive Levinson
+ * -------------------------------------------------------------------------------------------- */
+
+#ifndef _AEASY_LAYOUT_H_
+#define _AEASY_LAYOUT_H_
+
+#include "AlbumEasy.h"
+#include <hpdf.h>
+
+class CTextRuns;
+
+
+enum DL_OP
+  {
+  DL_OP_RECT,                                                          //stroked rectangle outline
+  DL_OP_POLYGON,                                                         //stroked polygon outline
+  DL_OP_TEXT,                                                          //single line run of text
+  DL_OP_FORM                                                     //placement of a shared form
+  };
+
+
+struct DL_ITEM
+{
+  DL_OP op;
+  int findex;                                                  //font index (text items only)
+  double width;                                                //line width, or font size for text
+  int coord;                                                   //index of first coordinate
+  int count;                                                   //number of coordinates
+  int text;                                                    //offset of the text (text only)
+  int form;                                                    //form id (form items only)
+};
+
+
+/************************************************************************************************
+CDisplayList: the positioned rectangles, polygons and text runs making up one album page.
+              Coordinates are in PDF points, text is already encoded for the font.
+************************************************************************************************/
+
+class CDisplayList
+{
+public:
+  void clear(void);
+  void addRect(double lineWidth,double x,double y,double w,double h);
+  void addPolygon(double lineWidth,const double *points,int npoints);
+  void addText(int findex,double fsize,double x,double y,const char *text,int length);
+  void addText(const CTextRuns &runs,double fsize,double x,double y);
+  void addForm(int form,double x,double y);
+  int count(void);
+  const DL_ITEM &at(int index);
+  const double *coords(const DL_ITEM &item);
+  const char *text(const DL_ITEM &item);
+private:
+  QVector<DL_ITEM> m_items;
+  QVector<double> m_coords;
+  QVector<char> m_text;                                        //all the text, each 0 terminated
+};
+
+inline int CDisplayList::count(void)
+{
+  return m_items.size();
+}
+
+inline const DL_ITEM &CDisplayList::at(int index)
+{
+  return m_items.at(index);
+}
+
+inline const double *CDisplayList::coords(const DL_ITEM &item)
+{
+  return m_coords.constData()+item.coord;
+}
+
+inline const char *CDisplayList::text(const DL_ITEM &item)
+{
+  return m_text.constData()+item.text;
+}
+
+
+/************************************************************************************************
+CFormList: display lists for content that is drawn once into a PDF Form XObject and then placed
+           on many pages, such as the page border and title, or repeated stamps. Forms are
+           identified by their index in the list, and can also be looked up by a key describing
+           their content.
+************************************************************************************************/
+
+class CFormList
+{
+public:
+  ~CFormList();
+  void clear(void);
+  int addForm(double width,double height,double xorigin=0.0,double yorigin=0.0,
+              const QByteArray &key=QByteArray());
+  bool repeated(const QByteArray &key);
+  int findForm(const QByteArray &key);
+  int count(void);
+  CDisplayList &displayList(int form);
+  double width(int form);
+  double height(int form);
+  double xorigin(int form);
+  double yorigin(int form);
+private:
+  QList<CDisplayList *> m_lists;
+  QVector<double> m_sizes;                                  //width,height,xorigin,yorigin per form
+  QHash<QByteArray,int> m_keys;                             //form id by key, -1 => no form yet
+};
+
+inline CFormList::~CFormList()
+{
+  clear();
+}
+
+inline int CFormList::count(void)
+{
+  return m_lists.size();
+}
+
+inline CDisplayList &CFormList::displayList(int form)
+{
+  return *m_lists.at(form);
+}
+
+inline double CFormList::width(int form)
+{
+  return m_sizes.at(form*4);
+}
+
+inline double CFormList::height(int form)
+{
+  return m_sizes.at(form*4+1);
+}
+
+inline double CFormList::xorigin(int form)
+{
+  return m_sizes.at(form*4+2);
+}
+
+inline double CFormList::yorigin(int form)
+{
+  return m_sizes.at(form*4+3);
+}
+
+
+/************************************************************************************************
+CPdfTask: runs one libharu task, such as deflating a stream, on a thread pool.
+************************************************************************************************/
+
+class CPdfTask : public QRunnable
+{
+public:
+  CPdfTask(HPDF_Task_Func func,void *task);
+  void run(void);
+private:
+  HPDF_Task_Func m_func;
+  void *m_task;
+};
+
+inline CPdfTask::CPdfTask(HPDF_Task_Func func,void *task)
+{
+  m_func=func;
+  m_task=task;
+}
+
+inline void CPdfTask::run(void)
+{
+  m_func(m_task);
+}
+
+
+/************************************************************************************************
+CPdfEmitter: writes the contents of a display list to a PDF page.
+             Tracks the graphics state of the page so that line width and font operators are
+             only written when they change, and consecutive text runs share one text object.
+             Forms are written to the PDF the first time they are placed on a page.
+             runParallel is the libharu handler which deflates the page streams on the
+             emitter's own thread pool while the document is saved.
+************************************************************************************************/
+
+struct EMITTER_STATE
+{
+  HPDF_Page pdfPage;                                           //page or form being written
+  double lineWidth;                                            //current line width, <0 => unset
+  int findex;                                                  //current font, <0 => unset
+  double fsize;                                                //current font size
+  bool inText;                                                 //true => inside a BT/ET block
+};
+
+
+class CPdfEmitter
+{
+public:
+  CPdfEmitter(HPDF_Doc pdfDoc,CFormList *forms=0);
+  bool emitPage(CDisplayList &dlist,HPDF_Page pdfPage);
+  QString getError(void);
+  static void HPDF_STDCALL runParallel(HPDF_UINT count,HPDF_Task_Func func,void **tasks,
+                                       void *userData);
+private:
+  static bool isOutline(const DL_ITEM &item);
+  HPDF_XObject formXObject(int form);
+  void resetState(HPDF_Page pdfPage);
+  void setLineWidth(double lineWidth);
+  bool setFont(int findex,double fsize);
+  void beginText(void);
+  void endText(void);
+private:
+  HPDF_Doc m_pdfDoc;
+  CFormList *m_forms;
+  QVector<HPDF_XObject> m_xobjects;                            //forms already written, by form id
+  EMITTER_STATE m_state;
+  QString m_error;
+  QThreadPool m_pool;                                     //runs the deflate tasks of this document
+};
+
+
+inline CPdfEmitter::CPdfEmitter(HPDF_Doc pdfDoc,CFormList *forms)
+{
+  m_pdfDoc=pdfDoc;
+  m_forms=forms;
+  resetState(NULL);
+}
+
+inline QString CPdfEmitter::getError(void)
+{
+  return m_error;
+}
+
+inline bool CPdfEmitter::isOutline(const DL_ITEM &item)
+{
+  return (item.op==DL_OP_RECT || item.op==DL_OP_POLYGON)?true:false;
+}
+
+
+#endif // _AEASY_LAYOUT_H_
@@ -47,6 +47,11 @@ COMMAND_MAP commandMap[]=
   {"ALBUM_PAGES_SPACING",    &CParser::processPageSpacingCommand},
   {"ALBUM_PAGES_TITLE",      &CParser::processPageTitleCommand},
   {"ALBUM_DEFINE_FONT",      &CParser::processDefineFontCommand},
+  {"ALBUM_FONT_FALLBACK",    &CParser::processFontFallbackCommand},
+  {"ALBUM_COMPRESSION",      &CParser::processCompressionCommand},
+  {"ALBUM_OBJECT_STREAMS",   &CParser::processObjectStreamsCommand},
+  {"ALBUM_FAST_WEB_VIEW",    &CParser::processFastWebViewCommand},
+  {"ALBUM_MEMORY_BUDGET",    &CParser::processMemoryBudgetCommand},
   {"PAGE_START",             &CParser::processPageStartCommand},
   {"PAGE_START_VAR",         &CParser::processPageStartCommand},
   {"PAGE_TEXT",              &CParser::processPageTextCommand},
@@ -753,6 +758,121 @@ bool CParser::processPageTitleCommand(QString cmnd,QString parms)
   return error;
 }
 
+/************************************************************************************************/
+bool CParser::processCompressionCommand(QString cmnd,QString parms)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Process command:
+                ALBUM_COMPRESSION (mode)
+                mode is one of NONE, FAST, BALANCED or MAX
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  cmnd: The command to process
+                parms: The command parameters
+   --------------------------------------------------------------------------------------------
+       RETURNS:  true: error
+                false: success
+   -------------------------------------------------------------------------------------------- */
+{
+  bool error=false;
+
+  QString mode;
+  extractParameterField(parms,mode,true);
+
+  if(parms.size()>0)                                                       //only a single parameter
+    error=true;
+  else if(mode=="NONE")
+    m_albumData->setCompression(PDF_COMPRESSION_NONE);
+  else if(mode=="FAST")
+    m_albumData->setCompression(PDF_COMPRESSION_FAST);
+  else if(mode=="BALANCED")
+    m_albumData->setCompression(PDF_COMPRESSION_BALANCED);
+  else if(mode=="MAX")
+    m_albumData->setCompression(PDF_COMPRESSION_MAX);
+  else
+    error=true;
+
+  if(error==true)
+    {
+    displayError(m_currentLine,
+                 tr("%1 command - The compression must be one of NONE, FAST, BALANCED or MAX.")
+                 .arg(cmnd));
+    }
+
+  return error;
+}
+
+/************************************************************************************************/
+bool CParser::processObjectStreamsCommand(QString cmnd,QString parms)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Process command:
+                ALBUM_OBJECT_STREAMS
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  cmnd: The command to process
+                parms: The command parameters
+   --------------------------------------------------------------------------------------------
+       RETURNS:  true: error
+                false: success
+   -------------------------------------------------------------------------------------------- */
+{
+  bool error=false;
+
+  if((error=parseBlankParameters(cmnd,parms))==false)
+    m_albumData->setObjectStreams(true);
+
+  return error;
+}
+
+/************************************************************************************************/
+bool CParser::processFastWebViewCommand(QString cmnd,QString parms)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Process command:
+                ALBUM_FAST_WEB_VIEW
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  cmnd: The command to process
+                parms: The command parameters
+   --------------------------------------------------------------------------------------------
+       RETURNS:  true: error
+                false: success
+   -------------------------------------------------------------------------------------------- */
+{
+  bool error=false;
+
+  if((error=parseBlankParameters(cmnd,parms))==false)
+    m_albumData->setFastWebView(true);
+
+  return error;
+}
+
+/************************************************************************************************/
+bool CParser::processMemoryBudgetCommand(QString cmnd,QString parms)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Process command:
+                ALBUM_MEMORY_BUDGET (megabytes)
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  cmnd: The command to process
+                parms: The command parameters
+   --------------------------------------------------------------------------------------------
+       RETURNS:  true: error
+                false: success
+   -------------------------------------------------------------------------------------------- */
+{
+  bool error=false;
+
+  double vals[1];
+  int n=parseDoubleParameters(cmnd,parms,1,vals,false);
+  if(n!=1 || vals[0]<1.0 || vals[0]>=PDF_MAX_MEMORY_BUDGET+1.0)
+    {
+    error=true;
+    displayError(m_currentLine,
+                 tr("%1 command - The memory budget must be from 1 to %2 megabytes.")
+                 .arg(cmnd).arg(PDF_MAX_MEMORY_BUDGET));
+    }
+  else
+    m_albumData->setMemoryBudget((int)vals[0]);
+
+  return error;
+}
+
+
 /************************************************************************************************/
 bool CParser::processDefineFontCommand(QString cmnd,QString parms)
 /* --------------------------------------------------------------------------------------------
@@ -807,6 +927,47 @@ bool CParser::processDefineFontCommand(QString cmnd,QString parms)
 }
 
 
+/************************************************************************************************/
+bool CParser::processFontFallbackCommand(QString cmnd,QString parms)
+/* --------------------------------------------------------------------------------------------
+   DESCRIPTION: Process command:
+                ALBUM_FONT_FALLBACK (fontId fontId ...)
+                                    one or more fonts, tried in turn for the characters that
+                                    the font of a text item can't draw.
+   --------------------------------------------------------------------------------------------
+    PARAMETERS:  cmnd: The command to process
+                parms: The command parameters
+   --------------------------------------------------------------------------------------------
+       RETURNS:  true: error
+                false: success
+   -------------------------------------------------------------------------------------------- */
+{
+  bool error=false;
+
+  QStringList fontIds;
+  QString fontId;
+
+  extractParameterField(parms,fontId,true);
+  while(fontId.size()>0)                                                    //get all the font ids
+    {
+    fontIds.append(fontId);
+    extractParameterField(parms,fontId,true);
+    }
+
+  if(fontIds.isEmpty())
+    {
+    error=true;
+    displayError(m_currentLine,tr("%1 command - No font provided.").arg(cmnd));
+    }
+  else if((error=CFontManager::setFallbackFonts(fontIds))==true)
+    {
+    displayError(m_currentLine,tr("%1 command - %2").arg(cmnd).arg(CFontManager::getError()));
+    }
+
+  return error;
+}
+
+
 /************************************************************************************************/
 bool CParser::processPageStartCommand(QString cmnd,QString parms)
 /* --------------------------------------------------------------------------------------------
@@ -60,6 +60,12 @@ public:
   bool processPageSpacingCommand(QString cmnd,QString parms);
   bool processPageTitleCommand(QString cmnd,QString parms);
   bool processDefineFontCommand(QString cmnd,QString parms);
+  bool processFontFallbackCommand(QString cmnd,QString parms);
+  bool processCompressionCommand(QString cmnd,QString parms);
+  bool processObjectStreamsCommand(QString cmnd,QString parms);
+  bool processFastWebViewCommand(QString cmnd,QString parms);
+  bool processMemoryBudgetCommand(QString cmnd,QString parms);
+
   bool processPageStartCommand(QString cmnd,QString parms);
   bool processPageTextCommand(QString cmnd,QString parms);
   bool processRowAlignCommand(QString cmnd,QString parms);
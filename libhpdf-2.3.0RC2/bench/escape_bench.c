@@ -0,0 +1,292 @@
+/*
+ * << Haru Free PDF Library >> -- escape_bench.c
+ *
+ * URL: http://libharu.org
+ *
+ * Benchmark of HPDF_Stream_WriteEscapeText2 against the byte by byte
+ * routine it replaced, over the quoted strings of an AlbumEasy source
+ * file (tests/V30Compliance.txt by default). Every string escaped by
+ * either routine is also read back and compared with the original, as
+ * are strings of random bytes of lengths up to 600.
+ *
+ * usage: escape_bench [album source file] [iterations]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hpdf.h"
+#include "hpdf_utils.h"
+#include "hpdf_streams.h"
+
+#define MAX_STRINGS     4096
+#define OUT_BUF_SIZE    (4 * 1024 * 1024)
+
+static char *strings[MAX_STRINGS];
+static HPDF_UINT lengths[MAX_STRINGS];
+static HPDF_UINT count = 0;
+
+static HPDF_BYTE out_buf[OUT_BUF_SIZE];
+static HPDF_UINT out_len = 0;
+
+
+/* writer callback collecting the escaped text */
+static HPDF_STATUS
+CollectOutput  (HPDF_Stream       stream,
+                const HPDF_BYTE  *ptr,
+                HPDF_UINT         siz)
+{
+    (void)stream;
+
+    if (out_len + siz > OUT_BUF_SIZE)
+        out_len = 0;
+
+    memcpy (out_buf + out_len, ptr, siz);
+    out_len += siz;
+
+    return HPDF_OK;
+}
+
+
+/* HPDF_Stream_WriteEscapeText2 as it was before the bulk copy */
+static HPDF_STATUS
+OldWriteEscapeText2  (HPDF_Stream    stream,
+                      const char    *text,
+                      HPDF_UINT      len)
+{
+    char buf[HPDF_TEXT_DEFAULT_LEN];
+    HPDF_UINT idx = 0;
+    HPDF_INT i;
+    const char* p = text;
+    HPDF_STATUS ret;
+
+    buf[idx++] = '(';
+
+    for (i = 0; i < (HPDF_INT)len; i++) {
+        HPDF_BYTE c = (HPDF_BYTE)*p++;
+        if (HPDF_NEEDS_ESCAPE(c)) {
+            buf[idx++] = '\\';
+
+            buf[idx] = (char)(c >> 6);
+            buf[idx] += 0x30;
+            idx++;
+            buf[idx] = (char)((c & 0x38) >> 3);
+            buf[idx] += 0x30;
+            idx++;
+            buf[idx] = (char)(c & 0x07);
+            buf[idx] += 0x30;
+            idx++;
+        }
+        else
+            buf[idx++] = c;
+
+        if (idx > HPDF_TEXT_DEFAULT_LEN - 4) {
+            ret = HPDF_Stream_Write (stream, (HPDF_BYTE *)buf, idx);
+            if (ret != HPDF_OK)
+                return ret;
+            idx = 0;
+        }
+    }
+    buf[idx++] = ')';
+
+    return HPDF_Stream_Write (stream, (HPDF_BYTE *)buf, idx);
+}
+
+
+/* read a literal string back, returns its length or -1 if malformed */
+static int
+ReadLiteral  (const HPDF_BYTE  *s,
+              HPDF_UINT         n,
+              HPDF_BYTE        *out)
+{
+    HPDF_UINT i = 1;
+    int o = 0;
+
+    if (n < 2 || s[0] != '(' || s[n - 1] != ')')
+        return -1;
+
+    while (i < n - 1) {
+        HPDF_BYTE c = s[i++];
+
+        if (c == '\\') {
+            c = s[i++];
+            if (c >= '0' && c <= '7') {
+                int v = c - '0';
+
+                if (i + 2 > n - 1)
+                    return -1;
+                v = v * 8 + (s[i++] - '0');
+                v = v * 8 + (s[i++] - '0');
+                out[o++] = (HPDF_BYTE)v;
+            } else if (c == '(' || c == ')' || c == '\\')
+                out[o++] = c;
+            else
+                return -1;
+        } else {
+            if (c == '(' || c == ')')
+                return -1;
+            out[o++] = c;
+        }
+    }
+
+    return o;
+}
+
+
+/* escape a string with both routines and check that each reads back */
+static int
+CheckRoundTrip  (HPDF_Stream   stream,
+                 const char   *text,
+                 HPDF_UINT     len)
+{
+    static HPDF_BYTE decoded[OUT_BUF_SIZE];
+    int pass;
+
+    for (pass = 0; pass < 2; pass++) {
+        out_len = 0;
+        if (pass == 0)
+            HPDF_Stream_WriteEscapeText2 (stream, text, len);
+        else
+            OldWriteEscapeText2 (stream, text, len);
+
+        if (ReadLiteral (out_buf, out_len, decoded) != (int)len ||
+                memcmp (decoded, text, len) != 0) {
+            printf ("round trip failed (%s routine, %u bytes)\n",
+                    (pass == 0) ? "new" : "old", len);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/* collect the quoted strings of an album source file */
+static void
+LoadStrings  (const char  *file_name)
+{
+    static char text[256 * 1024];
+    FILE *f = fopen (file_name, "rb");
+    size_t n;
+    size_t i;
+
+    if (!f) {
+        printf ("unable to open %s\n", file_name);
+        exit (1);
+    }
+    n = fread (text, 1, sizeof(text) - 1, f);
+    fclose (f);
+
+    for (i = 0; i < n && count < MAX_STRINGS; i++) {
+        char *s;
+        HPDF_UINT len = 0;
+
+        if (text[i] == '#') {                     /* skip comments */
+            while (i < n && text[i] != '\n')
+                i++;
+            continue;
+        }
+        if (text[i] != '"')
+            continue;
+
+        s = malloc (n);
+        for (i++; i < n && text[i] != '"'; i++) {
+            if (text[i] == '\\' && i + 1 < n) {
+                i++;
+                s[len++] = (text[i] == 'n') ? '\n' : text[i];
+            } else
+                s[len++] = text[i];
+        }
+        strings[count] = s;
+        lengths[count] = len;
+        count++;
+    }
+}
+
+
+static double
+Time  (HPDF_Stream  stream,
+       HPDF_BOOL    old_routine,
+       int          iterations)
+{
+    clock_t start = clock ();
+    int it;
+    HPDF_UINT i;
+
+    for (it = 0; it < iterations; it++) {
+        for (i = 0; i < count; i++) {
+            if (old_routine)
+                OldWriteEscapeText2 (stream, strings[i], lengths[i]);
+            else
+                HPDF_Stream_WriteEscapeText2 (stream, strings[i], lengths[i]);
+        }
+        out_len = 0;
+    }
+
+    return (double)(clock () - start) / CLOCKS_PER_SEC;
+}
+
+
+int
+main  (int     argc,
+       char  **argv)
+{
+    const char *file_name = (argc > 1) ? argv[1] :
+            "../../tests/V30Compliance.txt";
+    int iterations = (argc > 2) ? atoi (argv[2]) : 20000;
+    HPDF_Error_Rec error;
+    HPDF_MMgr mmgr;
+    HPDF_Stream stream;
+    HPDF_UINT i;
+    HPDF_UINT bytes = 0;
+    char random[600];
+    int failed = 0;
+    double t_old;
+    double t_new;
+
+    HPDF_Error_Init (&error, NULL);
+    mmgr = HPDF_MMgr_New (&error, 0, NULL, NULL);
+    stream = HPDF_CallbackWriter_New (mmgr, CollectOutput, NULL);
+
+    LoadStrings (file_name);
+    for (i = 0; i < count; i++) {
+        bytes += lengths[i];
+        failed |= CheckRoundTrip (stream, strings[i], lengths[i]);
+    }
+
+    /* random bytes, including runs long enough to be written directly */
+    srand (1);
+    for (i = 0; i < 20000 && !failed; i++) {
+        HPDF_UINT len = (HPDF_UINT)(i % sizeof(random));
+        HPDF_UINT j;
+        int mode = rand () % 3;
+
+        for (j = 0; j < len; j++) {
+            if (mode == 0)
+                random[j] = (char)(rand () % 256);
+            else if (mode == 1)
+                random[j] = (char)(0x20 + rand () % 95);
+            else
+                random[j] = (rand () % 50) ? (char)('a' + rand () % 26) :
+                        "()\\\n\351"[rand () % 5];
+        }
+        failed |= CheckRoundTrip (stream, random, len);
+    }
+
+    printf ("%u strings, %u bytes from %s\n", count, bytes, file_name);
+    printf ("round trip: %s\n", failed ? "FAILED" : "ok");
+
+    t_old = Time (stream, HPDF_TRUE, iterations);
+    t_new = Time (stream, HPDF_FALSE, iterations);
+    printf ("old routine: %.3f s, new routine: %.3f s, %.2fx\n",
+            t_old, t_new, (t_new > 0) ? t_old / t_new : 0.0);
+
+    HPDF_Stream_Free (stream);
+    HPDF_MMgr_Free (mmgr);
+    for (i = 0; i < count; i++)
+        free (strings[i]);
+
+    return failed;
+}
@@ -0,0 +1,211 @@
+/*
+ * << Haru Free PDF Library >> -- ftoa_bench.c
+ *
+ * URL: http://libharu.org
+ *
+ * Microbenchmark of HPDF_FToA against the digit by digit routine it
+ * replaced. Both are run over the same random values, typical of page
+ * coordinates, font sizes and colours, and the outputs are compared:
+ * every value written by HPDF_FToA must read back as the value rounded
+ * to HPDF_REAL_PRECISION decimals. The timed calls write into a buffer
+ * of HPDF_TMP_BUF_SIZ, as the page operators do.
+ *
+ * Build with -DHPDF_REAL_PRECISION=n to check another precision.
+ *
+ * usage: ftoa_bench [count] [iterations]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "hpdf.h"
+#include "hpdf_conf.h"
+#include "hpdf_utils.h"
+
+
+/* HPDF_FToA as it was before the single rounding */
+static char*
+OldFToA  (char       *s,
+          HPDF_REAL   val,
+          char       *eptr)
+{
+    HPDF_INT32 int_val;
+    HPDF_INT32 fpart_val;
+    char buf[HPDF_REAL_LEN + 1];
+    char* sptr = s;
+    char* t;
+    HPDF_UINT32 i;
+
+    if (val > HPDF_LIMIT_MAX_REAL)
+        val = HPDF_LIMIT_MAX_REAL;
+    else
+    if (val < HPDF_LIMIT_MIN_REAL)
+        val = HPDF_LIMIT_MIN_REAL;
+
+    t = buf + HPDF_REAL_LEN;
+    *t-- = 0;
+
+    if (val < 0) {
+        *s++ = '-';
+        val = -val;
+    }
+
+    /* separate an integer part and a decimal part. */
+    int_val = (HPDF_INT32)(val + 0.000005);
+    fpart_val = (HPDF_INT32)((HPDF_REAL)(val - int_val + 0.000005) * 100000);
+
+    /* process decimal part */
+    for (i = 0; i < 5; i++) {
+        *t = (char)((char)(fpart_val % 10) + '0');
+        fpart_val /= 10;
+        t--;
+    }
+
+    /* process integer part */
+    *t-- = '.';
+    *t = '0';
+    if (int_val == 0)
+        t--;
+
+    while (int_val > 0) {
+        *t = (char)((char)(int_val % 10) + '0');
+        int_val /= 10;
+        t--;
+    }
+
+    t++;
+    while (s <= eptr && *t != 0)
+        *s++ = *t++;
+    s--;
+
+    /* delete an excessive decimal portion. */
+    while (s > sptr) {
+        if (*s == '0')
+            *s = 0;
+        else {
+            if (*s == '.')
+                *s = 0;
+            break;
+        }
+        s--;
+    }
+
+    return (*s == 0) ? s : ++s;
+}
+
+
+/* a value as found in a content stream */
+static HPDF_REAL
+RandomValue  (void)
+{
+    double r = (double)rand () / RAND_MAX;
+
+    switch (rand () % 5) {
+        case 0:                                     /* whole points */
+            return (HPDF_REAL)(int)(r * 842);
+        case 1:                                     /* millimetres */
+            return (HPDF_REAL)(r * 297 * 72 / 25.4);
+        case 2:                                     /* colours, ratios */
+            return (HPDF_REAL)r;
+        case 3:                                     /* two decimals */
+            return (HPDF_REAL)((int)(r * 84200) / 100.0);
+        default:                                    /* anything in range */
+            return (HPDF_REAL)((r - 0.5) * 2 * 40000);
+    }
+}
+
+
+static double
+Time  (HPDF_REAL   *values,
+       HPDF_UINT    count,
+       HPDF_BOOL    old_routine,
+       int          iterations)
+{
+    char buf[HPDF_TMP_BUF_SIZ];
+    char *eptr = buf + HPDF_TMP_BUF_SIZ - 1;
+    clock_t start = clock ();
+    HPDF_UINT32 sum = 0;
+    HPDF_UINT i;
+    int it;
+
+    for (it = 0; it < iterations; it++) {
+        for (i = 0; i < count; i++) {
+            char *p = old_routine ? OldFToA (buf, values[i], eptr) :
+                    HPDF_FToA (buf, values[i], eptr);
+            sum += (HPDF_UINT32)(p - buf);
+        }
+    }
+    if (sum == 0)
+        printf ("no output\n");
+
+    return (double)(clock () - start) / CLOCKS_PER_SEC;
+}
+
+
+int
+main  (int     argc,
+       char  **argv)
+{
+    HPDF_UINT count = (argc > 1) ? (HPDF_UINT)atoi (argv[1]) : 1000000;
+    int iterations = (argc > 2) ? atoi (argv[2]) : 10;
+    HPDF_REAL *values = malloc (count * sizeof(HPDF_REAL));
+    HPDF_UINT same = 0;
+    HPDF_UINT shorter = 0;
+    HPDF_UINT failed = 0;
+    HPDF_UINT i;
+    double t_old;
+    double t_new;
+
+    srand (1);
+    for (i = 0; i < count; i++)
+        values[i] = RandomValue ();
+
+    for (i = 0; i < count; i++) {
+        char old_buf[HPDF_REAL_LEN + 2];
+        char new_buf[HPDF_REAL_LEN + 2];
+        char long_buf[HPDF_TMP_BUF_SIZ];
+        HPDF_REAL val = values[i];
+        double clamped = (val > HPDF_LIMIT_MAX_REAL) ? HPDF_LIMIT_MAX_REAL :
+                (val < HPDF_LIMIT_MIN_REAL) ? HPDF_LIMIT_MIN_REAL : val;
+        double scale = pow (10, HPDF_REAL_PRECISION);
+        HPDF_REAL rounded = (HPDF_REAL)(floor (fabs (clamped) * scale + 0.5) /
+                scale * ((clamped < 0) ? -1 : 1));
+        HPDF_REAL read_back;
+
+        /* like the library, zero the buffers first: the old routine does
+         * not terminate an output that fills them */
+        memset (old_buf, 0, sizeof(old_buf));
+        memset (new_buf, 0, sizeof(new_buf));
+        OldFToA (old_buf, val, old_buf + HPDF_REAL_LEN);
+        HPDF_FToA (new_buf, val, new_buf + HPDF_REAL_LEN);
+        HPDF_FToA (long_buf, val, long_buf + HPDF_TMP_BUF_SIZ - 1);
+        read_back = (HPDF_REAL)strtod (new_buf, NULL);
+
+        /* the output must not depend on the room left in the buffer */
+        if (read_back != rounded || strcmp (new_buf, long_buf) != 0) {
+            if (failed++ < 10)
+                printf ("%.9g: old %s, new %s\n", val, old_buf, new_buf);
+        }
+
+        if (strcmp (old_buf, new_buf) == 0)
+            same++;
+        else if (strlen (new_buf) < strlen (old_buf))
+            shorter++;
+    }
+
+    printf ("%u values, precision %d: %u identical, %u shorter, "
+            "%u mismatches\n", count, HPDF_REAL_PRECISION, same, shorter,
+            failed);
+
+    t_old = Time (values, count, HPDF_TRUE, iterations);
+    t_new = Time (values, count, HPDF_FALSE, iterations);
+    printf ("old routine: %.3f s, new routine: %.3f s, %.2fx\n",
+            t_old, t_new, (t_new > 0) ? t_old / t_new : 0.0);
+
+    free (values);
+
+    return failed != 0;
+}
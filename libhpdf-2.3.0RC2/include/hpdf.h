@@ -69,6 +69,7 @@ typedef HPDF_HANDLE   HPDF_XObject;
 typedef HPDF_HANDLE   HPDF_Annotation;
 typedef HPDF_HANDLE   HPDF_ExtGState;
 typedef HPDF_HANDLE   HPDF_FontDef;
+typedef HPDF_HANDLE   HPDF_FontCache;
 typedef HPDF_HANDLE   HPDF_U3D;
 typedef HPDF_HANDLE   HPDF_JavaScript;
 typedef HPDF_HANDLE   HPDF_Error;
@@ -163,6 +164,42 @@ HPDF_SaveToFile  (HPDF_Doc     pdf,
                   const char  *file_name);
 
 
+/* write the document through write_fn, called with the contents of the
+ * output buffer each time it is full and once at the end */
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SaveToWriter  (HPDF_Doc         pdf,
+                    HPDF_Write_Func  write_fn,
+                    void             *user_data);
+
+
+/* size of the buffer the output of HPDF_SaveToFile, HPDF_SaveToWriter and
+ * HPDF_BeginStreamToFile is collected in, each full buffer is written at
+ * once. 0 writes everything as it is produced */
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetOutputBufferSize  (HPDF_Doc    pdf,
+                           HPDF_UINT   size);
+
+
+/* write the document to a file while it is being built, to bound the
+ * memory used by large documents. HPDF_FlushPages writes the pages added so
+ * far and releases their contents, nothing more can be drawn on them.
+ * the fonts, images and other shared objects, the page tree and the
+ * cross-reference table are written by HPDF_EndStreamToFile. linearized
+ * output and object streams are not used, and pages are not written until
+ * the end for encrypted documents */
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_BeginStreamToFile  (HPDF_Doc     pdf,
+                         const char  *file_name);
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_FlushPages  (HPDF_Doc     pdf);
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_EndStreamToFile  (HPDF_Doc     pdf);
+
+
 HPDF_EXPORT(HPDF_STATUS)
 HPDF_GetError  (HPDF_Doc   pdf);
 
@@ -183,6 +220,13 @@ HPDF_SetPagesConfiguration  (HPDF_Doc    pdf,
                              HPDF_UINT   page_per_pages);
 
 
+/* add pages to a balanced page tree in which each node has at most fanout
+ * kids, adding levels to the tree as the number of pages grows */
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetPageTreeFanout  (HPDF_Doc    pdf,
+                         HPDF_UINT   fanout);
+
+
 HPDF_EXPORT(HPDF_Page)
 HPDF_GetPageByIndex  (HPDF_Doc    pdf,
                       HPDF_UINT   index);
@@ -297,6 +341,28 @@ HPDF_LoadTTFontFromFile2 (HPDF_Doc     pdf,
                           HPDF_BOOL    embedding);
 
 
+/* a font cache keeps the TrueType fonts loaded with HPDF_LoadTTFontFromFile
+ * parsed for the documents it is set on, each file name is read once. it
+ * is freed after those documents, and HPDF_RemoveFromFontCache drops a file
+ * that has changed */
+HPDF_EXPORT(HPDF_FontCache)
+HPDF_NewFontCache  (void);
+
+
+HPDF_EXPORT(void)
+HPDF_FreeFontCache  (HPDF_FontCache  cache);
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_RemoveFromFontCache  (HPDF_FontCache  cache,
+                           const char      *file_name);
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetFontCache  (HPDF_Doc        pdf,
+                    HPDF_FontCache  cache);
+
+
 HPDF_EXPORT(HPDF_STATUS)
 HPDF_AddPageLabel  (HPDF_Doc            pdf,
                     HPDF_UINT           page_num,
@@ -883,6 +949,40 @@ HPDF_SetCompressionMode  (HPDF_Doc    pdf,
                           HPDF_UINT   mode);
 
 
+/* write objects other than streams into compressed object streams, with a
+ * cross-reference stream in place of the cross-reference table (PDF 1.5).
+ * not used for encrypted documents */
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetObjectStreams  (HPDF_Doc    pdf,
+                        HPDF_BOOL   use_obj_streams);
+
+
+/* write the document linearized, so that a viewer can display the first
+ * page and then any other page before the whole file has been downloaded.
+ * takes precedence over object streams, not used for encrypted documents */
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetLinearized  (HPDF_Doc    pdf,
+                     HPDF_BOOL   linearized);
+
+
+/* set a handler used while saving, and while pages are flushed, to deflate
+ * independent streams concurrently, NULL to deflate each stream as it is
+ * written */
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetParallelHandler  (HPDF_Doc            pdf,
+                          HPDF_Parallel_Func  parallel_fn,
+                          void                *user_data);
+
+
+/* keep at most budget bytes of the data of large streams in memory, the
+ * rest is moved to a temporary file until the document is saved. 0 (the
+ * default) keeps everything in memory. it applies to the streams created
+ * after it is set, so is set before pages and resources are added */
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetMemoryBudget  (HPDF_Doc    pdf,
+                       HPDF_UINT   budget);
+
+
 /*--------------------------------------------------------------------------*/
 /*----- font ---------------------------------------------------------------*/
 
@@ -1460,6 +1560,23 @@ HPDF_EXPORT(HPDF_STATUS)
 HPDF_Page_ExecuteXObject  (HPDF_Page     page,
                            HPDF_XObject  obj);
 
+/* Form XObjects.
+ * HPDF_BeginForm returns a drawing surface on which the HPDF_Page_* drawing
+ * functions may be used. HPDF_EndForm releases the surface and returns the
+ * form, which can then be placed on any number of pages with
+ * HPDF_Page_ExecuteXObject.
+ */
+HPDF_EXPORT(HPDF_Page)
+HPDF_BeginForm  (HPDF_Doc   pdf,
+                 HPDF_REAL  width,
+                 HPDF_REAL  height);
+
+
+HPDF_EXPORT(HPDF_XObject)
+HPDF_EndForm  (HPDF_Doc   pdf,
+               HPDF_Page  form);
+
+
 /*--- Marked content -----------------------------------------------------*/
 
 /* BMC --not implemented yet */
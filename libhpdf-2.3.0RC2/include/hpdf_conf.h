@@ -45,6 +45,8 @@
 #define HPDF_MALLOC                 malloc
 #define HPDF_FREE                   free
 #define HPDF_FILEP                  FILE*
+#define HPDF_TMPFILE                tmpfile
+#define HPDF_SETVBUF                setvbuf
 #define HPDF_TIME                   time
 #define HPDF_PRINTF                 printf
 #define HPDF_SIN                    sin
@@ -56,6 +58,18 @@
 /* default buffer size of memory-stream-object */
 #define HPDF_STREAM_BUF_SIZ         4096
 
+/* default size of the buffer output is collected in before it is written */
+#define HPDF_OUTPUT_BUF_SIZ         (1024 * 1024)
+
+/* digits written after the decimal point of real numbers (0 to 5), trailing
+ * zeros are left out. 2 is enough for coordinates in points */
+#ifndef HPDF_REAL_PRECISION
+#define HPDF_REAL_PRECISION         5
+#endif
+
+/* number of elements from which a dictionary indexes its keys by hash */
+#define HPDF_DICT_INDEX_MIN         8
+
 /* default array size of list-object */
 #define HPDF_DEF_ITEMS_PER_BLOCK    20
 
@@ -55,6 +55,9 @@ typedef struct _HPDF_Doc_Rec {
     /* list for loaded fontdefs */
     HPDF_List         fontdef_list;
 
+    /* TrueType fonts loaded from files are taken from here when set */
+    HPDF_FontCache    font_cache;
+
     /* list for loaded encodings */
     HPDF_List         encoder_list;
 
@@ -63,6 +66,25 @@ typedef struct _HPDF_Doc_Rec {
     /* default compression mode */
     HPDF_BOOL         compression_mode;
 
+    /* pack objects into object streams with a cross-reference stream */
+    HPDF_BOOL         obj_streams;
+
+    /* write linearized (fast web view) output */
+    HPDF_BOOL         linearized;
+
+    /* handler for deflating streams concurrently while saving */
+    HPDF_Parallel_Func  parallel_fn;
+    void                *parallel_data;
+
+    /* file that finished pages are written to as the document is built,
+     * the version written in its header and the number of pages written */
+    HPDF_Stream       out_stream;
+    HPDF_PDFVer       out_version;
+    HPDF_UINT         flushed_pages;
+
+    /* size of the buffer output is collected in before it is written */
+    HPDF_UINT         output_buf_siz;
+
     HPDF_BOOL         encrypt_on;
     HPDF_EncryptDict  encrypt_dict;
 
@@ -71,6 +93,9 @@ typedef struct _HPDF_Doc_Rec {
     HPDF_UINT         page_per_pages;
     HPDF_UINT         cur_page_num;
 
+    /* maximum kids of each node of a balanced page tree, 0 if not used */
+    HPDF_UINT         pages_fanout;
+
     /* buffer for saving into memory stream */
     HPDF_Stream       stream;
 } HPDF_Doc_Rec;
@@ -98,6 +123,12 @@ HPDF_BOOL
 HPDF_Doc_Validate  (HPDF_Doc  pdf);
 
 
+/*----- compression ---------------------------------------------------------*/
+
+HPDF_UINT
+HPDF_Doc_GetFlateFilter  (HPDF_Doc  pdf);
+
+
 /*----- page handling -------------------------------------------------------*/
 
 HPDF_Pages
@@ -74,8 +74,11 @@ typedef struct _HPDF_FontAttr_Rec {
     /* if the encoding-type is HPDF_ENCODER_TYPE_SINGLE_BYTE, the width of
      * each charactors are cashed in 'widths'.
      * when HPDF_ENCODER_TYPE_DOUBLE_BYTE the width is calculate each time.
+     * a base14 font in a common encoding shares a static table instead,
+     * marked by 'widths_shared'.
      */
     HPDF_INT16*                 widths;
+    HPDF_BOOL                   widths_shared;
     HPDF_BYTE*                  used;
 
     HPDF_Xref                   xref;
@@ -26,6 +26,7 @@ extern "C" {
 
 
 #define HPDF_FONTDEF_SIG_BYTES 0x464F4E54L
+#define HPDF_FONTCACHE_SIG_BYTES 0x46434348L
 
 /*------ collection of flags for defining characteristics. ---*/
 
@@ -141,6 +142,7 @@ typedef struct _HPDF_Type1FontDefAttrRec {
     HPDF_BYTE       last_char;                                /* Required */
     HPDF_CharData  *widths;                                   /* Required */
     HPDF_UINT       widths_count;
+    HPDF_BOOL       widths_shared;         /* widths is a static table */
 
     HPDF_INT16      leading;
     char      *char_set;
@@ -176,6 +178,11 @@ HPDF_Type1FontDef_SetWidths  (HPDF_FontDef         fontdef,
                               const HPDF_CharData  *widths);
 
 
+void
+HPDF_Type1FontDef_ShareWidths  (HPDF_FontDef         fontdef,
+                                const HPDF_CharData  *widths);
+
+
 HPDF_INT16
 HPDF_Type1FontDef_GetWidthByName  (HPDF_FontDef     fontdef,
                                    const char  *gryph_name);
@@ -191,6 +198,11 @@ HPDF_Base14FontDef_New  (HPDF_MMgr        mmgr,
                          const char  *font_name);
 
 
+const HPDF_INT16*
+HPDF_Base14FontDef_GetWidths  (const char  *font_name,
+                               const char  *encoding_name);
+
+
 
 /*----------------------------------------------------------------------------*/
 /*----- HPDF_TTFontDef  ------------------------------------------------------*/
@@ -237,6 +249,11 @@ typedef struct _HPDF_TTF_GryphOffsets {
         HPDF_UINT32   base_offset;
         HPDF_UINT32  *offsets;
         HPDF_BYTE    *flgs;   /* 0: unused, 1: used */
+
+        /* ids of the used glyphs in the embedded font, which holds only
+         * new_count glyphs. made by HPDF_TTFontDef_SaveFontData */
+        HPDF_UINT16  *new_ids;
+        HPDF_UINT16   new_count;
 } HPDF_TTF_GryphOffsets;
 
 
@@ -285,6 +302,8 @@ typedef struct _HPDF_TTF_NamingTable {
 }  HPDF_TTF_NamingTable;
 
 
+typedef struct _HPDF_FontCacheEntry_Rec  *HPDF_FontCacheEntry;
+
 typedef struct _HPDF_TTFontDefAttr_Rec   *HPDF_TTFontDefAttr;
 
 typedef struct _HPDF_TTFontDefAttr_Rec {
@@ -313,6 +332,11 @@ typedef struct _HPDF_TTFontDefAttr_Rec {
     HPDF_BOOL                is_cidfont;
 
     HPDF_Stream              stream;
+
+    /* set when the tables above belong to a font cache entry, only
+     * glyph_tbl.flgs, glyph_tbl.new_ids and stream are then owned by this
+     * fontdef */
+    HPDF_FontCacheEntry      shared;
 } HPDF_TTFontDefAttr_Rec;
 
 
@@ -354,6 +378,11 @@ HPDF_TTFontDef_SaveFontData  (HPDF_FontDef   fontdef,
                               HPDF_Stream    stream);
 
 
+HPDF_UINT16
+HPDF_TTFontDef_GetSubsetGid  (HPDF_FontDef   fontdef,
+                              HPDF_UINT16    gid);
+
+
 HPDF_Box
 HPDF_TTFontDef_GetCharBBox  (HPDF_FontDef   fontdef,
                              HPDF_UINT16    unicode);
@@ -364,6 +393,51 @@ HPDF_TTFontDef_SetTagName  (HPDF_FontDef   fontdef,
                             char     *tag);
 
 
+/*----------------------------------------------------------------------------*/
+/*----- HPDF_FontCache -------------------------------------------------------*/
+
+/* TrueType font definitions parsed once and shared by every document the
+ * cache is set on, the entries are counted references to a fontdef parsed
+ * without embedding. the cache is not locked, it is used from one thread */
+typedef struct _HPDF_FontCacheEntry_Rec {
+    HPDF_MMgr            mmgr;
+    char                *file_name;
+    HPDF_FontDef         fontdef;
+    HPDF_UINT            refs;      /* the cache and each fontdef sharing it */
+    HPDF_FontCacheEntry  next;
+} HPDF_FontCacheEntry_Rec;
+
+
+typedef struct _HPDF_FontCache_Rec  *HPDF_FontCache;
+
+typedef struct _HPDF_FontCache_Rec {
+    HPDF_UINT32          sig_bytes;
+    HPDF_Error_Rec       error;
+    HPDF_MMgr            mmgr;
+    HPDF_FontCacheEntry  entries;
+} HPDF_FontCache_Rec;
+
+
+HPDF_FontCache
+HPDF_FontCache_New  (void);
+
+
+void
+HPDF_FontCache_Free  (HPDF_FontCache  cache);
+
+
+HPDF_STATUS
+HPDF_FontCache_Remove  (HPDF_FontCache  cache,
+                        const char      *file_name);
+
+
+HPDF_FontDef
+HPDF_TTFontDef_LoadCached  (HPDF_MMgr       mmgr,
+                            HPDF_FontCache  cache,
+                            const char      *file_name,
+                            HPDF_BOOL       embedding);
+
+
 /*----------------------------------------------------------------------------*/
 /*----- HPDF_CIDFontDef  -----------------------------------------------------*/
 
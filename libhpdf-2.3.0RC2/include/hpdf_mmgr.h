@@ -44,6 +44,9 @@ typedef struct  _HPDF_MMgr_Rec {
     HPDF_MPool_Node   mpool;
     HPDF_UINT         buf_size;
 
+    /* memory stream buffers moved out of memory past a budget, or NULL */
+    struct _HPDF_SpillFile_Rec  *spill;
+
 #ifdef HPDF_MEM_DEBUG
     HPDF_UINT         alloc_cnt;
     HPDF_UINT         free_cnt;
@@ -427,6 +427,17 @@ typedef struct _HPDF_Dict_Rec {
     HPDF_UINT                  filter;
     HPDF_Dict                  filterParams;
     void                       *attr;
+
+    /* set while saving, when before_write_fn has already been called and
+     * the stream has been deflated ahead of being written */
+    HPDF_BOOL                  prepared;
+    HPDF_BYTE                  *deflated;
+    HPDF_UINT                  deflated_len;
+
+    /* once a dictionary has HPDF_DICT_INDEX_MIN elements, they are also
+     * kept in an open addressing table on the hash of their keys */
+    struct _HPDF_DictElement_Rec  **index;
+    HPDF_UINT                  index_siz;
 } HPDF_Dict_Rec;
 
 
@@ -435,6 +446,7 @@ typedef struct _HPDF_DictElement_Rec *HPDF_DictElement;
 typedef struct _HPDF_DictElement_Rec {
     char   key[HPDF_LIMIT_MAX_NAME_LEN + 1];
     void        *value;
+    HPDF_UINT32  hash;       /* of key, compared before the key itself */
 } HPDF_DictElement_Rec;
 
 
@@ -532,6 +544,7 @@ typedef struct _HPDF_XrefEntry_Rec {
       HPDF_UINT    byte_offset;
       HPDF_UINT16  gen_no;
       void*        obj;
+      HPDF_BOOL    written;   /* written ahead of the rest of the document */
 } HPDF_XrefEntry_Rec;
 
 
@@ -543,6 +556,8 @@ typedef struct _HPDF_Xref_Rec {
       HPDF_UINT    addr;
       HPDF_Xref    prev;
       HPDF_Dict    trailer;
+      HPDF_Parallel_Func  parallel_fn;
+      void                *parallel_data;
 } HPDF_Xref_Rec;
 
 
@@ -571,6 +586,36 @@ HPDF_Xref_WriteToStream  (HPDF_Xref     xref,
                           HPDF_Encrypt  e);
 
 
+HPDF_STATUS
+HPDF_Xref_WriteToStreamCompressed  (HPDF_Xref     xref,
+                                    HPDF_Stream   stream,
+                                    HPDF_UINT     filter);
+
+
+HPDF_STATUS
+HPDF_Xref_WriteToStreamLinearized  (HPDF_Xref     xref,
+                                    HPDF_Stream   stream);
+
+
+HPDF_STATUS
+HPDF_Xref_WriteObject  (HPDF_Xref     xref,
+                        void          *obj,
+                        HPDF_Stream   stream);
+
+
+void
+HPDF_Xref_ReleaseObject  (HPDF_Xref   xref,
+                          void        *obj);
+
+
+HPDF_STATUS
+HPDF_Xref_DeflateStreams  (HPDF_Xref           xref,
+                           HPDF_Parallel_Func  parallel_fn,
+                           void                *parallel_data,
+                           HPDF_Dict           *dicts,
+                           HPDF_UINT           count);
+
+
 HPDF_XrefEntry
 HPDF_Xref_GetEntryByObjectId  (HPDF_Xref  xref,
                                HPDF_UINT  obj_id);
@@ -81,6 +81,20 @@ HPDF_Page_New  (HPDF_MMgr   mmgr,
                 HPDF_Xref   xref);
 
 
+/*----------------------------------------------------------------------------*/
+/*----- HPDF_Form ------------------------------------------------------------*/
+
+HPDF_Page
+HPDF_Form_New  (HPDF_MMgr   mmgr,
+                HPDF_Xref   xref,
+                HPDF_REAL   width,
+                HPDF_REAL   height);
+
+
+HPDF_XObject
+HPDF_Form_Close  (HPDF_Page  form);
+
+
 void*
 HPDF_Page_GetInheritableItem  (HPDF_Page      page,
                                const char    *key,
@@ -123,6 +137,16 @@ HPDF_Page_CheckState  (HPDF_Page  page,
                        HPDF_UINT  mode);
 
 
+HPDF_STATUS
+HPDF_Page_PrepareFlush  (HPDF_Page    page,
+                         HPDF_Dict    *contents);
+
+
+HPDF_STATUS
+HPDF_Page_Flush  (HPDF_Page    page,
+                  HPDF_Stream  stream);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
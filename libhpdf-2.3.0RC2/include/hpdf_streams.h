@@ -34,7 +34,8 @@ typedef enum _HPDF_StreamType {
     HPDF_STREAM_UNKNOWN = 0,
     HPDF_STREAM_CALLBACK,
     HPDF_STREAM_FILE,
-    HPDF_STREAM_MEMORY
+    HPDF_STREAM_MEMORY,
+    HPDF_STREAM_MAPPED
 } HPDF_StreamType;
 
 #define HPDF_STREAM_FILTER_NONE          0x0000
@@ -44,6 +45,11 @@ typedef enum _HPDF_StreamType {
 #define HPDF_STREAM_FILTER_DCT_DECODE    0x0800
 #define HPDF_STREAM_FILTER_CCITT_DECODE  0x1000
 
+/* deflate level used with HPDF_STREAM_FILTER_FLATE_DECODE,
+ * these are not written to the Filter entry of the stream */
+#define HPDF_STREAM_FILTER_FLATE_BEST_SPEED     0x2000
+#define HPDF_STREAM_FILTER_FLATE_BEST_COMPRESS  0x4000
+
 typedef enum _HPDF_WhenceMode {
     HPDF_SEEK_SET = 0,
     HPDF_SEEK_CUR,
@@ -82,6 +88,28 @@ typedef HPDF_UINT32
 (*HPDF_Stream_Size_Func)  (HPDF_Stream  stream);
 
 
+typedef HPDF_STATUS
+(*HPDF_Stream_Flush_Func)  (HPDF_Stream  stream);
+
+
+/* once the full buffers of the memory streams of a document take more than
+ * budget bytes, further ones are moved to a temporary file of fixed size
+ * records, and read back from it when the streams are written */
+typedef struct _HPDF_SpillFile_Rec  *HPDF_SpillFile;
+
+
+typedef struct _HPDF_SpillFile_Rec {
+    HPDF_UINT    budget;
+    HPDF_UINT    used;        /* bytes of full buffers held in memory */
+    void         *fp;         /* opened when the budget is first exceeded */
+    HPDF_BOOL    failed;      /* no temporary file, everything stays in memory */
+    HPDF_UINT32  count;       /* records in the file */
+    HPDF_UINT32  *free_recs;  /* records released by freed streams */
+    HPDF_UINT    free_cnt;
+    HPDF_UINT    free_max;
+} HPDF_SpillFile_Rec;
+
+
 typedef struct _HPDF_MemStreamAttr_Rec  *HPDF_MemStreamAttr;
 
 
@@ -93,6 +121,20 @@ typedef struct _HPDF_MemStreamAttr_Rec {
     HPDF_UINT  r_ptr_idx;
     HPDF_UINT  r_pos;
     HPDF_BYTE  *r_ptr;
+
+    /* buffers moved to the spill file have a NULL entry in buf, and the
+     * record they were written to + 1 in recs */
+    HPDF_SpillFile  spill;
+    HPDF_UINT32     *recs;
+    HPDF_UINT       recs_max;
+    HPDF_UINT       spilled;
+    HPDF_BYTE       *cache;      /* the last spilled buffer read back */
+    HPDF_UINT       cache_idx;
+
+    /* a growable stream keeps its data in a single buffer, which grows by
+     * half when it is full, starting from init_siz */
+    HPDF_BOOL       growable;
+    HPDF_UINT       init_siz;
 } HPDF_MemStreamAttr_Rec;
 
 
@@ -108,16 +150,50 @@ typedef struct _HPDF_Stream_Rec {
     HPDF_Stream_Free_Func     free_fn;
     HPDF_Stream_Tell_Func     tell_fn;
     HPDF_Stream_Size_Func     size_fn;
+    HPDF_Stream_Flush_Func    flush_fn;
     void*                     attr;
 } HPDF_Stream_Rec;
 
 
+/* output collected in a buffer, and written to a file or through a user
+ * function whenever the buffer is full */
+typedef struct _HPDF_WriterAttr_Rec  *HPDF_WriterAttr;
+
+
+typedef struct _HPDF_WriterAttr_Rec {
+    void             *fp;        /* file written to, or NULL */
+    HPDF_Write_Func  write_fn;   /* function written through without a file */
+    void             *user_data;
+    HPDF_BYTE        *buf;
+    HPDF_UINT        len;
+    HPDF_UINT        siz;
+} HPDF_WriterAttr_Rec;
+
+
+/* a file mapped into memory as a whole, so that its data can be used in
+ * place through HPDF_MappedReader_GetPtr */
+typedef struct _HPDF_MappedAttr_Rec  *HPDF_MappedAttr;
+
+
+typedef struct _HPDF_MappedAttr_Rec {
+    const HPDF_BYTE  *base;
+    HPDF_UINT        size;
+    HPDF_UINT        pos;
+    void             *handle;    /* the mapping object on Windows */
+} HPDF_MappedAttr_Rec;
+
+
 
 HPDF_Stream
 HPDF_MemStream_New  (HPDF_MMgr  mmgr,
                      HPDF_UINT  buf_siz);
 
 
+HPDF_Stream
+HPDF_MemStream_NewGrowable  (HPDF_MMgr  mmgr,
+                             HPDF_UINT  init_siz);
+
+
 HPDF_BYTE*
 HPDF_MemStream_GetBufPtr  (HPDF_Stream  stream,
                            HPDF_UINT    index,
@@ -142,6 +218,19 @@ void
 HPDF_MemStream_FreeData  (HPDF_Stream  stream);
 
 
+HPDF_BOOL
+HPDF_MemStream_InMemory  (HPDF_Stream  stream);
+
+
+HPDF_STATUS
+HPDF_SpillFile_New  (HPDF_MMgr  mmgr,
+                     HPDF_UINT  budget);
+
+
+void
+HPDF_SpillFile_Free  (HPDF_MMgr  mmgr);
+
+
 HPDF_STATUS
 HPDF_Stream_WriteToStream  (HPDF_Stream   src,
                             HPDF_Stream   dst,
@@ -149,16 +238,54 @@ HPDF_Stream_WriteToStream  (HPDF_Stream   src,
                             HPDF_Encrypt  e);
 
 
+/* deflating a memory stream into a buffer allocated in advance, so that
+ * it can be run on another thread as an HPDF_Task_Func */
+typedef struct _HPDF_DeflateTask_Rec {
+    HPDF_Stream  src;
+    HPDF_UINT    filter;
+    HPDF_BYTE    *buf;
+    HPDF_UINT    len;       /* size of buf, then the length of the output */
+    HPDF_BOOL    done;
+} HPDF_DeflateTask_Rec;
+
+
+HPDF_UINT
+HPDF_Stream_DeflateBound  (HPDF_Stream  src);
+
+
+void HPDF_STDCALL
+HPDF_Stream_DeflateTask  (void  *task);
+
+
 HPDF_Stream
 HPDF_FileReader_New  (HPDF_MMgr   mmgr,
                       const char  *fname);
 
 
+HPDF_Stream
+HPDF_MappedReader_New  (HPDF_MMgr   mmgr,
+                        const char  *fname);
+
+
+const HPDF_BYTE*
+HPDF_MappedReader_GetPtr  (HPDF_Stream  stream,
+                           HPDF_UINT    offset,
+                           HPDF_UINT    len);
+
+
 HPDF_Stream
 HPDF_FileWriter_New  (HPDF_MMgr        mmgr,
                       const char  *fname);
 
 
+HPDF_Stream
+HPDF_Writer_New  (HPDF_MMgr        mmgr,
+                  const char       *fname,
+                  HPDF_Write_Func  write_fn,
+                  void             *user_data,
+                  HPDF_UINT        buf_siz);
+
+
 HPDF_Stream
 HPDF_CallbackReader_New  (HPDF_MMgr              mmgr,
                           HPDF_Stream_Read_Func  read_fn,
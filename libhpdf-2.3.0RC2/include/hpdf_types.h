@@ -188,6 +188,28 @@ typedef void
 (HPDF_STDCALL *HPDF_Free_Func)  (void  *aptr);
 
 
+/* a unit of work which can be run on any thread */
+typedef void
+(HPDF_STDCALL *HPDF_Task_Func)  (void  *task);
+
+
+/* runs task_fn for each of the tasks, possibly concurrently, and returns
+ * when all of them have completed */
+typedef void
+(HPDF_STDCALL *HPDF_Parallel_Func)  (HPDF_UINT       count,
+                                     HPDF_Task_Func  task_fn,
+                                     void            **tasks,
+                                     void            *user_data);
+
+
+/* writes len bytes of the document being saved, returns HPDF_OK if they
+ * were all written */
+typedef HPDF_STATUS
+(HPDF_STDCALL *HPDF_Write_Func)  (const HPDF_BYTE  *buf,
+                                  HPDF_UINT        len,
+                                  void             *user_data);
+
+
 /*---------------------------------------------------------------------------*/
 /*------ text width struct --------------------------------------------------*/
 
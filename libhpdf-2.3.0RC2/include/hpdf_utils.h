@@ -133,6 +133,15 @@ HPDF_UInt16Swap  (HPDF_UINT16  *value);
                                  c == '{' || \
                                  c == '}' )  \
 
+/* bytes written escaped in a literal string, where the delimiters of names
+ * need no escape. other bytes outside of printable ASCII are kept escaped,
+ * so that the strings stay readable */
+#define HPDF_TEXT_NEEDS_ESCAPE(c)    (c < 0x20 || \
+                                      c > 0x7e || \
+                                      c == '\\' || \
+                                      c == '(' || \
+                                      c == ')')
+
 #define HPDF_IS_WHITE_SPACE(c)   (c == 0x00 || \
                                  c == 0x09 || \
                                  c == 0x0A || \
@@ -23,6 +23,16 @@ HPDF_DictElement
 GetElement  (HPDF_Dict      dict,
              const char    *key);
 
+static HPDF_UINT32
+HashKey  (const char  *key);
+
+static HPDF_STATUS
+AddToIndex  (HPDF_Dict         dict,
+             HPDF_DictElement  element);
+
+static void
+FillIndex  (HPDF_Dict  dict);
+
 /*--------------------------------------------------------------------------*/
 
 HPDF_Dict
@@ -77,7 +87,12 @@ HPDF_DictStream_New  (HPDF_MMgr  mmgr,
     if (ret != HPDF_OK)
         return NULL;
 
-    obj->stream = HPDF_MemStream_New (mmgr, HPDF_STREAM_BUF_SIZ);
+    /* without a memory budget the data of the stream is kept contiguous,
+     * to be written out in one piece */
+    if (mmgr->spill)
+        obj->stream = HPDF_MemStream_New (mmgr, HPDF_STREAM_BUF_SIZ);
+    else
+        obj->stream = HPDF_MemStream_NewGrowable (mmgr, HPDF_STREAM_BUF_SIZ);
     if (!obj->stream)
         return NULL;
 
@@ -109,6 +124,12 @@ HPDF_Dict_Free  (HPDF_Dict  dict)
     if (dict->stream)
         HPDF_Stream_Free (dict->stream);
 
+    if (dict->deflated)
+        HPDF_FreeMem (dict->mmgr, dict->deflated);
+
+    if (dict->index)
+        HPDF_FreeMem (dict->mmgr, dict->index);
+
     HPDF_List_Free (dict->list);
 
     dict->header.obj_class = 0;
@@ -148,10 +169,13 @@ HPDF_Dict_Write  (HPDF_Dict     dict,
     if (ret != HPDF_OK)
         return ret;
 
-    if (dict->before_write_fn) {
+    /* before_write_fn may already have been called by HPDF_Xref_WriteToStream
+     * while preparing the stream to be deflated ahead of writing */
+    if (dict->before_write_fn && !dict->prepared) {
         if ((ret = dict->before_write_fn (dict)) != HPDF_OK)
             return ret;
     }
+    dict->prepared = HPDF_FALSE;
 
     /* encrypt-dict must not be encrypted. */
     if (dict->header.obj_class == (HPDF_OCLASS_DICT | HPDF_OSUBCLASS_ENCRYPT))
@@ -259,7 +283,19 @@ HPDF_Dict_Write  (HPDF_Dict     dict,
         if (e)
             HPDF_Encrypt_Reset (e);
 
-        if ((ret = HPDF_Stream_WriteToStream (dict->stream, stream,
+        if (dict->deflated) {
+            /* the stream data has already been deflated, it is never
+             * deflated ahead of writing when encrypting */
+            ret = HPDF_Stream_Write (stream, dict->deflated,
+                        dict->deflated_len);
+
+            HPDF_FreeMem (dict->mmgr, dict->deflated);
+            dict->deflated = NULL;
+            dict->deflated_len = 0;
+
+            if (ret != HPDF_OK)
+                return ret;
+        } else if ((ret = HPDF_Stream_WriteToStream (dict->stream, stream,
                         dict->filter, e)) != HPDF_OK)
             return ret;
 
@@ -285,6 +321,7 @@ HPDF_Dict_Add  (HPDF_Dict        dict,
     HPDF_Obj_Header *header;
     HPDF_STATUS ret = HPDF_OK;
     HPDF_DictElement element;
+    HPDF_BOOL new_element = HPDF_FALSE;
 
     if (!obj) {
         if (HPDF_Error_GetCode (dict->error) == HPDF_OK)
@@ -332,6 +369,7 @@ HPDF_Dict_Add  (HPDF_Dict        dict,
         HPDF_StrCpy (element->key, key, element->key +
                 HPDF_LIMIT_MAX_NAME_LEN + 1);
         element->value = NULL;
+        element->hash = HashKey (element->key);
 
         ret = HPDF_List_Add (dict->list, element);
         if (ret != HPDF_OK) {
@@ -342,6 +380,7 @@ HPDF_Dict_Add  (HPDF_Dict        dict,
 
             return HPDF_Error_GetCode (dict->error);
         }
+        new_element = HPDF_TRUE;
     }
 
     if (header->obj_id & HPDF_OTYPE_INDIRECT) {
@@ -357,6 +396,9 @@ HPDF_Dict_Add  (HPDF_Dict        dict,
         header->obj_id |= HPDF_OTYPE_DIRECT;
     }
 
+    if (new_element)
+        ret = AddToIndex (dict, element);
+
     return ret;
 }
 
@@ -453,13 +495,27 @@ HPDF_DictElement
 GetElement  (HPDF_Dict        dict,
              const char  *key)
 {
+    HPDF_UINT32 hash = HashKey (key);
     HPDF_UINT i;
 
+    if (dict->index) {
+        HPDF_UINT mask = dict->index_siz - 1;
+
+        for (i = hash & mask; dict->index[i]; i = (i + 1) & mask) {
+            HPDF_DictElement element = dict->index[i];
+
+            if (element->hash == hash && HPDF_StrCmp (key, element->key) == 0)
+                return element;
+        }
+
+        return NULL;
+    }
+
     for (i = 0; i < dict->list->count; i++) {
         HPDF_DictElement element =
                 (HPDF_DictElement)HPDF_List_ItemAt (dict->list, i);
 
-        if (HPDF_StrCmp (key, element->key) == 0)
+        if (element->hash == hash && HPDF_StrCmp (key, element->key) == 0)
             return element;
     }
 
@@ -467,27 +523,103 @@ GetElement  (HPDF_Dict        dict,
 }
 
 
-HPDF_STATUS
-HPDF_Dict_RemoveElement  (HPDF_Dict        dict,
-                          const char  *key)
+static HPDF_UINT32
+HashKey  (const char  *key)
 {
+    /* FNV-1a */
+    HPDF_UINT32 hash = 2166136261U;
+
+    while (*key) {
+        hash ^= (HPDF_BYTE)*key++;
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+
+static HPDF_STATUS
+AddToIndex  (HPDF_Dict         dict,
+             HPDF_DictElement  element)
+{
+    HPDF_UINT count = dict->list->count;
+    HPDF_UINT siz;
+
+    if (!dict->index && count < HPDF_DICT_INDEX_MIN)
+        return HPDF_OK;
+
+    /* keep the table at most half full */
+    if (dict->index && count * 2 <= dict->index_siz) {
+        HPDF_UINT mask = dict->index_siz - 1;
+        HPDF_UINT i = element->hash & mask;
+
+        while (dict->index[i])
+            i = (i + 1) & mask;
+        dict->index[i] = element;
+
+        return HPDF_OK;
+    }
+
+    siz = dict->index ? dict->index_siz * 2 : HPDF_DICT_INDEX_MIN * 4;
+
+    if (dict->index) {
+        HPDF_FreeMem (dict->mmgr, dict->index);
+        dict->index = NULL;
+        dict->index_siz = 0;
+    }
+
+    /* without the table, the elements are searched one by one */
+    dict->index = (HPDF_DictElement *)HPDF_GetMem (dict->mmgr,
+            sizeof(HPDF_DictElement) * siz);
+    if (!dict->index)
+        return HPDF_Error_GetCode (dict->error);
+
+    dict->index_siz = siz;
+    FillIndex (dict);
+
+    return HPDF_OK;
+}
+
+
+static void
+FillIndex  (HPDF_Dict  dict)
+{
+    HPDF_UINT mask = dict->index_siz - 1;
     HPDF_UINT i;
 
+    HPDF_MemSet (dict->index, 0, sizeof(HPDF_DictElement) * dict->index_siz);
+
     for (i = 0; i < dict->list->count; i++) {
         HPDF_DictElement element =
                 (HPDF_DictElement)HPDF_List_ItemAt (dict->list, i);
+        HPDF_UINT j = element->hash & mask;
+
+        while (dict->index[j])
+            j = (j + 1) & mask;
+        dict->index[j] = element;
+    }
+}
 
-        if (HPDF_StrCmp (key, element->key) == 0) {
-            HPDF_List_Remove (dict->list, element);
 
-            HPDF_Obj_Free (dict->mmgr, element->value);
-            HPDF_FreeMem (dict->mmgr, element);
+HPDF_STATUS
+HPDF_Dict_RemoveElement  (HPDF_Dict        dict,
+                          const char  *key)
+{
+    HPDF_DictElement element = GetElement (dict, key);
 
-            return HPDF_OK;
-        }
-    }
+    if (!element)
+        return HPDF_DICT_ITEM_NOT_FOUND;
+
+    HPDF_List_Remove (dict->list, element);
 
-    return HPDF_DICT_ITEM_NOT_FOUND;
+    HPDF_Obj_Free (dict->mmgr, element->value);
+    HPDF_FreeMem (dict->mmgr, element);
+
+    /* open addressing leaves no hole to mark, the table is filled again */
+    if (dict->index)
+        FillIndex (dict);
+
+    return HPDF_OK;
 }
 
 const char*
@@ -60,6 +60,9 @@ CleanupFontDefList (HPDF_Doc  pdf);
 static HPDF_Dict
 GetInfo  (HPDF_Doc  pdf);
 
+static HPDF_Pages
+NextLeafPages  (HPDF_Doc  pdf);
+
 static HPDF_STATUS
 InternalSaveToStream  (HPDF_Doc      pdf,
                        HPDF_Stream   stream);
@@ -70,6 +73,12 @@ LoadType1FontFromStream (HPDF_Doc     pdf,
                          HPDF_Stream  pfmdata);
 
 
+static const char*
+AddTTFontDef (HPDF_Doc         pdf,
+              HPDF_FontDef     def,
+              HPDF_BOOL        embedding);
+
+
 static const char*
 LoadTTFontFromStream (HPDF_Doc         pdf,
                       HPDF_Stream      font_data,
@@ -169,6 +178,7 @@ HPDF_NewEx  (HPDF_Error_Handler    user_error_fn,
     pdf->mmgr = mmgr;
     pdf->pdf_version = HPDF_VER_13;
     pdf->compression_mode = HPDF_COMP_NONE;
+    pdf->output_buf_siz = HPDF_OUTPUT_BUF_SIZ;
 
     /* copy the data of temporary-error object to the one which is
        included in pdf_doc object */
@@ -198,6 +208,7 @@ HPDF_Free  (HPDF_Doc  pdf)
         HPDF_MMgr mmgr = pdf->mmgr;
 
         HPDF_FreeDocAll (pdf);
+        HPDF_SpillFile_Free (mmgr);
 
         pdf->sig_bytes = 0;
 
@@ -303,6 +314,7 @@ HPDF_FreeDoc  (HPDF_Doc  pdf)
         pdf->cur_encoder = NULL;
         pdf->def_encoder = NULL;
         pdf->page_per_pages = 0;
+        pdf->pages_fanout = 0;
 
         if (pdf->page_list) {
             HPDF_List_Free (pdf->page_list);
@@ -318,6 +330,13 @@ HPDF_FreeDoc  (HPDF_Doc  pdf)
             HPDF_Stream_Free (pdf->stream);
             pdf->stream = NULL;
         }
+
+        /* a document streamed to a file is left incomplete */
+        if (pdf->out_stream) {
+            HPDF_Stream_Free (pdf->out_stream);
+            pdf->out_stream = NULL;
+        }
+        pdf->flushed_pages = 0;
     }
 }
 
@@ -371,6 +390,105 @@ HPDF_SetPagesConfiguration  (HPDF_Doc    pdf,
 }
 
 
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetPageTreeFanout  (HPDF_Doc    pdf,
+                         HPDF_UINT   fanout)
+{
+    HPDF_PTRACE ((" HPDF_SetPageTreeFanout\n"));
+
+    if (!HPDF_HasDoc (pdf))
+        return HPDF_INVALID_DOCUMENT;
+
+    if (pdf->cur_page)
+        return HPDF_RaiseError (&pdf->error, HPDF_INVALID_DOCUMENT_STATE, 0);
+
+    if (fanout < 2 || fanout > HPDF_LIMIT_MAX_ARRAY)
+        return HPDF_RaiseError (&pdf->error, HPDF_INVALID_PARAMETER, 0);
+
+    /* the root only ever holds intermediate nodes, so that its kids can be
+     * moved down a level when the tree grows */
+    if (pdf->cur_pages == pdf->root_pages) {
+        pdf->cur_pages = HPDF_Doc_AddPagesTo (pdf, pdf->root_pages);
+        if (!pdf->cur_pages)
+            return pdf->error.error_no;
+        pdf->cur_page_num = 0;
+    }
+
+    pdf->page_per_pages = 0;
+    pdf->pages_fanout = fanout;
+
+    return HPDF_OK;
+}
+
+
+/* adds a new leaf node to the balanced page tree, after the current one.
+ * all the leaves are at the same depth, so finding a page by its index
+ * takes time logarithmic in the number of pages */
+static HPDF_Pages
+NextLeafPages  (HPDF_Doc  pdf)
+{
+    HPDF_Pages node = pdf->cur_pages;
+    HPDF_UINT depth = 0;
+
+    HPDF_PTRACE ((" NextLeafPages\n"));
+
+    /* find the lowest node above the current leaf with room for a kid */
+    do {
+        node = (HPDF_Pages)HPDF_Dict_GetItem (node, "Parent",
+                    HPDF_OCLASS_DICT);
+        if (!node) {
+            HPDF_RaiseError (&pdf->error, HPDF_INVALID_PAGES, 0);
+            return NULL;
+        }
+        depth++;
+    } while (node != pdf->root_pages && HPDF_Array_Items ((HPDF_Array)
+                HPDF_Dict_GetItem (node, "Kids", HPDF_OCLASS_ARRAY)) >=
+                pdf->pages_fanout);
+
+    /* if the root is full, its kids are moved to a new node below it */
+    if (HPDF_Array_Items ((HPDF_Array)HPDF_Dict_GetItem (node, "Kids",
+                HPDF_OCLASS_ARRAY)) >= pdf->pages_fanout) {
+        HPDF_Array kids = (HPDF_Array)HPDF_Dict_GetItem (node, "Kids",
+                    HPDF_OCLASS_ARRAY);
+        HPDF_Pages level = HPDF_Pages_New (pdf->mmgr, NULL, pdf->xref);
+        HPDF_UINT i;
+
+        if (!level) {
+            HPDF_CheckError (&pdf->error);
+            return NULL;
+        }
+
+        for (i = 0; i < HPDF_Array_Items (kids); i++) {
+            HPDF_Dict kid = (HPDF_Dict)HPDF_Array_GetItem (kids, i,
+                        HPDF_OCLASS_DICT);
+
+            HPDF_Dict_RemoveElement (kid, "Parent");
+            if (HPDF_Pages_AddKids (level, kid) != HPDF_OK) {
+                HPDF_CheckError (&pdf->error);
+                return NULL;
+            }
+        }
+
+        HPDF_Array_Clear (kids);
+        if (HPDF_Pages_AddKids (node, level) != HPDF_OK) {
+            HPDF_CheckError (&pdf->error);
+            return NULL;
+        }
+
+        depth++;
+    }
+
+    /* then add new nodes down to the depth of the leaves */
+    while (depth-- > 0) {
+        node = HPDF_Doc_AddPagesTo (pdf, node);
+        if (!node)
+            return NULL;
+    }
+
+    return node;
+}
+
+
 static HPDF_STATUS
 WriteHeader  (HPDF_Doc      pdf,
               HPDF_Stream   stream)
@@ -598,15 +716,14 @@ HPDF_Doc_PrepareEncryption  (HPDF_Doc   pdf)
 }
 
 
+/* writes the document after the header. the objects of a document streamed
+ * to a file follow those already written to it, in the classic layout */
 static HPDF_STATUS
-InternalSaveToStream  (HPDF_Doc      pdf,
-                       HPDF_Stream   stream)
+WriteDocument  (HPDF_Doc      pdf,
+                HPDF_Stream   stream)
 {
     HPDF_STATUS ret;
 
-    if ((ret = WriteHeader (pdf, stream)) != HPDF_OK)
-        return ret;
-
     /* prepare trailer */
     if ((ret = PrepareTrailer (pdf)) != HPDF_OK)
         return ret;
@@ -620,7 +737,30 @@ InternalSaveToStream  (HPDF_Doc      pdf,
 
         if ((ret = HPDF_Xref_WriteToStream (pdf->xref, stream, e)) != HPDF_OK)
             return ret;
+    } else if (pdf->linearized && !pdf->out_stream) {
+        pdf->xref->parallel_fn = pdf->parallel_fn;
+        pdf->xref->parallel_data = pdf->parallel_data;
+
+        if ((ret = HPDF_Xref_WriteToStreamLinearized (pdf->xref, stream)) !=
+                HPDF_OK)
+            return ret;
+    } else if (pdf->obj_streams && !pdf->out_stream) {
+        HPDF_UINT filter = HPDF_STREAM_FILTER_NONE;
+
+#ifndef LIBHPDF_HAVE_NOZLIB
+        filter = HPDF_Doc_GetFlateFilter (pdf);
+#endif /* LIBHPDF_HAVE_NOZLIB */
+
+        pdf->xref->parallel_fn = pdf->parallel_fn;
+        pdf->xref->parallel_data = pdf->parallel_data;
+
+        if ((ret = HPDF_Xref_WriteToStreamCompressed (pdf->xref, stream,
+                filter)) != HPDF_OK)
+            return ret;
     } else {
+        pdf->xref->parallel_fn = pdf->parallel_fn;
+        pdf->xref->parallel_data = pdf->parallel_data;
+
         if ((ret = HPDF_Xref_WriteToStream (pdf->xref, stream, NULL)) !=
                 HPDF_OK)
             return ret;
@@ -630,6 +770,23 @@ InternalSaveToStream  (HPDF_Doc      pdf,
 }
 
 
+static HPDF_STATUS
+InternalSaveToStream  (HPDF_Doc      pdf,
+                       HPDF_Stream   stream)
+{
+    HPDF_STATUS ret;
+
+    /* the pages already written to a file are no longer held in memory */
+    if (pdf->out_stream)
+        return HPDF_RaiseError (&pdf->error, HPDF_INVALID_DOCUMENT_STATE, 0);
+
+    if ((ret = WriteHeader (pdf, stream)) != HPDF_OK)
+        return ret;
+
+    return WriteDocument (pdf, stream);
+}
+
+
 HPDF_EXPORT(HPDF_STATUS)
 HPDF_SaveToStream  (HPDF_Doc   pdf)
 {
@@ -753,12 +910,192 @@ HPDF_SaveToFile  (HPDF_Doc     pdf,
     if (!HPDF_HasDoc (pdf))
         return HPDF_INVALID_DOCUMENT;
 
-    stream = HPDF_FileWriter_New (pdf->mmgr, file_name);
+    if (pdf->out_stream)
+        return HPDF_RaiseError (&pdf->error, HPDF_INVALID_DOCUMENT_STATE, 0);
+
+    stream = HPDF_Writer_New (pdf->mmgr, file_name, NULL, NULL,
+                pdf->output_buf_siz);
+    if (!stream)
+        return HPDF_CheckError (&pdf->error);
+
+    if (InternalSaveToStream (pdf, stream) == HPDF_OK)
+        HPDF_Stream_Flush (stream);
+
+    HPDF_Stream_Free (stream);
+
+    return HPDF_CheckError (&pdf->error);
+}
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SaveToWriter  (HPDF_Doc         pdf,
+                    HPDF_Write_Func  write_fn,
+                    void             *user_data)
+{
+    HPDF_Stream stream;
+
+    HPDF_PTRACE ((" HPDF_SaveToWriter\n"));
+
+    if (!HPDF_HasDoc (pdf))
+        return HPDF_INVALID_DOCUMENT;
+
+    if (!write_fn)
+        return HPDF_RaiseError (&pdf->error, HPDF_INVALID_PARAMETER, 0);
+
+    stream = HPDF_Writer_New (pdf->mmgr, NULL, write_fn, user_data,
+                pdf->output_buf_siz);
     if (!stream)
         return HPDF_CheckError (&pdf->error);
 
-    InternalSaveToStream (pdf, stream);
+    if (InternalSaveToStream (pdf, stream) == HPDF_OK)
+        HPDF_Stream_Flush (stream);
+
+    HPDF_Stream_Free (stream);
+
+    return HPDF_CheckError (&pdf->error);
+}
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetOutputBufferSize  (HPDF_Doc    pdf,
+                           HPDF_UINT   size)
+{
+    HPDF_PTRACE ((" HPDF_SetOutputBufferSize\n"));
+
+    if (!HPDF_Doc_Validate (pdf))
+        return HPDF_INVALID_DOCUMENT;
+
+    pdf->output_buf_siz = size;
+
+    return HPDF_OK;
+}
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_BeginStreamToFile  (HPDF_Doc     pdf,
+                         const char  *file_name)
+{
+    HPDF_Stream stream;
+
+    HPDF_PTRACE ((" HPDF_BeginStreamToFile\n"));
+
+    if (!HPDF_HasDoc (pdf))
+        return HPDF_INVALID_DOCUMENT;
+
+    if (pdf->out_stream)
+        return HPDF_RaiseError (&pdf->error, HPDF_INVALID_DOCUMENT_STATE, 0);
+
+    stream = HPDF_Writer_New (pdf->mmgr, file_name, NULL, NULL,
+                pdf->output_buf_siz);
+    if (!stream)
+        return HPDF_CheckError (&pdf->error);
+
+    if (WriteHeader (pdf, stream) != HPDF_OK) {
+        HPDF_Stream_Free (stream);
+        return HPDF_CheckError (&pdf->error);
+    }
+
+    pdf->out_stream = stream;
+    pdf->out_version = pdf->pdf_version;
+    pdf->flushed_pages = 0;
+
+    return HPDF_OK;
+}
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_FlushPages  (HPDF_Doc     pdf)
+{
+    HPDF_Dict *contents;
+    HPDF_UINT start;
+    HPDF_UINT count;
+    HPDF_UINT i;
+    HPDF_STATUS ret = HPDF_OK;
+
+    HPDF_PTRACE ((" HPDF_FlushPages\n"));
+
+    if (!HPDF_HasDoc (pdf))
+        return HPDF_INVALID_DOCUMENT;
+
+    if (!pdf->out_stream)
+        return HPDF_RaiseError (&pdf->error, HPDF_INVALID_DOCUMENT_STATE, 0);
+
+    /* the encryption key is only known when the document is saved */
+    if (pdf->encrypt_on)
+        return HPDF_OK;
+
+    start = pdf->flushed_pages;
+    count = pdf->page_list->count - start;
+    if (count == 0)
+        return HPDF_OK;
+
+    contents = (HPDF_Dict *)HPDF_GetMem (pdf->mmgr, sizeof(HPDF_Dict) * count);
+    if (!contents)
+        return HPDF_CheckError (&pdf->error);
+
+    /* finish the pages off first, so that their contents can be deflated
+     * concurrently before they are written */
+    for (i = 0; i < count && ret == HPDF_OK; i++)
+        ret = HPDF_Page_PrepareFlush (HPDF_List_ItemAt (pdf->page_list,
+                    start + i), &contents[i]);
+
+    if (ret == HPDF_OK && pdf->parallel_fn) {
+        HPDF_UINT n = 0;
 
+        for (i = 0; i < count; i++)
+            if (contents[i])
+                contents[n++] = contents[i];
+
+        ret = HPDF_Xref_DeflateStreams (pdf->xref, pdf->parallel_fn,
+                    pdf->parallel_data, contents, n);
+    }
+
+    for (i = 0; i < count && ret == HPDF_OK; i++)
+        ret = HPDF_Page_Flush (HPDF_List_ItemAt (pdf->page_list, start + i),
+                    pdf->out_stream);
+
+    HPDF_FreeMem (pdf->mmgr, contents);
+
+    if (ret != HPDF_OK)
+        return HPDF_CheckError (&pdf->error);
+
+    pdf->flushed_pages = pdf->page_list->count;
+
+    return HPDF_OK;
+}
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_EndStreamToFile  (HPDF_Doc     pdf)
+{
+    HPDF_Stream stream;
+
+    HPDF_PTRACE ((" HPDF_EndStreamToFile\n"));
+
+    if (!HPDF_HasDoc (pdf))
+        return HPDF_INVALID_DOCUMENT;
+
+    stream = pdf->out_stream;
+    if (!stream || (pdf->encrypt_on && pdf->flushed_pages > 0))
+        return HPDF_RaiseError (&pdf->error, HPDF_INVALID_DOCUMENT_STATE, 0);
+
+    /* the header is already written, a later version is given in the
+     * catalog instead */
+    if (pdf->pdf_version > pdf->out_version) {
+        char version[4];
+
+        HPDF_MemCpy ((HPDF_BYTE *)version,
+                    (const HPDF_BYTE *)HPDF_VERSION_STR[pdf->pdf_version] + 5, 3);
+        version[3] = 0;
+
+        HPDF_Dict_AddName (pdf->catalog, "Version", version);
+    }
+
+    if (HPDF_Error_GetCode (&pdf->error) == HPDF_OK &&
+            WriteDocument (pdf, stream) == HPDF_OK)
+        HPDF_Stream_Flush (stream);
+
+    pdf->out_stream = NULL;
     HPDF_Stream_Free (stream);
 
     return HPDF_CheckError (&pdf->error);
@@ -865,7 +1202,14 @@ HPDF_AddPage  (HPDF_Doc  pdf)
     if (!HPDF_HasDoc (pdf))
         return NULL;
 
-    if (pdf->page_per_pages) {
+    if (pdf->pages_fanout) {
+        if (pdf->pages_fanout <= pdf->cur_page_num) {
+            pdf->cur_pages = NextLeafPages (pdf);
+            if (!pdf->cur_pages)
+                return NULL;
+            pdf->cur_page_num = 0;
+        }
+    } else if (pdf->page_per_pages) {
         if (pdf->page_per_pages <= pdf->cur_page_num) {
             pdf->cur_pages = HPDF_Doc_AddPagesTo (pdf, pdf->root_pages);
             if (!pdf->cur_pages)
@@ -874,6 +1218,7 @@ HPDF_AddPage  (HPDF_Doc  pdf)
         }
     }
 
+
     page = HPDF_Page_New (pdf->mmgr, pdf->xref);
     if (!page) {
         HPDF_CheckError (&pdf->error);
@@ -893,7 +1238,7 @@ HPDF_AddPage  (HPDF_Doc  pdf)
     pdf->cur_page = page;
 
     if (pdf->compression_mode & HPDF_COMP_TEXT)
-        HPDF_Page_SetFilter (page, HPDF_STREAM_FILTER_FLATE_DECODE);
+        HPDF_Page_SetFilter (page, HPDF_Doc_GetFlateFilter (pdf));
 
     pdf->cur_page_num++;
 
@@ -901,6 +1246,60 @@ HPDF_AddPage  (HPDF_Doc  pdf)
 }
 
 
+HPDF_EXPORT(HPDF_Page)
+HPDF_BeginForm  (HPDF_Doc   pdf,
+                 HPDF_REAL  width,
+                 HPDF_REAL  height)
+{
+    HPDF_Page form;
+
+    HPDF_PTRACE ((" HPDF_BeginForm\n"));
+
+    if (!HPDF_HasDoc (pdf))
+        return NULL;
+
+    if (width <= 0 || height <= 0) {
+        HPDF_RaiseError (&pdf->error, HPDF_INVALID_PARAMETER, 0);
+        return NULL;
+    }
+
+    form = HPDF_Form_New (pdf->mmgr, pdf->xref, width, height);
+    if (!form) {
+        HPDF_CheckError (&pdf->error);
+        return NULL;
+    }
+
+    if (pdf->compression_mode & HPDF_COMP_TEXT)
+        HPDF_Page_SetFilter (form, HPDF_Doc_GetFlateFilter (pdf));
+
+    return form;
+}
+
+
+HPDF_EXPORT(HPDF_XObject)
+HPDF_EndForm  (HPDF_Doc   pdf,
+               HPDF_Page  form)
+{
+    HPDF_XObject xobj;
+
+    HPDF_PTRACE ((" HPDF_EndForm\n"));
+
+    if (!HPDF_HasDoc (pdf))
+        return NULL;
+
+    if (!HPDF_Page_Validate (form) || form->mmgr != pdf->mmgr) {
+        HPDF_RaiseError (&pdf->error, HPDF_INVALID_PAGE, 0);
+        return NULL;
+    }
+
+    xobj = HPDF_Form_Close (form);
+    if (!xobj)
+        HPDF_CheckError (&pdf->error);
+
+    return xobj;
+}
+
+
 HPDF_Pages
 HPDF_Doc_AddPagesTo  (HPDF_Doc     pdf,
                       HPDF_Pages   parent)
@@ -974,7 +1373,7 @@ HPDF_InsertPage  (HPDF_Doc    pdf,
     }
 
     if (pdf->compression_mode & HPDF_COMP_TEXT)
-        HPDF_Page_SetFilter (page, HPDF_STREAM_FILTER_FLATE_DECODE);
+        HPDF_Page_SetFilter (page, HPDF_Doc_GetFlateFilter (pdf));
 
     return page;
 }
@@ -1384,7 +1783,7 @@ HPDF_GetFont  (HPDF_Doc          pdf,
         HPDF_CheckError (&pdf->error);
 
     if (font && (pdf->compression_mode & HPDF_COMP_METADATA))
-        font->filter = HPDF_STREAM_FILTER_FLATE_DECODE;
+        font->filter = HPDF_Doc_GetFlateFilter (pdf);
 
     return font;
 }
@@ -1472,7 +1871,7 @@ HPDF_GetTTFontDefFromFile (HPDF_Doc      pdf,
 	HPDF_PTRACE ((" HPDF_GetTTFontDefFromFile\n"));
 
 	/* create file stream */
-	font_data = HPDF_FileReader_New (pdf->mmgr, file_name);
+	font_data = HPDF_MappedReader_New (pdf->mmgr, file_name);
 
 	if (HPDF_Stream_Validate (font_data)) {
 		def = HPDF_TTFontDef_Load (pdf->mmgr, font_data, embedding);
@@ -1497,8 +1896,19 @@ HPDF_LoadTTFontFromFile (HPDF_Doc         pdf,
     if (!HPDF_HasDoc (pdf))
         return NULL;
 
+    if (pdf->font_cache) {
+        HPDF_FontDef def = HPDF_TTFontDef_LoadCached (pdf->mmgr,
+                pdf->font_cache, file_name, embedding);
+
+        ret = def ? AddTTFontDef (pdf, def, embedding) : NULL;
+        if (!ret)
+            HPDF_CheckError (&pdf->error);
+
+        return ret;
+    }
+
     /* create file stream */
-    font_data = HPDF_FileReader_New (pdf->mmgr, file_name);
+    font_data = HPDF_MappedReader_New (pdf->mmgr, file_name);
 
     if (HPDF_Stream_Validate (font_data)) {
         ret = LoadTTFontFromStream (pdf, font_data, embedding, file_name);
@@ -1513,31 +1923,21 @@ HPDF_LoadTTFontFromFile (HPDF_Doc         pdf,
 
 
 static const char*
-LoadTTFontFromStream (HPDF_Doc         pdf,
-                      HPDF_Stream      font_data,
-                      HPDF_BOOL        embedding,
-                      const char      *file_name)
+AddTTFontDef (HPDF_Doc         pdf,
+              HPDF_FontDef     def,
+              HPDF_BOOL        embedding)
 {
-    HPDF_FontDef def;
-
-    HPDF_PTRACE ((" HPDF_LoadTTFontFromStream\n"));
-    HPDF_UNUSED (file_name);
-
-    def = HPDF_TTFontDef_Load (pdf->mmgr, font_data, embedding);
-    if (def) {
-        HPDF_FontDef  tmpdef = HPDF_Doc_FindFontDef (pdf, def->base_font);
-        if (tmpdef) {
-            HPDF_FontDef_Free (def);
-            HPDF_SetError (&pdf->error, HPDF_FONT_EXISTS, 0);
-            return NULL;
-        }
+    HPDF_FontDef  tmpdef = HPDF_Doc_FindFontDef (pdf, def->base_font);
+    if (tmpdef) {
+        HPDF_FontDef_Free (def);
+        HPDF_SetError (&pdf->error, HPDF_FONT_EXISTS, 0);
+        return NULL;
+    }
 
-        if (HPDF_List_Add (pdf->fontdef_list, def) != HPDF_OK) {
-            HPDF_FontDef_Free (def);
-            return NULL;
-        }
-    } else
+    if (HPDF_List_Add (pdf->fontdef_list, def) != HPDF_OK) {
+        HPDF_FontDef_Free (def);
         return NULL;
+    }
 
     if (embedding) {
         if (pdf->ttfont_tag[0] == 0) {
@@ -1561,6 +1961,25 @@ LoadTTFontFromStream (HPDF_Doc         pdf,
 }
 
 
+static const char*
+LoadTTFontFromStream (HPDF_Doc         pdf,
+                      HPDF_Stream      font_data,
+                      HPDF_BOOL        embedding,
+                      const char      *file_name)
+{
+    HPDF_FontDef def;
+
+    HPDF_PTRACE ((" HPDF_LoadTTFontFromStream\n"));
+    HPDF_UNUSED (file_name);
+
+    def = HPDF_TTFontDef_Load (pdf->mmgr, font_data, embedding);
+    if (!def)
+        return NULL;
+
+    return AddTTFontDef (pdf, def, embedding);
+}
+
+
 HPDF_EXPORT(const char*)
 HPDF_LoadTTFontFromFile2 (HPDF_Doc         pdf,
                           const char      *file_name,
@@ -1576,7 +1995,7 @@ HPDF_LoadTTFontFromFile2 (HPDF_Doc         pdf,
         return NULL;
 
     /* create file stream */
-    font_data = HPDF_FileReader_New (pdf->mmgr, file_name);
+    font_data = HPDF_MappedReader_New (pdf->mmgr, file_name);
 
     if (HPDF_Stream_Validate (font_data)) {
         ret = LoadTTFontFromStream2 (pdf, font_data, index, embedding, file_name);
@@ -1603,40 +2022,59 @@ LoadTTFontFromStream2 (HPDF_Doc         pdf,
     HPDF_UNUSED (file_name);
 
     def = HPDF_TTFontDef_Load2 (pdf->mmgr, font_data, index, embedding);
-    if (def) {
-        HPDF_FontDef  tmpdef = HPDF_Doc_FindFontDef (pdf, def->base_font);
-        if (tmpdef) {
-            HPDF_FontDef_Free (def);
-            HPDF_SetError (&pdf->error, HPDF_FONT_EXISTS, 0);
-            return NULL;
-        }
-
-        if (HPDF_List_Add (pdf->fontdef_list, def) != HPDF_OK) {
-            HPDF_FontDef_Free (def);
-            return NULL;
-        }
-    } else
+    if (!def)
         return NULL;
 
-    if (embedding) {
-        if (pdf->ttfont_tag[0] == 0) {
-            HPDF_MemCpy (pdf->ttfont_tag, (HPDF_BYTE *)"HPDFAA", 6);
-        } else {
-            HPDF_INT i;
+    return AddTTFontDef (pdf, def, embedding);
+}
 
-            for (i = 5; i >= 0; i--) {
-                pdf->ttfont_tag[i] += 1;
-                if (pdf->ttfont_tag[i] > 'Z')
-                    pdf->ttfont_tag[i] = 'A';
-                else
-                    break;
-            }
-        }
 
-        HPDF_TTFontDef_SetTagName (def, (char *)pdf->ttfont_tag);
-    }
+HPDF_EXPORT(HPDF_FontCache)
+HPDF_NewFontCache  (void)
+{
+    HPDF_PTRACE ((" HPDF_NewFontCache\n"));
 
-    return def->base_font;
+    return HPDF_FontCache_New ();
+}
+
+
+HPDF_EXPORT(void)
+HPDF_FreeFontCache  (HPDF_FontCache  cache)
+{
+    HPDF_PTRACE ((" HPDF_FreeFontCache\n"));
+
+    HPDF_FontCache_Free (cache);
+}
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_RemoveFromFontCache  (HPDF_FontCache  cache,
+                           const char      *file_name)
+{
+    HPDF_PTRACE ((" HPDF_RemoveFromFontCache\n"));
+
+    if (!cache || cache->sig_bytes != HPDF_FONTCACHE_SIG_BYTES)
+        return HPDF_INVALID_PARAMETER;
+
+    return HPDF_FontCache_Remove (cache, file_name);
+}
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetFontCache  (HPDF_Doc        pdf,
+                    HPDF_FontCache  cache)
+{
+    HPDF_PTRACE ((" HPDF_SetFontCache\n"));
+
+    if (!HPDF_Doc_Validate (pdf))
+        return HPDF_INVALID_DOCUMENT;
+
+    if (cache && cache->sig_bytes != HPDF_FONTCACHE_SIG_BYTES)
+        return HPDF_RaiseError (&pdf->error, HPDF_INVALID_PARAMETER, 0);
+
+    pdf->font_cache = cache;
+
+    return HPDF_OK;
 }
 
 
@@ -1671,7 +2109,7 @@ HPDF_LoadRawImageFromFile  (HPDF_Doc          pdf,
         HPDF_CheckError (&pdf->error);
 
     if (image && pdf->compression_mode & HPDF_COMP_IMAGE)
-        image->filter = HPDF_STREAM_FILTER_FLATE_DECODE;
+        image->filter = HPDF_Doc_GetFlateFilter (pdf);
 
     return image;
 }
@@ -1703,7 +2141,7 @@ HPDF_LoadRawImageFromMem  (HPDF_Doc           pdf,
         HPDF_CheckError (&pdf->error);
 
     if (image && pdf->compression_mode & HPDF_COMP_IMAGE) {
-        image->filter = HPDF_STREAM_FILTER_FLATE_DECODE;
+        image->filter = HPDF_Doc_GetFlateFilter (pdf);
     }
 
     return image;
@@ -2141,6 +2579,88 @@ HPDF_SetCompressionMode  (HPDF_Doc    pdf,
 }
 
 
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetObjectStreams  (HPDF_Doc    pdf,
+                        HPDF_BOOL   use_obj_streams)
+{
+    HPDF_PTRACE ((" HPDF_SetObjectStreams\n"));
+
+    if (!HPDF_Doc_Validate (pdf))
+        return HPDF_INVALID_DOCUMENT;
+
+    pdf->obj_streams = use_obj_streams;
+
+    if (use_obj_streams && pdf->pdf_version < HPDF_VER_15)
+        pdf->pdf_version = HPDF_VER_15;
+
+    return HPDF_OK;
+}
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetLinearized  (HPDF_Doc    pdf,
+                     HPDF_BOOL   linearized)
+{
+    HPDF_PTRACE ((" HPDF_SetLinearized\n"));
+
+    if (!HPDF_Doc_Validate (pdf))
+        return HPDF_INVALID_DOCUMENT;
+
+    pdf->linearized = linearized;
+
+    return HPDF_OK;
+}
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetParallelHandler  (HPDF_Doc            pdf,
+                          HPDF_Parallel_Func  parallel_fn,
+                          void                *user_data)
+{
+    HPDF_PTRACE ((" HPDF_SetParallelHandler\n"));
+
+    if (!HPDF_Doc_Validate (pdf))
+        return HPDF_INVALID_DOCUMENT;
+
+    pdf->parallel_fn = parallel_fn;
+    pdf->parallel_data = user_data;
+
+    return HPDF_OK;
+}
+
+
+HPDF_EXPORT(HPDF_STATUS)
+HPDF_SetMemoryBudget  (HPDF_Doc    pdf,
+                       HPDF_UINT   budget)
+{
+    HPDF_PTRACE ((" HPDF_SetMemoryBudget\n"));
+
+    if (!HPDF_Doc_Validate (pdf))
+        return HPDF_INVALID_DOCUMENT;
+
+    if (HPDF_SpillFile_New (pdf->mmgr, budget) != HPDF_OK)
+        return HPDF_CheckError (&pdf->error);
+
+    return HPDF_OK;
+}
+
+
+/* the FlateDecode stream filter, together with the deflate level selected
+ * by the compression mode of the document */
+HPDF_UINT
+HPDF_Doc_GetFlateFilter  (HPDF_Doc  pdf)
+{
+    HPDF_UINT filter = HPDF_STREAM_FILTER_FLATE_DECODE;
+
+    if (pdf->compression_mode & HPDF_COMP_BEST_SPEED)
+        filter |= HPDF_STREAM_FILTER_FLATE_BEST_SPEED;
+    else if (pdf->compression_mode & HPDF_COMP_BEST_COMPRESS)
+        filter |= HPDF_STREAM_FILTER_FLATE_BEST_COMPRESS;
+
+    return filter;
+}
+
+
 HPDF_EXPORT(HPDF_STATUS)
 HPDF_GetError  (HPDF_Doc   pdf)
 {
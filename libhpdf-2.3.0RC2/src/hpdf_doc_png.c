@@ -162,7 +162,7 @@ LoadPngImageFromStream (HPDF_Doc      pdf,
                 delayed_loading);
 
     if (image && (pdf->compression_mode & HPDF_COMP_IMAGE))
-        image->filter = HPDF_STREAM_FILTER_FLATE_DECODE;
+        image->filter = HPDF_Doc_GetFlateFilter (pdf);
 
     return image;
 }
@@ -418,7 +418,7 @@ CIDFontType2_New (HPDF_Font parent, HPDF_Xref xref)
                   tmp_array = NULL;
         }
 
-        /* create "CIDToGIDMap" data */
+        /* create "CIDToGIDMap", its data is written with the font data */
         if (fontdef_attr->embedding) {
             attr->map_stream = HPDF_DictStream_New (font->mmgr, xref);
             if (!attr->map_stream)
@@ -426,20 +426,6 @@ CIDFontType2_New (HPDF_Font parent, HPDF_Xref xref)
 
             if (HPDF_Dict_Add (font, "CIDToGIDMap", attr->map_stream) != HPDF_OK)
                 return NULL;
-
-            for (i = 0; i < max; i++) {
-                HPDF_BYTE u[2];
-                HPDF_UINT16 gid = tmp_map[i];
-
-                u[0] = (HPDF_BYTE)(gid >> 8);
-                u[1] = (HPDF_BYTE)gid;
-
-                HPDF_MemCpy ((HPDF_BYTE *)(tmp_map + i), u, 2);
-            }
-
-            if ((ret = HPDF_Stream_Write (attr->map_stream->stream,
-                            (HPDF_BYTE *)tmp_map, max * 2)) != HPDF_OK)
-                return NULL;
         }
     } else {
         HPDF_SetError (font->error, HPDF_INVALID_FONTDEF_DATA, 0);
@@ -468,6 +454,56 @@ CIDFontType2_New (HPDF_Font parent, HPDF_Xref xref)
 }
 
 
+/* the glyph ids in the CIDToGIDMap are the ones of the embedded font, which
+ * keeps only the used glyphs. made again each time the document is saved */
+static HPDF_STATUS
+CIDFontType2_WriteMap  (HPDF_Dict obj)
+{
+    HPDF_FontAttr font_attr = (HPDF_FontAttr)obj->attr;
+    HPDF_FontDef fontdef = font_attr->fontdef;
+    HPDF_CMapEncoderAttr encoder_attr =
+                (HPDF_CMapEncoderAttr)font_attr->encoder->attr;
+    HPDF_Stream stream = font_attr->map_stream->stream;
+    HPDF_UNICODE tmp_map[65536];
+    HPDF_UINT16 max = 0;
+    HPDF_UINT i;
+
+    HPDF_PTRACE ((" CIDFontType2_WriteMap\n"));
+
+    HPDF_MemSet (tmp_map, 0, sizeof(HPDF_UNICODE) * 65536);
+
+    for (i = 0; i < 256; i++) {
+        HPDF_UINT j;
+
+        for (j = 0; j < 256; j++) {
+            HPDF_UINT16 cid = encoder_attr->cid_map[i][j];
+            if (cid != 0) {
+                HPDF_UNICODE unicode = encoder_attr->unicode_map[i][j];
+                HPDF_UINT16 gid = HPDF_TTFontDef_GetGlyphid (fontdef, unicode);
+                tmp_map[cid] = HPDF_TTFontDef_GetSubsetGid (fontdef, gid);
+                if (max < cid)
+                    max = cid;
+            }
+        }
+    }
+
+    for (i = 0; i <= max; i++) {
+        HPDF_BYTE u[2];
+        HPDF_UINT16 gid = tmp_map[i];
+
+        u[0] = (HPDF_BYTE)(gid >> 8);
+        u[1] = (HPDF_BYTE)gid;
+
+        HPDF_MemCpy ((HPDF_BYTE *)(tmp_map + i), u, 2);
+    }
+
+    HPDF_MemStream_FreeData (stream);
+
+    return HPDF_Stream_Write (stream, (HPDF_BYTE *)tmp_map,
+                ((HPDF_UINT)max + 1) * 2);
+}
+
+
 static HPDF_STATUS
 CIDFontType2_BeforeWrite_Func  (HPDF_Dict obj)
 {
@@ -535,6 +571,10 @@ CIDFontType2_BeforeWrite_Func  (HPDF_Dict obj)
         font_attr->fontdef->descriptor = descriptor;
     }
 
+    if (font_attr->map_stream &&
+            (ret = CIDFontType2_WriteMap (obj)) != HPDF_OK)
+        return ret;
+
     if ((ret = HPDF_Dict_AddName (obj, "BaseFont",
                 def_attr->base_font)) != HPDF_OK)
         return ret;
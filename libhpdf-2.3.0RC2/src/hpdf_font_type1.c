@@ -105,26 +105,37 @@ HPDF_Type1Font_New  (HPDF_MMgr        mmgr,
     attr->encoder = encoder;
     attr->xref = xref;
 
+    fontdef_attr = (HPDF_Type1FontDefAttr)fontdef->attr;
+
     /* singlebyte-font has a widths-array which is an array of 256 signed
      * short integer.
+     * a base14 font in a common encoding uses the static table built for it,
+     * the others search the widths of the fontdef for each character.
      */
-    attr->widths = HPDF_GetMem (mmgr, sizeof(HPDF_INT16) * 256);
-    if (!attr->widths) {
-        HPDF_Dict_Free (font);
-        return NULL;
-    }
+    if (fontdef_attr->is_base14font)
+        attr->widths = (HPDF_INT16 *)HPDF_Base14FontDef_GetWidths (
+                fontdef->base_font, encoder->name);
 
-    encoder_attr = (HPDF_BasicEncoderAttr)encoder->attr;
+    if (attr->widths) {
+        attr->widths_shared = HPDF_TRUE;
+    } else {
+        attr->widths = HPDF_GetMem (mmgr, sizeof(HPDF_INT16) * 256);
+        if (!attr->widths) {
+            HPDF_Dict_Free (font);
+            return NULL;
+        }
 
-    HPDF_MemSet (attr->widths, 0, sizeof(HPDF_INT16) * 256);
-    for (i = encoder_attr->first_char; i <= encoder_attr->last_char; i++) {
-        HPDF_UNICODE u = encoder_attr->unicode_map[i];
+        encoder_attr = (HPDF_BasicEncoderAttr)encoder->attr;
 
-        HPDF_UINT16 w = HPDF_Type1FontDef_GetWidth (fontdef, u);
-        attr->widths[i] = w;
-    }
+        HPDF_MemSet (attr->widths, 0, sizeof(HPDF_INT16) * 256);
+        for (i = encoder_attr->first_char; i <= encoder_attr->last_char;
+                i++) {
+            HPDF_UNICODE u = encoder_attr->unicode_map[i];
 
-    fontdef_attr = (HPDF_Type1FontDefAttr)fontdef->attr;
+            HPDF_UINT16 w = HPDF_Type1FontDef_GetWidth (fontdef, u);
+            attr->widths[i] = w;
+        }
+    }
 
     ret += HPDF_Dict_AddName (font, "Type", "Font");
     ret += HPDF_Dict_AddName (font, "BaseFont", fontdef->base_font);
@@ -384,7 +395,7 @@ Type1Font_OnFree  (HPDF_Dict  obj)
     HPDF_PTRACE ((" HPDF_Type1Font_OnFree\n"));
 
     if (attr) {
-        if (attr->widths) {
+        if (attr->widths && !attr->widths_shared) {
             HPDF_FreeMem (obj->mmgr, attr->widths);
         }
         HPDF_FreeMem (obj->mmgr, attr);
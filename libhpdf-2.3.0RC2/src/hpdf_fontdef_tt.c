@@ -23,6 +23,10 @@
 
 #define HPDF_TTF_MAX_MEM_SIZ    10000
 
+/* segments of a format 4 cmap written for a subset, within the 64 KB the
+ * length of the subtable allows */
+#define HPDF_TTF_MAX_CMAP_RUNS  8188
+
 #define HPDF_REQUIRED_TAGS_COUNT  13
 
 static const char * const REQUIRED_TAGS[HPDF_REQUIRED_TAGS_COUNT] = {
@@ -172,6 +176,10 @@ CheckCompositGryph  (HPDF_FontDef   fontdef,
                      HPDF_UINT16    gid);
 
 
+static void
+FontCache_Release  (HPDF_FontCacheEntry  entry);
+
+
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 
@@ -205,7 +213,19 @@ InitAttr (HPDF_FontDef  fontdef)
 {
     HPDF_TTFontDefAttr attr = (HPDF_TTFontDefAttr)fontdef->attr;
 
-    if (attr) {
+    if (attr && attr->shared) {
+        if (attr->glyph_tbl.flgs)
+            HPDF_FreeMem (fontdef->mmgr, attr->glyph_tbl.flgs);
+
+        if (attr->glyph_tbl.new_ids)
+            HPDF_FreeMem (fontdef->mmgr, attr->glyph_tbl.new_ids);
+
+        if (attr->stream)
+            HPDF_Stream_Free (attr->stream);
+
+        FontCache_Release (attr->shared);
+        attr->shared = NULL;
+    } else if (attr) {
         if (attr->char_set)
             HPDF_FreeMem (fontdef->mmgr, attr->char_set);
 
@@ -239,6 +259,9 @@ InitAttr (HPDF_FontDef  fontdef)
         if (attr->glyph_tbl.offsets)
             HPDF_FreeMem (fontdef->mmgr, attr->glyph_tbl.offsets);
 
+        if (attr->glyph_tbl.new_ids)
+            HPDF_FreeMem (fontdef->mmgr, attr->glyph_tbl.new_ids);
+
         if (attr->stream)
             HPDF_Stream_Free (attr->stream);
     }
@@ -1126,6 +1149,39 @@ ParseCMAP_format4  (HPDF_FontDef  fontdef,
 }
 
 
+/* the glyph id of unicode, which is in the segment i of a format 4 cmap */
+static HPDF_UINT16
+CMapSegmentGlyph  (HPDF_TTFontDefAttr  attr,
+                   HPDF_UINT           i,
+                   HPDF_UINT16         unicode)
+{
+    HPDF_UINT seg_count = attr->cmap.seg_count_x2 / 2;
+
+    if (attr->cmap.id_range_offset[i] == 0) {
+        HPDF_PTRACE((" HPDF_TTFontDef_GetGlyphid idx=%u code=%u "
+                    " ret=%u\n", i, unicode,
+                    unicode + attr->cmap.id_delta[i]));
+
+        return (HPDF_UINT16)(unicode + attr->cmap.id_delta[i]);
+    } else {
+        HPDF_UINT idx = attr->cmap.id_range_offset[i] / 2 +
+            (unicode - attr->cmap.start_count[i]) - (seg_count - i);
+
+        if (idx >= attr->cmap.glyph_id_array_count) {
+            HPDF_PTRACE((" HPDF_TTFontDef_GetGlyphid[%u] %u > %u\n",
+                        i, idx, (HPDF_UINT)attr->cmap.glyph_id_array_count));
+            return 0;
+        } else {
+            HPDF_UINT16 gid = (HPDF_UINT16)(attr->cmap.glyph_id_array[idx] +
+                attr->cmap.id_delta[i]);
+            HPDF_PTRACE((" HPDF_TTFontDef_GetGlyphid idx=%u unicode=0x%04X "
+                        "id=%u\n", idx, unicode, gid));
+            return gid;
+        }
+    }
+}
+
+
 HPDF_UINT16
 HPDF_TTFontDef_GetGlyphid  (HPDF_FontDef   fontdef,
                             HPDF_UINT16    unicode)
@@ -1161,28 +1217,7 @@ HPDF_TTFontDef_GetGlyphid  (HPDF_FontDef   fontdef,
         return 0;
     }
 
-    if (attr->cmap.id_range_offset[i] == 0) {
-        HPDF_PTRACE((" HPDF_TTFontDef_GetGlyphid idx=%u code=%u "
-                    " ret=%u\n", i, unicode,
-                    unicode + attr->cmap.id_delta[i]));
-
-        return (HPDF_UINT16)(unicode + attr->cmap.id_delta[i]);
-    } else {
-        HPDF_UINT idx = attr->cmap.id_range_offset[i] / 2 +
-            (unicode - attr->cmap.start_count[i]) - (seg_count - i);
-
-        if (idx > attr->cmap.glyph_id_array_count) {
-            HPDF_PTRACE((" HPDF_TTFontDef_GetGlyphid[%u] %u > %u\n",
-                        i, idx, (HPDF_UINT)attr->cmap.glyph_id_array_count));
-            return 0;
-        } else {
-            HPDF_UINT16 gid = (HPDF_UINT16)(attr->cmap.glyph_id_array[idx] +
-                attr->cmap.id_delta[i]);
-            HPDF_PTRACE((" HPDF_TTFontDef_GetGlyphid idx=%u unicode=0x%04X "
-                        "id=%u\n", idx, unicode, gid));
-            return gid;
-        }
-    }
+    return CMapSegmentGlyph (attr, i, unicode);
 }
 
 
@@ -1225,11 +1260,15 @@ CheckCompositGryph  (HPDF_FontDef   fontdef,
 {
     HPDF_TTFontDefAttr attr = (HPDF_TTFontDefAttr)fontdef->attr;
     HPDF_UINT offset = attr->glyph_tbl.offsets[gid];
-    /* HPDF_UINT len = attr->glyph_tbl.offsets[gid + 1] - offset; */
+    HPDF_UINT len = attr->glyph_tbl.offsets[gid + 1] - offset;
     HPDF_STATUS ret;
 
     HPDF_PTRACE ((" CheckCompositGryph\n"));
 
+    /* an empty glyph, such as the one of a space */
+    if (len == 0)
+        return HPDF_OK;
+
     if (attr->header.index_to_loc_format == 0)
         offset *= 2;
 
@@ -1343,6 +1382,7 @@ ParseHmtx  (HPDF_FontDef  fontdef)
     HPDF_UINT i;
     HPDF_UINT16 save_aw = 0;
     HPDF_TTF_LongHorMetric *pmetric;
+    const HPDF_BYTE *src;
 
     HPDF_PTRACE ((" HPDF_TTFontDef_ParseHtmx\n"));
 
@@ -1363,6 +1403,30 @@ ParseHmtx  (HPDF_FontDef  fontdef)
         return HPDF_Error_GetCode (fontdef->error);
 
     pmetric = attr->h_metric;
+
+    /* the metrics of a mapped font are decoded in place */
+    src = (attr->num_h_metric <= attr->num_glyphs) ?
+            HPDF_MappedReader_GetPtr (attr->stream, tbl->offset,
+                attr->num_glyphs * 2 + attr->num_h_metric * 2) : NULL;
+    if (src) {
+        for (i = 0; i < attr->num_h_metric; i++) {
+            pmetric->advance_width = (HPDF_UINT16)(src[0] << 8 | src[1]);
+            pmetric->lsb = (HPDF_INT16)(src[2] << 8 | src[3]);
+            save_aw = pmetric->advance_width;
+            pmetric++;
+            src += 4;
+        }
+
+        for (; i < attr->num_glyphs; i++) {
+            pmetric->advance_width = save_aw;
+            pmetric->lsb = (HPDF_INT16)(src[0] << 8 | src[1]);
+            pmetric++;
+            src += 2;
+        }
+
+        return HPDF_OK;
+    }
+
     for (i = 0; i < attr->num_h_metric; i++) {
         if ((ret = GetUINT16 (attr->stream, &pmetric->advance_width)) !=
                     HPDF_OK)
@@ -1400,6 +1464,7 @@ ParseLoca  (HPDF_FontDef  fontdef)
     HPDF_STATUS ret;
     HPDF_UINT i;
     HPDF_UINT32 *poffset;
+    const HPDF_BYTE *src;
 
     HPDF_PTRACE ((" HPDF_TTFontDef_ParseLoca\n"));
 
@@ -1434,7 +1499,26 @@ ParseLoca  (HPDF_FontDef  fontdef)
     attr->glyph_tbl.flgs[0] = 1;
 
     poffset = attr->glyph_tbl.offsets;
-    if (attr->header.index_to_loc_format == 0) {
+    src = HPDF_MappedReader_GetPtr (attr->stream, tbl->offset,
+            (attr->num_glyphs + 1) *
+            (attr->header.index_to_loc_format == 0 ? 2 : 4));
+
+    if (src) {
+        /* the offsets of a mapped font are decoded in place */
+        for (i = 0; i <= attr->num_glyphs; i++) {
+            if (attr->header.index_to_loc_format == 0) {
+                *poffset = (HPDF_UINT32)src[0] << 8 | src[1];
+                src += 2;
+            } else {
+                *poffset = (HPDF_UINT32)src[0] << 24 |
+                        (HPDF_UINT32)src[1] << 16 |
+                        (HPDF_UINT32)src[2] << 8 | src[3];
+                src += 4;
+            }
+
+            poffset++;
+        }
+    } else if (attr->header.index_to_loc_format == 0) {
         /* short version */
         for (i = 0; i <= attr->num_glyphs; i++) {
             HPDF_UINT16 tmp = 0;
@@ -1732,81 +1816,393 @@ ParseOS2  (HPDF_FontDef  fontdef)
 }
 
 
+/* adds the components of composite glyphs to the used glyphs, and numbers
+ * the used glyphs for the embedded font, which holds no other glyphs */
+static HPDF_STATUS
+SubsetGlyphs  (HPDF_FontDef   fontdef)
+{
+    HPDF_TTFontDefAttr attr = (HPDF_TTFontDefAttr)fontdef->attr;
+    HPDF_UINT count = 0;
+    HPDF_UINT prev;
+    HPDF_UINT i;
+    HPDF_STATUS ret;
+
+    HPDF_PTRACE ((" SubsetGlyphs\n"));
+
+    /* the components of a composite glyph can be composite glyphs too, and
+     * come before it. done when a pass adds no glyph behind its back */
+    do {
+        prev = count;
+        count = 0;
+
+        for (i = 0; i < attr->num_glyphs; i++) {
+            if (attr->glyph_tbl.flgs[i] != 1)
+                continue;
+
+            if ((ret = CheckCompositGryph (fontdef, (HPDF_UINT16)i)) !=
+                    HPDF_OK)
+                return ret;
+
+            count++;
+        }
+    } while (count != prev);
+
+    if (!attr->glyph_tbl.new_ids) {
+        attr->glyph_tbl.new_ids = HPDF_GetMem (fontdef->mmgr,
+                sizeof (HPDF_UINT16) * attr->num_glyphs);
+
+        if (!attr->glyph_tbl.new_ids)
+            return HPDF_Error_GetCode (fontdef->error);
+    }
+
+    /* the used glyphs keep their order, .notdef stays the first one */
+    count = 0;
+    for (i = 0; i < attr->num_glyphs; i++) {
+        if (attr->glyph_tbl.flgs[i] == 1)
+            attr->glyph_tbl.new_ids[i] = (HPDF_UINT16)count++;
+        else
+            attr->glyph_tbl.new_ids[i] = 0;
+    }
+
+    attr->glyph_tbl.new_count = (HPDF_UINT16)count;
+
+    HPDF_PTRACE ((" SubsetGlyphs %u of %u glyphs\n", count,
+                (HPDF_UINT)attr->num_glyphs));
+
+    return HPDF_OK;
+}
+
+
+HPDF_UINT16
+HPDF_TTFontDef_GetSubsetGid  (HPDF_FontDef   fontdef,
+                              HPDF_UINT16    gid)
+{
+    HPDF_TTFontDefAttr attr = (HPDF_TTFontDefAttr)fontdef->attr;
+
+    /* the font has not been saved yet */
+    if (!attr->glyph_tbl.new_ids)
+        return gid;
+
+    if (gid >= attr->num_glyphs || attr->glyph_tbl.flgs[gid] != 1)
+        return 0;
+
+    return attr->glyph_tbl.new_ids[gid];
+}
+
+
+static void
+RenumberComponents  (HPDF_TTFontDefAttr   attr,
+                     HPDF_BYTE           *buf,
+                     HPDF_UINT            len)
+{
+    const HPDF_UINT16 ARG_1_AND_2_ARE_WORDS = 1;
+    const HPDF_UINT16 WE_HAVE_A_SCALE  = 8;
+    const HPDF_UINT16 MORE_COMPONENTS = 32;
+    const HPDF_UINT16 WE_HAVE_AN_X_AND_Y_SCALE = 64;
+    const HPDF_UINT16 WE_HAVE_A_TWO_BY_TWO = 128;
+    HPDF_UINT pos = 10;
+    HPDF_UINT16 flags;
+
+    do {
+        HPDF_UINT16 gid;
+
+        if (pos + 4 > len)
+            break;
+
+        flags = (HPDF_UINT16)(buf[pos] << 8 | buf[pos + 1]);
+        gid = (HPDF_UINT16)(buf[pos + 2] << 8 | buf[pos + 3]);
+
+        gid = (gid < attr->num_glyphs) ? attr->glyph_tbl.new_ids[gid] : 0;
+        buf[pos + 2] = (HPDF_BYTE)(gid >> 8);
+        buf[pos + 3] = (HPDF_BYTE)gid;
+
+        pos += (flags & ARG_1_AND_2_ARE_WORDS) ? 8 : 6;
+
+        if (flags & WE_HAVE_A_SCALE)
+            pos += 2;
+        else if (flags & WE_HAVE_AN_X_AND_Y_SCALE)
+            pos += 4;
+        else if (flags & WE_HAVE_A_TWO_BY_TWO)
+            pos += 8;
+    } while (flags & MORE_COMPONENTS);
+}
+
+
+static HPDF_STATUS
+WriteGlyph  (HPDF_FontDef   fontdef,
+             HPDF_UINT      offset,
+             HPDF_UINT      len,
+             HPDF_Stream    stream)
+{
+    HPDF_TTFontDefAttr attr = (HPDF_TTFontDefAttr)fontdef->attr;
+    const HPDF_BYTE *src = HPDF_MappedReader_GetPtr (attr->stream, offset,
+                len);
+    HPDF_BYTE buf[HPDF_STREAM_BUF_SIZ];
+    HPDF_BYTE *tmp = buf;
+    HPDF_STATUS ret;
+
+    /* the simple glyphs of a mapped font are copied from the mapping,
+     * composite ones are copied to renumber their components */
+    if (src && (len < 10 || src[0] != 0xFF || src[1] != 0xFF))
+        return HPDF_Stream_Write (stream, src, len);
+
+    if (len > HPDF_STREAM_BUF_SIZ) {
+        tmp = HPDF_GetMem (fontdef->mmgr, len);
+        if (!tmp)
+            return HPDF_Error_GetCode (fontdef->error);
+    }
+
+    if (src) {
+        HPDF_MemCpy (tmp, src, len);
+        ret = HPDF_OK;
+    } else {
+        HPDF_UINT rlen = len;
+
+        ret = HPDF_Stream_Seek (attr->stream, offset, HPDF_SEEK_SET);
+        if (ret == HPDF_OK)
+            ret = HPDF_Stream_Read (attr->stream, tmp, &rlen);
+    }
+
+    if (ret == HPDF_OK) {
+        /* numberOfContours of a composite glyph is -1 */
+        if (len >= 10 && tmp[0] == 0xFF && tmp[1] == 0xFF)
+            RenumberComponents (attr, tmp, len);
+
+        ret = HPDF_Stream_Write (stream, tmp, len);
+    }
+
+    if (tmp != buf)
+        HPDF_FreeMem (fontdef->mmgr, tmp);
+
+    return ret;
+}
+
+
 static HPDF_STATUS
 RecreateGLYF  (HPDF_FontDef   fontdef,
                HPDF_UINT32   *new_offsets,
                HPDF_Stream    stream)
 {
-    HPDF_UINT32 save_offset = 0;
     HPDF_UINT32 start_offset = stream->size;
     HPDF_TTFontDefAttr attr = (HPDF_TTFontDefAttr)fontdef->attr;
     HPDF_STATUS ret;
+    HPDF_UINT32 end_offset;
     HPDF_INT i;
 
     HPDF_PTRACE ((" RecreateGLYF\n"));
 
     for (i = 0; i < attr->num_glyphs; i++) {
-        HPDF_BYTE buf[HPDF_STREAM_BUF_SIZ];
-
         if (attr->glyph_tbl.flgs[i] == 1) {
             HPDF_UINT offset = attr->glyph_tbl.offsets[i];
             HPDF_UINT len = attr->glyph_tbl.offsets[i + 1] - offset;
+            HPDF_UINT new_id = attr->glyph_tbl.new_ids[i];
 
-            new_offsets[i] = stream->size - start_offset;
+            new_offsets[new_id] = stream->size - start_offset;
             if (attr->header.index_to_loc_format == 0) {
-                new_offsets[i] /= 2;
+                new_offsets[new_id] /= 2;
                 len *= 2;
             }
 
             HPDF_PTRACE((" RecreateGLYF[%u] move from [%u] to [%u]\n", i,
                         (HPDF_UINT)attr->glyph_tbl.base_offset + offset,
-                        (HPDF_UINT)new_offsets[i]));
+                        (HPDF_UINT)new_offsets[new_id]));
 
             if (attr->header.index_to_loc_format == 0)
                 offset *= 2;
 
             offset += attr->glyph_tbl.base_offset;
 
-            if ((ret = HPDF_Stream_Seek (attr->stream, offset, HPDF_SEEK_SET))
-                    != HPDF_OK)
+            if ((ret = WriteGlyph (fontdef, offset, len, stream)) != HPDF_OK)
                 return ret;
+        }
+    }
 
-            while (len > 0) {
-                HPDF_UINT tmp_len =
-                    (len > HPDF_STREAM_BUF_SIZ) ? HPDF_STREAM_BUF_SIZ : len;
+    end_offset = stream->size - start_offset;
+    if (attr->header.index_to_loc_format == 0)
+        end_offset /= 2;
 
-                HPDF_MemSet (buf, 0, tmp_len);
+    new_offsets[attr->glyph_tbl.new_count] = end_offset;
 
-                if ((ret = HPDF_Stream_Read (attr->stream, buf, &tmp_len))
-                        != HPDF_OK)
-                    return ret;
+#ifdef DEBUG
+    for (i = 0; i <= attr->glyph_tbl.new_count; i++) {
+        HPDF_PTRACE((" RecreateGLYF[%u] offset=%u\n", i, new_offsets[i]));
+    }
+#endif
 
-                if ((ret = HPDF_Stream_Write (stream, buf, tmp_len)) !=
-                        HPDF_OK)
-                    return ret;
+    return HPDF_OK;
+}
+
+
+/* the runs of codes whose glyph ids in the subset follow each other, which
+ * are the segments of its cmap. returns their count, and stores up to max
+ * of them when start is not NULL */
+static HPDF_UINT
+CMapRuns  (HPDF_FontDef   fontdef,
+           HPDF_UINT16   *start,
+           HPDF_UINT16   *end,
+           HPDF_UINT16   *delta,
+           HPDF_UINT      max)
+{
+    HPDF_TTFontDefAttr attr = (HPDF_TTFontDefAttr)fontdef->attr;
+    HPDF_UINT seg_count = attr->cmap.seg_count_x2 / 2;
+    HPDF_UINT count = 0;
+    HPDF_INT32 prev_code = -1;
+    HPDF_UINT16 prev_delta = 0;
+    HPDF_UINT i;
+
+    for (i = 0; i < seg_count; i++) {
+        HPDF_UINT code = attr->cmap.start_count[i];
+
+        for (; code <= attr->cmap.end_count[i] && code < 0xFFFF; code++) {
+            HPDF_UINT16 gid = CMapSegmentGlyph (attr, i, (HPDF_UINT16)code);
+            HPDF_UINT16 new_id = HPDF_TTFontDef_GetSubsetGid (fontdef, gid);
+            HPDF_UINT16 d = (HPDF_UINT16)(new_id - code);
+
+            /* codes without a used glyph, or out of order in a broken
+             * font, are left out */
+            if (new_id == 0 || (HPDF_INT32)code <= prev_code)
+                continue;
 
-                len -= tmp_len;
+            if ((HPDF_INT32)code == prev_code + 1 && d == prev_delta) {
+                if (end && count <= max)
+                    end[count - 1] = (HPDF_UINT16)code;
+            } else {
+                if (start && count < max) {
+                    start[count] = (HPDF_UINT16)code;
+                    end[count] = (HPDF_UINT16)code;
+                    delta[count] = d;
+                }
+
+                count++;
             }
 
-            save_offset = stream->size - start_offset;
-            if (attr->header.index_to_loc_format == 0)
-                save_offset /= 2;
-        } else {
-            new_offsets[i] = save_offset;
+            prev_code = (HPDF_INT32)code;
+            prev_delta = d;
         }
     }
 
-    new_offsets[attr->num_glyphs] = save_offset;
+    return count;
+}
 
-#ifdef DEBUG
-    for (i = 0; i <= attr->num_glyphs; i++) {
-        HPDF_PTRACE((" RecreateGLYF[%u] offset=%u\n", i, new_offsets[i]));
+
+static HPDF_STATUS
+RecreateCMap  (HPDF_FontDef   fontdef,
+               HPDF_Stream    stream)
+{
+    HPDF_TTFontDefAttr attr = (HPDF_TTFontDefAttr)fontdef->attr;
+    HPDF_STATUS ret = HPDF_OK;
+    HPDF_UINT i;
+
+    HPDF_PTRACE ((" RecreateCMap\n"));
+
+    ret += WriteUINT16 (stream, 0);
+    ret += WriteUINT16 (stream, 1);
+
+    if (attr->cmap.format == 0) {
+        HPDF_BYTE ids[256];
+
+        for (i = 0; i < 256; i++) {
+            HPDF_UINT16 new_id = HPDF_TTFontDef_GetSubsetGid (fontdef,
+                        attr->cmap.glyph_id_array[i]);
+
+            ids[i] = (HPDF_BYTE)((new_id < 256) ? new_id : 0);
+        }
+
+        ret += WriteUINT16 (stream, 1);
+        ret += WriteUINT16 (stream, 0);
+        ret += WriteUINT32 (stream, 12);
+        ret += WriteUINT16 (stream, 0);
+        ret += WriteUINT16 (stream, 6 + 256);
+        ret += WriteUINT16 (stream, 0);
+        ret += HPDF_Stream_Write (stream, ids, 256);
+    } else {
+        HPDF_UINT runs = CMapRuns (fontdef, NULL, NULL, NULL, 0);
+        HPDF_UINT seg_count;
+        HPDF_UINT search_range = 1;
+        HPDF_UINT entry_selector = 0;
+        HPDF_UINT16 *start;
+        HPDF_UINT16 *end;
+        HPDF_UINT16 *delta;
+
+        if (runs > HPDF_TTF_MAX_CMAP_RUNS)
+            runs = HPDF_TTF_MAX_CMAP_RUNS;
+
+        seg_count = runs + 1;
+        start = HPDF_GetMem (fontdef->mmgr,
+                sizeof (HPDF_UINT16) * seg_count * 3);
+        if (!start)
+            return HPDF_Error_GetCode (fontdef->error);
+
+        end = start + seg_count;
+        delta = end + seg_count;
+        CMapRuns (fontdef, start, end, delta, runs);
+
+        /* the closing segment */
+        start[runs] = 0xFFFF;
+        end[runs] = 0xFFFF;
+        delta[runs] = 1;
+
+        while (search_range * 2 <= seg_count) {
+            search_range *= 2;
+            entry_selector++;
+        }
+        search_range *= 2;
+
+        ret += WriteUINT16 (stream, 3);
+        ret += WriteUINT16 (stream, 1);
+        ret += WriteUINT32 (stream, 12);
+        ret += WriteUINT16 (stream, 4);
+        ret += WriteUINT16 (stream, (HPDF_UINT16)(16 + 8 * seg_count));
+        ret += WriteUINT16 (stream, 0);
+        ret += WriteUINT16 (stream, (HPDF_UINT16)(seg_count * 2));
+        ret += WriteUINT16 (stream, (HPDF_UINT16)search_range);
+        ret += WriteUINT16 (stream, (HPDF_UINT16)entry_selector);
+        ret += WriteUINT16 (stream,
+                (HPDF_UINT16)(seg_count * 2 - search_range));
+
+        for (i = 0; i < seg_count; i++)
+            ret += WriteUINT16 (stream, end[i]);
+
+        ret += WriteUINT16 (stream, 0);
+
+        for (i = 0; i < seg_count; i++)
+            ret += WriteUINT16 (stream, start[i]);
+
+        for (i = 0; i < seg_count; i++)
+            ret += WriteUINT16 (stream, delta[i]);
+
+        for (i = 0; i < seg_count; i++)
+            ret += WriteUINT16 (stream, 0);
+
+        HPDF_FreeMem (fontdef->mmgr, start);
     }
-#endif
+
+    if (ret != HPDF_OK)
+        return HPDF_Error_GetCode (fontdef->error);
 
     return HPDF_OK;
 }
 
+
+static HPDF_STATUS
+ReadTable  (HPDF_FontDef    fontdef,
+            HPDF_TTFTable  *tbl,
+            HPDF_BYTE      *buf,
+            HPDF_UINT       len)
+{
+    HPDF_TTFontDefAttr attr = (HPDF_TTFontDefAttr)fontdef->attr;
+    HPDF_STATUS ret;
+
+    if (tbl->length < len)
+        return HPDF_SetError (fontdef->error, HPDF_TTF_INVALID_FOMAT, 0);
+
+    ret = HPDF_Stream_Seek (attr->stream, tbl->offset, HPDF_SEEK_SET);
+    if (ret != HPDF_OK)
+        return ret;
+
+    return HPDF_Stream_Read (attr->stream, buf, &len);
+}
+
 static HPDF_STATUS
 RecreateName  (HPDF_FontDef   fontdef,
                HPDF_Stream    stream)
@@ -1984,12 +2380,20 @@ HPDF_TTFontDef_SaveFontData  (HPDF_FontDef   fontdef,
         return HPDF_Error_GetCode (fontdef->error);
     }
 
+    /* only the used glyphs are embedded, renumbered from 0, so that glyf,
+     * loca, hmtx and cmap are made for them, and the glyph count in hhea
+     * and maxp is changed. post keeps no glyph names */
+    if ((ret = SubsetGlyphs (fontdef)) != HPDF_OK)
+        goto Exit;
+
     for (i = 0; i < HPDF_REQUIRED_TAGS_COUNT; i++) {
         HPDF_TTFTable *tbl = FindTable (fontdef, REQUIRED_TAGS[i]);
         HPDF_UINT32 length;
         HPDF_UINT new_offset;
         HPDF_UINT32 *poffset;
         HPDF_UINT32 value;
+        const HPDF_BYTE *src;
+        HPDF_BYTE buf[36];
 
         if (!tbl) {
             ret = HPDF_SetError (fontdef->error, HPDF_TTF_MISSING_TABLE, i);
@@ -2014,18 +2418,57 @@ HPDF_TTFontDef_SaveFontData  (HPDF_FontDef   fontdef,
             poffset = new_offsets;
 
             if (attr->header.index_to_loc_format == 0) {
-                for (j = 0; j <= attr->num_glyphs; j++) {
+                for (j = 0; j <= attr->glyph_tbl.new_count; j++) {
                     ret += WriteUINT16 (tmp_stream, (HPDF_UINT16)*poffset);
                     poffset++;
                 }
             } else {
-                for (j = 0; j <= attr->num_glyphs; j++) {
+                for (j = 0; j <= attr->glyph_tbl.new_count; j++) {
                     ret += WriteUINT32 (tmp_stream, *poffset);
                     poffset++;
                 }
             }
+        } else if (HPDF_MemCmp ((HPDF_BYTE *)tbl->tag, (HPDF_BYTE *)"hmtx", 4) == 0) {
+            HPDF_UINT j;
+
+            /* a full metric for every glyph */
+            for (j = 0; j < attr->num_glyphs; j++) {
+                if (attr->glyph_tbl.flgs[j] == 1) {
+                    ret += WriteUINT16 (tmp_stream,
+                            attr->h_metric[j].advance_width);
+                    ret += WriteINT16 (tmp_stream, attr->h_metric[j].lsb);
+                }
+            }
+        } else if (HPDF_MemCmp ((HPDF_BYTE *)tbl->tag, (HPDF_BYTE *)"hhea", 4) == 0) {
+            /* numberOfHMetrics */
+            if ((ret = ReadTable (fontdef, tbl, buf, 36)) == HPDF_OK) {
+                buf[34] = (HPDF_BYTE)(attr->glyph_tbl.new_count >> 8);
+                buf[35] = (HPDF_BYTE)attr->glyph_tbl.new_count;
+                ret = HPDF_Stream_Write (tmp_stream, buf, 36);
+            }
+        } else if (HPDF_MemCmp ((HPDF_BYTE *)tbl->tag, (HPDF_BYTE *)"maxp", 4) == 0) {
+            HPDF_UINT len = (length < 32) ? 6 : 32;
+
+            /* numGlyphs */
+            if ((ret = ReadTable (fontdef, tbl, buf, len)) == HPDF_OK) {
+                buf[4] = (HPDF_BYTE)(attr->glyph_tbl.new_count >> 8);
+                buf[5] = (HPDF_BYTE)attr->glyph_tbl.new_count;
+                ret = HPDF_Stream_Write (tmp_stream, buf, len);
+            }
+        } else if (HPDF_MemCmp ((HPDF_BYTE *)tbl->tag, (HPDF_BYTE *)"post", 4) == 0) {
+            /* version 3.0, the glyph names are by the old glyph ids */
+            if ((ret = ReadTable (fontdef, tbl, buf, 32)) == HPDF_OK) {
+                HPDF_MemSet (buf, 0, 4);
+                buf[1] = 3;
+                ret = HPDF_Stream_Write (tmp_stream, buf, 32);
+            }
+        } else if (HPDF_MemCmp ((HPDF_BYTE *)tbl->tag, (HPDF_BYTE *)"cmap", 4) == 0) {
+            ret = RecreateCMap (fontdef, tmp_stream);
         } else if (HPDF_MemCmp ((HPDF_BYTE *)tbl->tag, (HPDF_BYTE *)"name", 4) == 0) {
             ret = RecreateName (fontdef, tmp_stream);
+        } else if ((src = HPDF_MappedReader_GetPtr (attr->stream, tbl->offset,
+                        length)) != NULL) {
+            ret = HPDF_Stream_Write (tmp_stream, src, length);
         } else {
             HPDF_UINT size = 4;
 
@@ -2046,6 +2489,13 @@ HPDF_TTFontDef_SaveFontData  (HPDF_FontDef   fontdef,
         tmp_tbl[i].offset = new_offset;
         tmp_tbl[i].length = tmp_stream->size - new_offset;
 
+        /* tables start on a 4 byte boundary */
+        if (ret == HPDF_OK && (tmp_stream->size & 3) != 0) {
+            value = 0;
+            ret = HPDF_Stream_Write (tmp_stream, (HPDF_BYTE *)&value,
+                    4 - (tmp_stream->size & 3));
+        }
+
         if (ret != HPDF_OK)
             goto Exit;
     }
@@ -2172,6 +2622,236 @@ HPDF_TTFontDef_SetTagName  (HPDF_FontDef   fontdef,
     HPDF_MemCpy ((HPDF_BYTE *)attr->base_font, (HPDF_BYTE *)buf, HPDF_LIMIT_MAX_NAME_LEN + 1);
 }
 
+
+/*---------------------------------------------------------------------------*/
+/*----- font cache ----------------------------------------------------------*/
+
+HPDF_FontCache
+HPDF_FontCache_New  (void)
+{
+    HPDF_Error_Rec tmp_error;
+    HPDF_MMgr mmgr;
+    HPDF_FontCache cache;
+
+    HPDF_PTRACE ((" HPDF_FontCache_New\n"));
+
+    HPDF_Error_Init (&tmp_error, NULL);
+
+    mmgr = HPDF_MMgr_New (&tmp_error, 0, NULL, NULL);
+    if (!mmgr)
+        return NULL;
+
+    cache = HPDF_GetMem (mmgr, sizeof(HPDF_FontCache_Rec));
+    if (!cache) {
+        HPDF_MMgr_Free (mmgr);
+        return NULL;
+    }
+
+    HPDF_MemSet (cache, 0, sizeof(HPDF_FontCache_Rec));
+    cache->sig_bytes = HPDF_FONTCACHE_SIG_BYTES;
+    cache->mmgr = mmgr;
+    HPDF_Error_Init (&cache->error, NULL);
+    mmgr->error = &cache->error;
+
+    return cache;
+}
+
+
+static void
+FontCache_Release  (HPDF_FontCacheEntry  entry)
+{
+    HPDF_MMgr mmgr = entry->mmgr;
+
+    if (--entry->refs > 0)
+        return;
+
+    HPDF_PTRACE ((" HPDF_FontCache_Release %s\n", entry->file_name));
+
+    HPDF_FontDef_Free (entry->fontdef);
+    HPDF_FreeMem (mmgr, entry->file_name);
+    HPDF_FreeMem (mmgr, entry);
+}
+
+
+void
+HPDF_FontCache_Free  (HPDF_FontCache  cache)
+{
+    HPDF_MMgr mmgr;
+
+    HPDF_PTRACE ((" HPDF_FontCache_Free\n"));
+
+    if (!cache || cache->sig_bytes != HPDF_FONTCACHE_SIG_BYTES)
+        return;
+
+    while (cache->entries) {
+        HPDF_FontCacheEntry entry = cache->entries;
+
+        cache->entries = entry->next;
+        FontCache_Release (entry);
+    }
+
+    mmgr = cache->mmgr;
+    cache->sig_bytes = 0;
+    HPDF_FreeMem (mmgr, cache);
+    HPDF_MMgr_Free (mmgr);
+}
+
+
+HPDF_STATUS
+HPDF_FontCache_Remove  (HPDF_FontCache  cache,
+                        const char      *file_name)
+{
+    HPDF_FontCacheEntry *link;
+
+    HPDF_PTRACE ((" HPDF_FontCache_Remove\n"));
+
+    for (link = &cache->entries; *link; link = &(*link)->next) {
+        HPDF_FontCacheEntry entry = *link;
+
+        if (HPDF_StrCmp (entry->file_name, file_name) == 0) {
+            *link = entry->next;
+
+            /* fontdefs still using the entry keep it until they are freed */
+            FontCache_Release (entry);
+
+            return HPDF_OK;
+        }
+    }
+
+    return HPDF_ITEM_NOT_FOUND;
+}
+
+
+static HPDF_FontCacheEntry
+FontCache_Find  (HPDF_FontCache  cache,
+                 const char      *file_name)
+{
+    HPDF_FontCacheEntry entry;
+    HPDF_Stream stream;
+    HPDF_UINT len;
+
+    for (entry = cache->entries; entry; entry = entry->next)
+        if (HPDF_StrCmp (entry->file_name, file_name) == 0)
+            return entry;
+
+    entry = HPDF_GetMem (cache->mmgr, sizeof(HPDF_FontCacheEntry_Rec));
+    if (!entry)
+        return NULL;
+
+    HPDF_MemSet (entry, 0, sizeof(HPDF_FontCacheEntry_Rec));
+    entry->mmgr = cache->mmgr;
+
+    len = HPDF_StrLen (file_name, -1) + 1;
+    entry->file_name = HPDF_GetMem (cache->mmgr, len);
+    if (!entry->file_name) {
+        HPDF_FreeMem (cache->mmgr, entry);
+        return NULL;
+    }
+    HPDF_MemCpy ((HPDF_BYTE *)entry->file_name, (HPDF_BYTE *)file_name, len);
+
+    /* the tables are parsed without embedding, so that the entry does not
+     * hold the file open. documents embedding the font open it again */
+    stream = HPDF_MappedReader_New (cache->mmgr, file_name);
+    if (stream)
+        entry->fontdef = HPDF_TTFontDef_Load (cache->mmgr, stream, HPDF_FALSE);
+
+    if (!entry->fontdef) {
+        HPDF_FreeMem (cache->mmgr, entry->file_name);
+        HPDF_FreeMem (cache->mmgr, entry);
+        return NULL;
+    }
+
+    entry->refs = 1;
+    entry->next = cache->entries;
+    cache->entries = entry;
+
+    return entry;
+}
+
+
+HPDF_FontDef
+HPDF_TTFontDef_LoadCached  (HPDF_MMgr       mmgr,
+                            HPDF_FontCache  cache,
+                            const char      *file_name,
+                            HPDF_BOOL       embedding)
+{
+    HPDF_FontCacheEntry entry;
+    HPDF_FontDef fontdef;
+    HPDF_TTFontDefAttr attr;
+    HPDF_TTFontDefAttr shared_attr;
+
+    HPDF_PTRACE ((" HPDF_TTFontDef_LoadCached\n"));
+
+    entry = FontCache_Find (cache, file_name);
+    if (!entry) {
+        /* report the error of the cache on the document */
+        HPDF_SetError (mmgr->error, cache->error.error_no,
+                cache->error.detail_no);
+        HPDF_Error_Reset (&cache->error);
+        return NULL;
+    }
+
+    shared_attr = (HPDF_TTFontDefAttr)entry->fontdef->attr;
+
+    if (embedding && (shared_attr->fs_type & (0x0002 | 0x0100 | 0x0200))) {
+        HPDF_SetError (mmgr->error, HPDF_TTF_CANNOT_EMBEDDING_FONT, 0);
+        return NULL;
+    }
+
+    fontdef = HPDF_TTFontDef_New (mmgr);
+    if (!fontdef)
+        return NULL;
+
+    /* the fontdef takes the metrics of the entry, and the attributes refer
+     * to its tables */
+    attr = (HPDF_TTFontDefAttr)fontdef->attr;
+    HPDF_MemCpy ((HPDF_BYTE *)fontdef->base_font,
+            (HPDF_BYTE *)entry->fontdef->base_font, HPDF_LIMIT_MAX_NAME_LEN + 1);
+    fontdef->ascent = entry->fontdef->ascent;
+    fontdef->descent = entry->fontdef->descent;
+    fontdef->flags = entry->fontdef->flags;
+    fontdef->font_bbox = entry->fontdef->font_bbox;
+    fontdef->italic_angle = entry->fontdef->italic_angle;
+    fontdef->stemv = entry->fontdef->stemv;
+    fontdef->avg_width = entry->fontdef->avg_width;
+    fontdef->max_width = entry->fontdef->max_width;
+    fontdef->missing_width = entry->fontdef->missing_width;
+    fontdef->stemh = entry->fontdef->stemh;
+    fontdef->x_height = entry->fontdef->x_height;
+    fontdef->cap_height = entry->fontdef->cap_height;
+    fontdef->valid = entry->fontdef->valid;
+
+    *attr = *shared_attr;
+    attr->shared = entry;
+    attr->glyph_tbl.flgs = NULL;
+    attr->glyph_tbl.new_ids = NULL;
+    attr->glyph_tbl.new_count = 0;
+    attr->stream = NULL;
+    attr->embedding = embedding;
+    entry->refs++;
+
+    attr->glyph_tbl.flgs = HPDF_GetMem (mmgr,
+            sizeof (HPDF_BYTE) * attr->num_glyphs);
+    if (!attr->glyph_tbl.flgs) {
+        HPDF_FontDef_Free (fontdef);
+        return NULL;
+    }
+
+    HPDF_MemSet (attr->glyph_tbl.flgs, 0,
+            sizeof (HPDF_BYTE) * attr->num_glyphs);
+    attr->glyph_tbl.flgs[0] = 1;
+
+    if (embedding) {
+        attr->stream = HPDF_MappedReader_New (mmgr, file_name);
+        if (!attr->stream) {
+            HPDF_FontDef_Free (fontdef);
+            return NULL;
+        }
+    }
+
+    return fontdef;
+}
+
 /*
 int
 PdfTTFontDef::GetNameAttr(unsigned char* buf, HPDF_UINT name_id,
@@ -51,8 +51,10 @@ FreeWidth  (HPDF_FontDef  fontdef)
 
     HPDF_PTRACE ((" FreeWidth\n"));
 
-    HPDF_FreeMem (fontdef->mmgr, attr->widths);
+    if (!attr->widths_shared)
+        HPDF_FreeMem (fontdef->mmgr, attr->widths);
     attr->widths = NULL;
+    attr->widths_shared = HPDF_FALSE;
 
     fontdef->valid = HPDF_FALSE;
 }
@@ -474,6 +476,35 @@ HPDF_Type1FontDef_SetWidths  (HPDF_FontDef          fontdef,
 }
 
 
+/* like HPDF_Type1FontDef_SetWidths, but the widths table is static and is
+ * used as it is, without a copy for every document.
+ */
+void
+HPDF_Type1FontDef_ShareWidths  (HPDF_FontDef          fontdef,
+                                const HPDF_CharData*  widths)
+{
+    const HPDF_CharData* src = widths;
+    HPDF_Type1FontDefAttr attr = (HPDF_Type1FontDefAttr)fontdef->attr;
+    HPDF_UINT i = 0;
+
+    HPDF_PTRACE ((" HPDF_Type1FontDef_ShareWidths\n"));
+
+    FreeWidth (fontdef);
+
+    while (src->unicode != 0xFFFF) {
+        if (src->unicode == 0x0020) {
+            fontdef->missing_width = src->width;
+        }
+        src++;
+        i++;
+    }
+
+    attr->widths = (HPDF_CharData*)widths;
+    attr->widths_count = i;
+    attr->widths_shared = HPDF_TRUE;
+}
+
+
 HPDF_INT16
 HPDF_Type1FontDef_GetWidthByName  (HPDF_FontDef      fontdef,
                                    const char*  gryph_name)
@@ -518,7 +549,8 @@ FreeFunc (HPDF_FontDef  fontdef)
     if (attr->font_data)
         HPDF_Stream_Free (attr->font_data);
 
-    HPDF_FreeMem (fontdef->mmgr, attr->widths);
+    if (!attr->widths_shared)
+        HPDF_FreeMem (fontdef->mmgr, attr->widths);
     HPDF_FreeMem (fontdef->mmgr, attr);
 }
 
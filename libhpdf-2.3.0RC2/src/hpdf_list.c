@@ -80,8 +80,12 @@ HPDF_List_Add  (HPDF_List  list,
     HPDF_PTRACE((" HPDF_List_Add\n"));
 
     if (list->count >= list->block_siz) {
-        HPDF_STATUS ret = Resize (list,
-                list->block_siz + list->items_per_block);
+        /* grow large lists by half their size, so that adding many items
+         * does not take quadratic time */
+        HPDF_UINT grow = list->block_siz / 2;
+        HPDF_STATUS ret = Resize (list, list->block_siz +
+                (grow > list->items_per_block ? grow : list->items_per_block));
+
 
         if (ret != HPDF_OK) {
             return ret;
@@ -59,6 +59,7 @@ HPDF_MMgr_New  (HPDF_Error       error,
     if (mmgr != NULL) {
         /* initialize mmgr object */
         mmgr->error = error;
+        mmgr->spill = NULL;
 
 
 #ifdef HPDF_MEM_DEBUG
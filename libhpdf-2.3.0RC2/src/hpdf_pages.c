@@ -358,6 +358,200 @@ HPDF_Page_New  (HPDF_MMgr   mmgr,
 }
 
 
+/* finishes the page off as when it is written, ahead of HPDF_Page_Flush.
+ * contents is set to the contents stream, so that it can be deflated
+ * before the page is written, or to NULL if the page has been flushed */
+HPDF_STATUS
+HPDF_Page_PrepareFlush  (HPDF_Page    page,
+                         HPDF_Dict    *contents)
+{
+    HPDF_PageAttr attr = (HPDF_PageAttr)page->attr;
+    HPDF_STATUS ret;
+
+    HPDF_PTRACE((" HPDF_Page_PrepareFlush\n"));
+
+    *contents = attr->contents;
+
+    if (attr->contents && !page->prepared) {
+        if ((ret = Page_BeforeWrite (page)) != HPDF_OK)
+            return ret;
+        page->prepared = HPDF_TRUE;
+    }
+
+    return HPDF_OK;
+}
+
+
+/* writes the page and its contents to stream ahead of the rest of the
+ * document, and releases the contents. nothing more can be drawn on the
+ * page afterwards */
+HPDF_STATUS
+HPDF_Page_Flush  (HPDF_Page    page,
+                  HPDF_Stream  stream)
+{
+    HPDF_PageAttr attr = (HPDF_PageAttr)page->attr;
+    HPDF_Dict contents = attr->contents;
+    HPDF_STATUS ret;
+
+    HPDF_PTRACE((" HPDF_Page_Flush\n"));
+
+    if (!contents)
+        return HPDF_OK;
+
+    /* the page refers to its contents, so is written first. it stays in
+     * memory as the page tree, outlines and annotations refer to it */
+    if ((ret = HPDF_Xref_WriteObject (attr->xref, page, stream)) != HPDF_OK ||
+            (ret = HPDF_Xref_WriteObject (attr->xref, contents, stream)) !=
+            HPDF_OK)
+        return ret;
+
+    if ((ret = HPDF_Dict_RemoveElement (page, "Contents")) != HPDF_OK)
+        return ret;
+
+    HPDF_Xref_ReleaseObject (attr->xref, contents);
+
+    /* no graphics mode allows drawing on the page any more */
+    attr->contents = NULL;
+    attr->stream = NULL;
+    attr->gmode = 0;
+
+    return HPDF_OK;
+}
+
+
+/*----------------------------------------------------------------------------*/
+/*----- HPDF_Form ------------------------------------------------------------*/
+
+/*
+ * A form XObject is created through a drawing surface which is a page object
+ * that is never added to the page tree or to the xref.  Its contents stream
+ * is the form itself and its resources are shared with the form, so all the
+ * page operators can be used to draw the form.
+ */
+HPDF_Page
+HPDF_Form_New  (HPDF_MMgr   mmgr,
+                HPDF_Xref   xref,
+                HPDF_REAL   width,
+                HPDF_REAL   height)
+{
+    HPDF_STATUS ret = HPDF_OK;
+    HPDF_PageAttr attr;
+    HPDF_Page canvas;
+    HPDF_Dict form;
+    HPDF_Dict resource;
+    HPDF_Array bbox;
+    HPDF_Array procset;
+
+    HPDF_PTRACE((" HPDF_Form_New\n"));
+
+    form = HPDF_DictStream_New (mmgr, xref);
+    if (!form)
+        return NULL;
+
+    form->header.obj_class |= HPDF_OSUBCLASS_XOBJECT;
+
+    /* the resources are an indirect object so that they can be referred to
+     * by both the form and the drawing surface
+     */
+    resource = HPDF_Dict_New (mmgr);
+    if (!resource)
+        return NULL;
+
+    if (HPDF_Xref_Add (xref, resource) != HPDF_OK)
+        return NULL;
+
+    bbox = HPDF_Array_New (mmgr);
+    if (!bbox)
+        return NULL;
+
+    ret += HPDF_Dict_AddName (form, "Type", "XObject");
+    ret += HPDF_Dict_AddName (form, "Subtype", "Form");
+    ret += HPDF_Dict_Add (form, "BBox", bbox);
+    ret += HPDF_Array_AddReal (bbox, 0);
+    ret += HPDF_Array_AddReal (bbox, 0);
+    ret += HPDF_Array_AddReal (bbox, width);
+    ret += HPDF_Array_AddReal (bbox, height);
+    ret += HPDF_Dict_Add (form, "Resources", resource);
+
+    procset = HPDF_Array_New (mmgr);
+    if (!procset)
+        return NULL;
+
+    ret += HPDF_Dict_Add (resource, "ProcSet", procset);
+    ret += HPDF_Array_Add (procset, HPDF_Name_New (mmgr, "PDF"));
+    ret += HPDF_Array_Add (procset, HPDF_Name_New (mmgr, "Text"));
+
+    if (ret != HPDF_OK)
+        return NULL;
+
+    canvas = HPDF_Dict_New (mmgr);
+    if (!canvas)
+        return NULL;
+
+    canvas->header.obj_class |= HPDF_OSUBCLASS_PAGE;
+    canvas->free_fn = Page_OnFree;
+
+    attr = HPDF_GetMem (canvas->mmgr, sizeof(HPDF_PageAttr_Rec));
+    if (!attr) {
+        HPDF_Dict_Free (canvas);
+        return NULL;
+    }
+
+    canvas->attr = attr;
+    HPDF_MemSet (attr, 0, sizeof(HPDF_PageAttr_Rec));
+    attr->gmode = HPDF_GMODE_PAGE_DESCRIPTION;
+    attr->cur_pos = HPDF_ToPoint (0, 0);
+    attr->text_pos = HPDF_ToPoint (0, 0);
+
+    attr->gstate = HPDF_GState_New (canvas->mmgr, NULL);
+    if (!attr->gstate) {
+        HPDF_Dict_Free (canvas);
+        return NULL;
+    }
+
+    attr->contents = form;
+    attr->stream = form->stream;
+    attr->xref = xref;
+
+    if (HPDF_Dict_Add (canvas, "Resources", resource) != HPDF_OK) {
+        HPDF_Dict_Free (canvas);
+        return NULL;
+    }
+
+    return canvas;
+}
+
+
+HPDF_XObject
+HPDF_Form_Close  (HPDF_Page  form)
+{
+    HPDF_PageAttr attr;
+    HPDF_XObject xobj;
+
+    HPDF_PTRACE((" HPDF_Form_Close\n"));
+
+    if (!HPDF_Page_Validate (form))
+        return NULL;
+
+    attr = (HPDF_PageAttr)form->attr;
+
+    /* a text object or path must not be left open at the end of a form */
+    if (attr->gmode != HPDF_GMODE_PAGE_DESCRIPTION) {
+        HPDF_SetError (form->error, HPDF_PAGE_INVALID_GMODE, 0);
+        return NULL;
+    }
+
+    xobj = attr->contents;
+
+    /* only the surface is released, the form and its resources are owned
+     * by the xref
+     */
+    HPDF_Dict_Free (form);
+
+    return xobj;
+}
+
+
 
 
 static void
@@ -1970,6 +2164,7 @@ HPDF_Page_SetFilter  (HPDF_Page    page,
     HPDF_PTRACE((" HPDF_Page_SetFilter\n"));
 
     attr = (HPDF_PageAttr)page->attr;
-    attr->contents->filter = filter;
+    if (attr->contents)
+        attr->contents->filter = filter;
 }
 
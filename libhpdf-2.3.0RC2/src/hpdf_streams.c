@@ -35,6 +35,25 @@
 #include <zconf.h>
 #endif /* LIBHPDF_HAVE_NOZLIB */
 
+/* files read with HPDF_MappedReader_New are mapped into memory where the
+ * platform allows it, unless HPDF_NOMMAP is defined */
+#if !defined(HPDF_NOMMAP) && !defined(UNDER_CE)
+#if defined(_WIN32)
+#define HPDF_MMAP_WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define HPDF_MMAP_POSIX
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#endif
+
 HPDF_STATUS
 HPDF_MemStream_WriteFunc  (HPDF_Stream      stream,
                            const HPDF_BYTE  *ptr,
@@ -69,9 +88,34 @@ HPDF_MemStream_InWrite  (HPDF_Stream      stream,
                          const HPDF_BYTE  **ptr,
                          HPDF_UINT        *count);
 
+static HPDF_STATUS
+MemStream_Spill  (HPDF_Stream  stream,
+                  HPDF_UINT    index);
+
+static HPDF_BYTE*
+MemStream_ReadBuf  (HPDF_Stream  stream,
+                    HPDF_UINT    index);
+
+static HPDF_BYTE*
+MemStream_LoadBuf  (HPDF_Stream  stream,
+                    HPDF_UINT    index);
+
+static void
+SpillFile_Release  (HPDF_MMgr       mmgr,
+                    HPDF_SpillFile  spill,
+                    HPDF_UINT32     rec);
+
+static HPDF_STATUS
+Stream_NextInput  (HPDF_Stream  src,
+                   HPDF_BYTE    *buf,
+                   HPDF_UINT    *idx,
+                   HPDF_BYTE    **ptr,
+                   HPDF_UINT    *size);
+
 HPDF_STATUS
 HPDF_Stream_WriteToStreamWithDeflate  (HPDF_Stream  src,
                                        HPDF_Stream  dst,
+                                       HPDF_UINT    filter,
                                        HPDF_Encrypt  e);
 
 
@@ -95,6 +139,30 @@ HPDF_UINT32
 HPDF_FileStream_SizeFunc  (HPDF_Stream  stream);
 
 
+HPDF_STATUS
+HPDF_MappedReader_ReadFunc  (HPDF_Stream  stream,
+                             HPDF_BYTE    *ptr,
+                             HPDF_UINT    *siz);
+
+
+HPDF_STATUS
+HPDF_MappedReader_SeekFunc  (HPDF_Stream      stream,
+                             HPDF_INT         pos,
+                             HPDF_WhenceMode  mode);
+
+
+HPDF_INT32
+HPDF_MappedReader_TellFunc  (HPDF_Stream  stream);
+
+
+HPDF_UINT32
+HPDF_MappedReader_SizeFunc  (HPDF_Stream  stream);
+
+
+void
+HPDF_MappedReader_FreeFunc  (HPDF_Stream  stream);
+
+
 HPDF_STATUS
 HPDF_FileWriter_WriteFunc  (HPDF_Stream      stream,
                             const HPDF_BYTE  *ptr,
@@ -104,6 +172,20 @@ void
 HPDF_FileStream_FreeFunc  (HPDF_Stream  stream);
 
 
+HPDF_STATUS
+HPDF_Writer_WriteFunc  (HPDF_Stream      stream,
+                        const HPDF_BYTE  *ptr,
+                        HPDF_UINT        siz);
+
+
+HPDF_STATUS
+HPDF_Writer_FlushFunc  (HPDF_Stream  stream);
+
+
+void
+HPDF_Writer_FreeFunc  (HPDF_Stream  stream);
+
+
 
 /*
  *  HPDF_Stream_Read
@@ -377,6 +459,19 @@ HPDF_Stream_Size  (HPDF_Stream  stream)
 }
 
 
+/* writes out anything the stream holds back, before it is freed */
+HPDF_STATUS
+HPDF_Stream_Flush  (HPDF_Stream  stream)
+{
+    HPDF_PTRACE((" HPDF_Stream_Flush\n"));
+
+    if (!stream->flush_fn)
+        return HPDF_OK;
+
+    return stream->flush_fn(stream);
+}
+
+
 HPDF_STATUS
 HPDF_Stream_WriteEscapeName  (HPDF_Stream      stream,
                               const char  *value)
@@ -419,6 +514,19 @@ HPDF_Stream_WriteEscapeName  (HPDF_Stream      stream,
     return HPDF_Stream_Write (stream, (HPDF_BYTE *)tmp_char, HPDF_StrLen(tmp_char, -1));
 }
 
+/* the length of the run at the start of text which is written as it is */
+static HPDF_UINT
+EscapeText_CleanRun  (const HPDF_BYTE  *text,
+                      HPDF_UINT        len)
+{
+    HPDF_UINT i = 0;
+
+    while (i < len && !HPDF_TEXT_NEEDS_ESCAPE (text[i]))
+        i++;
+
+    return i;
+}
+
 HPDF_STATUS
 HPDF_Stream_WriteEscapeText2  (HPDF_Stream    stream,
                                const char    *text,
@@ -426,8 +534,7 @@ HPDF_Stream_WriteEscapeText2  (HPDF_Stream    stream,
 {
     char buf[HPDF_TEXT_DEFAULT_LEN];
     HPDF_UINT idx = 0;
-    HPDF_INT i;
-    const char* p = text;
+    const HPDF_BYTE* p = (const HPDF_BYTE *)text;
     HPDF_STATUS ret;
 
     HPDF_PTRACE((" HPDF_Stream_WriteEscapeText2\n"));
@@ -443,30 +550,53 @@ HPDF_Stream_WriteEscapeText2  (HPDF_Stream    stream,
 
     buf[idx++] = '(';
 
-    for (i = 0; i < (HPDF_INT)len; i++) {
-        HPDF_BYTE c = (HPDF_BYTE)*p++;
-        if (HPDF_NEEDS_ESCAPE(c)) {
-            buf[idx++] = '\\';
-
-            buf[idx] = (char)(c >> 6);
-            buf[idx] += 0x30;
-            idx++;
-            buf[idx] = (char)((c & 0x38) >> 3);
-            buf[idx] += 0x30;
-            idx++;
-            buf[idx] = (char)(c & 0x07);
-            buf[idx] += 0x30;
-            idx++;
+    while (len > 0) {
+        HPDF_UINT run = EscapeText_CleanRun (p, len);
+        HPDF_BYTE c;
+
+        /* runs needing no escape are copied in bulk, the long ones are
+         * written out directly */
+        if (run > 0) {
+            if (idx + run > HPDF_TEXT_DEFAULT_LEN - 4) {
+                ret = HPDF_Stream_Write (stream, (HPDF_BYTE *)buf, idx);
+                if (ret != HPDF_OK)
+                    return ret;
+                idx = 0;
+            }
+
+            if (run > HPDF_TEXT_DEFAULT_LEN - 4) {
+                ret = HPDF_Stream_Write (stream, p, run);
+                if (ret != HPDF_OK)
+                    return ret;
+            } else {
+                HPDF_MemCpy ((HPDF_BYTE *)buf + idx, p, run);
+                idx += run;
+            }
+
+            p += run;
+            len -= run;
+            if (len == 0)
+                break;
         }
-        else
-            buf[idx++] = c;
 
-        if (idx > HPDF_TEXT_DEFAULT_LEN - 4) {
+        if (idx > HPDF_TEXT_DEFAULT_LEN - 5) {
             ret = HPDF_Stream_Write (stream, (HPDF_BYTE *)buf, idx);
             if (ret != HPDF_OK)
                 return ret;
             idx = 0;
         }
+
+        c = *p++;
+        len--;
+        buf[idx++] = '\\';
+
+        if (c == '\\' || c == '(' || c == ')')
+            buf[idx++] = c;
+        else {
+            buf[idx++] = (char)((c >> 6) + 0x30);
+            buf[idx++] = (char)(((c & 0x38) >> 3) + 0x30);
+            buf[idx++] = (char)((c & 0x07) + 0x30);
+        }
     }
     buf[idx++] = ')';
 
@@ -557,9 +687,62 @@ HPDF_Stream_WriteBinary  (HPDF_Stream      stream,
 }
 
 
+/* the next piece of a stream to be written out. the buffers of a memory
+ * stream are passed on as they are, in one piece for a growable stream,
+ * other streams are read into buf */
+static HPDF_STATUS
+Stream_NextInput  (HPDF_Stream  src,
+                   HPDF_BYTE    *buf,
+                   HPDF_UINT    *idx,
+                   HPDF_BYTE    **ptr,
+                   HPDF_UINT    *size)
+{
+    if (src->type == HPDF_STREAM_MEMORY) {
+        HPDF_MemStreamAttr attr = (HPDF_MemStreamAttr)src->attr;
+        HPDF_UINT count = attr->buf->count;
+
+        if (*idx >= count) {
+            *size = 0;
+            return HPDF_STREAM_EOF;
+        }
+
+        *ptr = MemStream_ReadBuf (src, *idx);
+        if (!*ptr) {
+            *size = 0;
+            return HPDF_Error_GetCode (src->error);
+        }
+
+        *size = (*idx == count - 1) ? attr->w_pos : attr->buf_siz;
+        (*idx)++;
+
+        return (*idx == count) ? HPDF_STREAM_EOF : HPDF_OK;
+    }
+
+    *ptr = buf;
+    *size = HPDF_STREAM_BUF_SIZ;
+
+    return HPDF_Stream_Read (src, buf, size);
+}
+
+
+#ifndef LIBHPDF_HAVE_NOZLIB
+static int
+DeflateLevel  (HPDF_UINT  filter)
+{
+    if (filter & HPDF_STREAM_FILTER_FLATE_BEST_SPEED)
+        return Z_BEST_SPEED;
+    else if (filter & HPDF_STREAM_FILTER_FLATE_BEST_COMPRESS)
+        return Z_BEST_COMPRESSION;
+    else
+        return Z_DEFAULT_COMPRESSION;
+}
+#endif /* LIBHPDF_HAVE_NOZLIB */
+
+
 HPDF_STATUS
 HPDF_Stream_WriteToStreamWithDeflate  (HPDF_Stream  src,
                                        HPDF_Stream  dst,
+                                       HPDF_UINT    filter,
                                        HPDF_Encrypt  e)
 {
 #ifndef LIBHPDF_HAVE_NOZLIB
@@ -568,6 +751,7 @@ HPDF_Stream_WriteToStreamWithDeflate  (HPDF_Stream  src,
 
     HPDF_STATUS ret;
     HPDF_BOOL flg;
+    HPDF_UINT idx = 0;
 
     z_stream strm;
     Bytef inbuf[HPDF_STREAM_BUF_SIZ];
@@ -586,8 +770,9 @@ HPDF_Stream_WriteToStreamWithDeflate  (HPDF_Stream  src,
     strm.next_out = otbuf;
     strm.avail_out = DEFLATE_BUF_SIZ;
 
-    ret = deflateInit_(&strm, Z_DEFAULT_COMPRESSION, ZLIB_VERSION,
+    ret = deflateInit_(&strm, DeflateLevel (filter), ZLIB_VERSION,
             sizeof(z_stream));
+
     if (ret != Z_OK)
         return HPDF_SetError (src->error, HPDF_ZLIB_ERROR, ret);
 
@@ -596,11 +781,12 @@ HPDF_Stream_WriteToStreamWithDeflate  (HPDF_Stream  src,
 
     flg = HPDF_FALSE;
     for (;;) {
-        HPDF_UINT size = HPDF_STREAM_BUF_SIZ;
+        HPDF_BYTE *ptr;
+        HPDF_UINT size;
 
-        ret = HPDF_Stream_Read (src, inbuf, &size);
+        ret = Stream_NextInput (src, inbuf, &idx, &ptr, &size);
 
-        strm.next_in = inbuf;
+        strm.next_in = ptr;
         strm.avail_in = size;
 
         if (ret != HPDF_OK) {
@@ -678,12 +864,77 @@ HPDF_Stream_WriteToStreamWithDeflate  (HPDF_Stream  src,
     return HPDF_OK;
 #else /* LIBHPDF_HAVE_NOZLIB */
     HPDF_UNUSED (e);
+    HPDF_UNUSED (filter);
     HPDF_UNUSED (dst);
     HPDF_UNUSED (src);
     return HPDF_UNSUPPORTED_FUNC;
 #endif /* LIBHPDF_HAVE_NOZLIB */
 }
 
+/* the largest size that the memory stream can deflate to */
+HPDF_UINT
+HPDF_Stream_DeflateBound  (HPDF_Stream  src)
+{
+#ifndef LIBHPDF_HAVE_NOZLIB
+    return (HPDF_UINT)compressBound (HPDF_Stream_Size (src));
+#else /* LIBHPDF_HAVE_NOZLIB */
+    HPDF_UNUSED (src);
+    return 0;
+#endif /* LIBHPDF_HAVE_NOZLIB */
+}
+
+
+/* runs without touching the error object or the memory manager, so
+ * tasks for different streams can run concurrently */
+void HPDF_STDCALL
+HPDF_Stream_DeflateTask  (void  *task)
+{
+    HPDF_DeflateTask_Rec *t = (HPDF_DeflateTask_Rec *)task;
+
+#ifndef LIBHPDF_HAVE_NOZLIB
+    z_stream strm;
+    HPDF_UINT count = HPDF_MemStream_GetBufCount (t->src);
+    HPDF_UINT i;
+    int ret = Z_OK;
+
+    t->done = HPDF_FALSE;
+
+    /* buffers in the spill file are read back through the error object of
+     * the stream, it is written in the usual way */
+    if (!HPDF_MemStream_InMemory (t->src))
+        return;
+
+    HPDF_MemSet (&strm, 0x00, sizeof(z_stream));
+    strm.next_out = t->buf;
+    strm.avail_out = t->len;
+
+    if (deflateInit_(&strm, DeflateLevel (t->filter), ZLIB_VERSION,
+            sizeof(z_stream)) != Z_OK)
+        return;
+
+    for (i = 0; i < count && ret == Z_OK; i++) {
+        HPDF_MemStreamAttr attr = (HPDF_MemStreamAttr)t->src->attr;
+        HPDF_UINT len = (i == count - 1) ? attr->w_pos : attr->buf_siz;
+
+        strm.next_in = (Bytef *)HPDF_List_ItemAt (attr->buf, i);
+        strm.avail_in = len;
+
+        /* the output buffer is large enough to finish in one call */
+        ret = deflate (&strm, (i == count - 1) ? Z_FINISH : Z_NO_FLUSH);
+    }
+
+    if (ret == Z_STREAM_END) {
+        t->len = t->len - strm.avail_out;
+        t->done = HPDF_TRUE;
+    }
+
+    deflateEnd (&strm);
+#else /* LIBHPDF_HAVE_NOZLIB */
+    t->done = HPDF_FALSE;
+#endif /* LIBHPDF_HAVE_NOZLIB */
+}
+
+
 HPDF_STATUS
 HPDF_Stream_WriteToStream  (HPDF_Stream  src,
                             HPDF_Stream  dst,
@@ -694,6 +945,7 @@ HPDF_Stream_WriteToStream  (HPDF_Stream  src,
     HPDF_BYTE buf[HPDF_STREAM_BUF_SIZ];
     HPDF_BYTE ebuf[HPDF_STREAM_BUF_SIZ];
     HPDF_BOOL flg;
+    HPDF_UINT idx = 0;
 
     HPDF_PTRACE((" HPDF_Stream_WriteToStream\n"));
     HPDF_UNUSED (filter);
@@ -713,7 +965,7 @@ HPDF_Stream_WriteToStream  (HPDF_Stream  src,
 
 #ifndef LIBHPDF_HAVE_NOZLIB
     if (filter & HPDF_STREAM_FILTER_FLATE_DECODE)
-        return HPDF_Stream_WriteToStreamWithDeflate (src, dst, e);
+        return HPDF_Stream_WriteToStreamWithDeflate (src, dst, filter, e);
 #endif /* LIBHPDF_HAVE_NOZLIB */
 
     ret = HPDF_Stream_Seek (src, 0, HPDF_SEEK_SET);
@@ -722,9 +974,10 @@ HPDF_Stream_WriteToStream  (HPDF_Stream  src,
 
     flg = HPDF_FALSE;
     for (;;) {
-        HPDF_UINT size = HPDF_STREAM_BUF_SIZ;
+        HPDF_BYTE *ptr;
+        HPDF_UINT size;
 
-        ret = HPDF_Stream_Read (src, buf, &size);
+        ret = Stream_NextInput (src, buf, &idx, &ptr, &size);
 
         if (ret != HPDF_OK) {
             if (ret == HPDF_STREAM_EOF) {
@@ -737,10 +990,19 @@ HPDF_Stream_WriteToStream  (HPDF_Stream  src,
         }
 
         if (e) {
-            HPDF_Encrypt_CryptBuf (e, buf, ebuf, size);
-            ret = HPDF_Stream_Write(dst, ebuf, size);
+            HPDF_UINT done;
+
+            ret = HPDF_OK;
+            for (done = 0; done < size && ret == HPDF_OK;
+                    done += HPDF_STREAM_BUF_SIZ) {
+                HPDF_UINT len = (size - done < HPDF_STREAM_BUF_SIZ) ?
+                        size - done : HPDF_STREAM_BUF_SIZ;
+
+                HPDF_Encrypt_CryptBuf (e, ptr + done, ebuf, len);
+                ret = HPDF_Stream_Write(dst, ebuf, len);
+            }
         } else {
-            ret = HPDF_Stream_Write(dst, buf, size);
+            ret = HPDF_Stream_Write(dst, ptr, size);
         }
 
         if (ret != HPDF_OK)
@@ -929,6 +1191,267 @@ HPDF_FileStream_SizeFunc  (HPDF_Stream   stream)
 }
 
 
+static HPDF_BOOL
+MappedReader_Map  (const char           *fname,
+                   HPDF_MappedAttr_Rec  *map)
+{
+    HPDF_MemSet (map, 0, sizeof(HPDF_MappedAttr_Rec));
+
+#if defined(HPDF_MMAP_POSIX)
+    {
+        struct stat st;
+        int fd = open (fname, O_RDONLY);
+
+        if (fd < 0)
+            return HPDF_FALSE;
+
+        if (fstat (fd, &st) == 0 && st.st_size > 0 &&
+                st.st_size < HPDF_LIMIT_MAX_INT) {
+            void *base = mmap (NULL, (size_t)st.st_size, PROT_READ,
+                        MAP_PRIVATE, fd, 0);
+
+            if (base != MAP_FAILED) {
+                map->base = (const HPDF_BYTE *)base;
+                map->size = (HPDF_UINT)st.st_size;
+            }
+        }
+
+        close (fd);
+    }
+#elif defined(HPDF_MMAP_WIN32)
+    {
+        HANDLE file = CreateFileA (fname, GENERIC_READ, FILE_SHARE_READ, NULL,
+                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        DWORD high = 0;
+        DWORD low;
+
+        if (file == INVALID_HANDLE_VALUE)
+            return HPDF_FALSE;
+
+        low = GetFileSize (file, &high);
+        if (low != INVALID_FILE_SIZE && high == 0 && low > 0 &&
+                low < HPDF_LIMIT_MAX_INT) {
+            HANDLE mapping = CreateFileMappingA (file, NULL, PAGE_READONLY,
+                        0, 0, NULL);
+
+            if (mapping) {
+                void *base = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+
+                if (base) {
+                    map->base = (const HPDF_BYTE *)base;
+                    map->size = (HPDF_UINT)low;
+                    map->handle = mapping;
+                } else
+                    CloseHandle (mapping);
+            }
+        }
+
+        /* the mapping keeps the file open */
+        CloseHandle (file);
+    }
+#else
+    HPDF_UNUSED (fname);
+#endif
+
+    return (map->base != NULL);
+}
+
+
+static void
+MappedReader_Unmap  (HPDF_MappedAttr_Rec  *map)
+{
+#if defined(HPDF_MMAP_POSIX)
+    munmap ((void *)map->base, map->size);
+#elif defined(HPDF_MMAP_WIN32)
+    UnmapViewOfFile (map->base);
+    CloseHandle ((HANDLE)map->handle);
+#endif
+
+    map->base = NULL;
+    map->size = 0;
+}
+
+
+/*
+ *  HPDF_MappedReader_New
+ *
+ *  Constructor for an input stream of the file fname mapped into memory,
+ *  which is read without system calls, and whose data can be used in place
+ *  with HPDF_MappedReader_GetPtr. Where the file cannot be mapped, a plain
+ *  file reader is returned instead.
+ *
+ */
+
+HPDF_Stream
+HPDF_MappedReader_New  (HPDF_MMgr   mmgr,
+                        const char  *fname)
+{
+    HPDF_MappedAttr_Rec map;
+    HPDF_MappedAttr attr;
+    HPDF_Stream stream;
+
+    HPDF_PTRACE((" HPDF_MappedReader_New\n"));
+
+    if (!MappedReader_Map (fname, &map))
+        return HPDF_FileReader_New (mmgr, fname);
+
+    stream = (HPDF_Stream)HPDF_GetMem (mmgr, sizeof(HPDF_Stream_Rec));
+    if (!stream) {
+        MappedReader_Unmap (&map);
+        return NULL;
+    }
+
+    attr = (HPDF_MappedAttr)HPDF_GetMem (mmgr, sizeof(HPDF_MappedAttr_Rec));
+    if (!attr) {
+        MappedReader_Unmap (&map);
+        HPDF_FreeMem (mmgr, stream);
+        return NULL;
+    }
+
+    *attr = map;
+
+    HPDF_MemSet (stream, 0, sizeof(HPDF_Stream_Rec));
+    stream->sig_bytes = HPDF_STREAM_SIG_BYTES;
+    stream->type = HPDF_STREAM_MAPPED;
+    stream->error = mmgr->error;
+    stream->mmgr = mmgr;
+    stream->read_fn = HPDF_MappedReader_ReadFunc;
+    stream->seek_fn = HPDF_MappedReader_SeekFunc;
+    stream->tell_fn = HPDF_MappedReader_TellFunc;
+    stream->size_fn = HPDF_MappedReader_SizeFunc;
+    stream->free_fn = HPDF_MappedReader_FreeFunc;
+    stream->attr = attr;
+
+    return stream;
+}
+
+
+/*
+ *  HPDF_MappedReader_GetPtr
+ *
+ *  Returns a pointer to len bytes at offset in the mapping of a stream
+ *  made by HPDF_MappedReader_New, or NULL when the stream is not mapped or
+ *  the range is beyond the end of the file, in which case the data has to
+ *  be read through the stream. The position of the stream is unchanged.
+ *
+ */
+
+const HPDF_BYTE*
+HPDF_MappedReader_GetPtr  (HPDF_Stream  stream,
+                           HPDF_UINT    offset,
+                           HPDF_UINT    len)
+{
+    HPDF_MappedAttr attr;
+
+    if (!stream || stream->type != HPDF_STREAM_MAPPED)
+        return NULL;
+
+    attr = (HPDF_MappedAttr)stream->attr;
+    if (offset > attr->size || len > attr->size - offset)
+        return NULL;
+
+    return attr->base + offset;
+}
+
+
+HPDF_STATUS
+HPDF_MappedReader_ReadFunc  (HPDF_Stream  stream,
+                             HPDF_BYTE    *ptr,
+                             HPDF_UINT    *siz)
+{
+    HPDF_MappedAttr attr = (HPDF_MappedAttr)stream->attr;
+    HPDF_UINT rsiz = (attr->pos < attr->size) ? attr->size - attr->pos : 0;
+
+    HPDF_PTRACE((" HPDF_MappedReader_ReadFunc\n"));
+
+    if (rsiz > *siz)
+        rsiz = *siz;
+
+    if (rsiz > 0) {
+        HPDF_MemCpy (ptr, attr->base + attr->pos, rsiz);
+        attr->pos += rsiz;
+    }
+
+    /* the same as a file reader at the end of the file */
+    if (rsiz != *siz) {
+        HPDF_MemSet (ptr + rsiz, 0, *siz - rsiz);
+        *siz = rsiz;
+
+        return HPDF_STREAM_EOF;
+    }
+
+    return HPDF_OK;
+}
+
+
+HPDF_STATUS
+HPDF_MappedReader_SeekFunc  (HPDF_Stream      stream,
+                             HPDF_INT         pos,
+                             HPDF_WhenceMode  mode)
+{
+    HPDF_MappedAttr attr = (HPDF_MappedAttr)stream->attr;
+    HPDF_INT32 new_pos;
+
+    HPDF_PTRACE((" HPDF_MappedReader_SeekFunc\n"));
+
+    switch (mode) {
+        case HPDF_SEEK_CUR:
+            new_pos = (HPDF_INT32)attr->pos + pos;
+            break;
+        case HPDF_SEEK_END:
+            new_pos = (HPDF_INT32)attr->size + pos;
+            break;
+        default:
+            new_pos = pos;
+    }
+
+    if (new_pos < 0)
+        return HPDF_SetError (stream->error, HPDF_FILE_IO_ERROR, 0);
+
+    attr->pos = (HPDF_UINT)new_pos;
+
+    return HPDF_OK;
+}
+
+
+HPDF_INT32
+HPDF_MappedReader_TellFunc  (HPDF_Stream  stream)
+{
+    HPDF_MappedAttr attr = (HPDF_MappedAttr)stream->attr;
+
+    HPDF_PTRACE((" HPDF_MappedReader_TellFunc\n"));
+
+    return (HPDF_INT32)attr->pos;
+}
+
+
+HPDF_UINT32
+HPDF_MappedReader_SizeFunc  (HPDF_Stream  stream)
+{
+    HPDF_MappedAttr attr = (HPDF_MappedAttr)stream->attr;
+
+    HPDF_PTRACE((" HPDF_MappedReader_SizeFunc\n"));
+
+    return attr->size;
+}
+
+
+void
+HPDF_MappedReader_FreeFunc  (HPDF_Stream  stream)
+{
+    HPDF_MappedAttr attr = (HPDF_MappedAttr)stream->attr;
+
+    HPDF_PTRACE((" HPDF_MappedReader_FreeFunc\n"));
+
+    if (attr) {
+        MappedReader_Unmap (attr);
+        HPDF_FreeMem (stream->mmgr, attr);
+    }
+
+    stream->attr = NULL;
+}
+
+
 HPDF_Stream
 HPDF_FileWriter_New  (HPDF_MMgr        mmgr,
                       const char  *fname)
@@ -1000,6 +1523,187 @@ HPDF_FileStream_FreeFunc  (HPDF_Stream  stream)
     stream->attr = NULL;
 }
 
+
+/*
+ *  HPDF_Writer_New
+ *
+ *  Constructor for an output stream which collects what is written in a
+ *  buffer of buf_siz bytes, and writes it in one piece to the file fname,
+ *  or through write_fn when fname is NULL, whenever the buffer is full.
+ *  Writes larger than the buffer are passed on directly. The stream has to
+ *  be flushed with HPDF_Stream_Flush before it is freed.
+ *
+ */
+
+HPDF_Stream
+HPDF_Writer_New  (HPDF_MMgr        mmgr,
+                  const char       *fname,
+                  HPDF_Write_Func  write_fn,
+                  void             *user_data,
+                  HPDF_UINT        buf_siz)
+{
+    HPDF_Stream stream;
+    HPDF_WriterAttr attr;
+
+    HPDF_PTRACE((" HPDF_Writer_New\n"));
+
+    stream = (HPDF_Stream)HPDF_GetMem (mmgr, sizeof(HPDF_Stream_Rec));
+    if (!stream)
+        return NULL;
+
+    attr = (HPDF_WriterAttr)HPDF_GetMem (mmgr, sizeof(HPDF_WriterAttr_Rec));
+    if (!attr) {
+        HPDF_FreeMem (mmgr, stream);
+        return NULL;
+    }
+
+    HPDF_MemSet (stream, 0, sizeof(HPDF_Stream_Rec));
+    HPDF_MemSet (attr, 0, sizeof(HPDF_WriterAttr_Rec));
+
+    if (buf_siz > 0) {
+        attr->buf = (HPDF_BYTE *)HPDF_GetMem (mmgr, buf_siz);
+        if (!attr->buf) {
+            HPDF_FreeMem (mmgr, attr);
+            HPDF_FreeMem (mmgr, stream);
+            return NULL;
+        }
+        attr->siz = buf_siz;
+    }
+
+    if (fname) {
+        HPDF_FILEP fp = HPDF_FOPEN (fname, "wb");
+
+        if (!fp) {
+#ifdef UNDER_CE
+            HPDF_SetError (mmgr->error, HPDF_FILE_OPEN_ERROR, GetLastError());
+#else
+            HPDF_SetError (mmgr->error, HPDF_FILE_OPEN_ERROR, errno);
+#endif
+            if (attr->buf)
+                HPDF_FreeMem (mmgr, attr->buf);
+            HPDF_FreeMem (mmgr, attr);
+            HPDF_FreeMem (mmgr, stream);
+            return NULL;
+        }
+
+        /* the buffer of the stream takes the place of the one of stdio, so
+         * each flush is a single write to the file */
+        if (attr->buf)
+            HPDF_SETVBUF (fp, NULL, _IONBF, 0);
+
+        attr->fp = fp;
+    } else {
+        attr->write_fn = write_fn;
+        attr->user_data = user_data;
+    }
+
+    stream->sig_bytes = HPDF_STREAM_SIG_BYTES;
+    stream->type = fname ? HPDF_STREAM_FILE : HPDF_STREAM_CALLBACK;
+    stream->error = mmgr->error;
+    stream->mmgr = mmgr;
+    stream->write_fn = HPDF_Writer_WriteFunc;
+    stream->flush_fn = HPDF_Writer_FlushFunc;
+    stream->free_fn = HPDF_Writer_FreeFunc;
+    stream->attr = attr;
+
+    return stream;
+}
+
+
+static HPDF_STATUS
+Writer_Out  (HPDF_Stream      stream,
+             const HPDF_BYTE  *ptr,
+             HPDF_UINT        siz)
+{
+    HPDF_WriterAttr attr = (HPDF_WriterAttr)stream->attr;
+
+    if (attr->fp) {
+        HPDF_FILEP fp = (HPDF_FILEP)attr->fp;
+
+        if (HPDF_FWRITE (ptr, 1, siz, fp) != siz)
+            return HPDF_SetError (stream->error, HPDF_FILE_IO_ERROR,
+                        HPDF_FERROR(fp));
+    } else {
+        HPDF_STATUS ret = attr->write_fn (ptr, siz, attr->user_data);
+
+        if (ret != HPDF_OK)
+            return HPDF_SetError (stream->error, HPDF_FILE_IO_ERROR, ret);
+    }
+
+    return HPDF_OK;
+}
+
+
+HPDF_STATUS
+HPDF_Writer_WriteFunc  (HPDF_Stream      stream,
+                        const HPDF_BYTE  *ptr,
+                        HPDF_UINT        siz)
+{
+    HPDF_WriterAttr attr = (HPDF_WriterAttr)stream->attr;
+    HPDF_STATUS ret;
+
+    HPDF_PTRACE((" HPDF_Writer_WriteFunc\n"));
+
+    if (attr->buf && siz <= attr->siz - attr->len) {
+        HPDF_MemCpy (attr->buf + attr->len, ptr, siz);
+        attr->len += siz;
+        return HPDF_OK;
+    }
+
+    if ((ret = HPDF_Writer_FlushFunc (stream)) != HPDF_OK)
+        return ret;
+
+    if (siz >= attr->siz)
+        return Writer_Out (stream, ptr, siz);
+
+    HPDF_MemCpy (attr->buf, ptr, siz);
+    attr->len = siz;
+
+    return HPDF_OK;
+}
+
+
+HPDF_STATUS
+HPDF_Writer_FlushFunc  (HPDF_Stream  stream)
+{
+    HPDF_WriterAttr attr = (HPDF_WriterAttr)stream->attr;
+    HPDF_UINT len = attr->len;
+
+    HPDF_PTRACE((" HPDF_Writer_FlushFunc\n"));
+
+    if (len == 0)
+        return HPDF_OK;
+
+    attr->len = 0;
+
+    return Writer_Out (stream, attr->buf, len);
+}
+
+
+void
+HPDF_Writer_FreeFunc  (HPDF_Stream  stream)
+{
+    HPDF_WriterAttr attr = (HPDF_WriterAttr)stream->attr;
+
+    HPDF_PTRACE((" HPDF_Writer_FreeFunc\n"));
+
+    if (!attr)
+        return;
+
+    /* errors are reported by HPDF_Stream_Flush before the stream is freed */
+    if (attr->len > 0 && HPDF_Error_GetCode (stream->error) == HPDF_OK)
+        HPDF_Writer_FlushFunc (stream);
+
+    if (attr->fp)
+        HPDF_FCLOSE ((HPDF_FILEP)attr->fp);
+
+    if (attr->buf)
+        HPDF_FreeMem (stream->mmgr, attr->buf);
+
+    HPDF_FreeMem (stream->mmgr, attr);
+    stream->attr = NULL;
+}
+
 HPDF_STATUS
 HPDF_MemStream_InWrite  (HPDF_Stream      stream,
                          const HPDF_BYTE  **ptr,
@@ -1018,6 +1722,28 @@ HPDF_MemStream_InWrite  (HPDF_Stream      stream,
         attr->w_ptr += *count;
         attr->w_pos += *count;
         *count = 0;
+    } else if (attr->growable && attr->buf->count > 0) {
+        /* the buffer grows by half to fit the rest, which the caller then
+         * writes. growing geometrically keeps the copying linear, while
+         * leaving less unused than doubling */
+        HPDF_UINT siz = attr->buf_siz + attr->buf_siz / 2;
+        HPDF_BYTE *buf;
+
+        while (siz - attr->w_pos < *count)
+            siz += siz / 2;
+
+        buf = (HPDF_BYTE*)HPDF_GetMem (stream->mmgr, siz);
+        if (buf == NULL)
+            return HPDF_Error_GetCode (stream->error);
+
+        HPDF_MemCpy (buf, (HPDF_BYTE *)attr->buf->obj[0], attr->w_pos);
+        HPDF_FreeMem (stream->mmgr, attr->buf->obj[0]);
+        attr->buf->obj[0] = buf;
+
+        if (attr->r_ptr)
+            attr->r_ptr = buf + attr->r_pos;
+        attr->w_ptr = buf + attr->w_pos;
+        attr->buf_siz = siz;
     } else {
         if (rsize > 0) {
             HPDF_MemCpy (attr->w_ptr, *ptr, rsize);
@@ -1036,6 +1762,17 @@ HPDF_MemStream_InWrite  (HPDF_Stream      stream,
             return HPDF_Error_GetCode (stream->error);
         }
         attr->w_pos = 0;
+
+        /* the previous buffer is full, past the memory budget it is moved
+         * to the spill file */
+        if (attr->spill && attr->buf->count > 1) {
+            HPDF_SpillFile spill = attr->spill;
+
+            spill->used += attr->buf_siz;
+            if (spill->budget > 0 && spill->used > spill->budget &&
+                    !spill->failed)
+                return MemStream_Spill (stream, attr->buf->count - 2);
+        }
     }
     return HPDF_OK;
 }
@@ -1111,7 +1848,7 @@ HPDF_MemStream_SeekFunc  (HPDF_Stream      stream,
 
     attr->r_ptr_idx = pos / attr->buf_siz;
     attr->r_pos = pos % attr->buf_siz;
-    attr->r_ptr = (HPDF_BYTE*)HPDF_List_ItemAt (attr->buf, attr->r_ptr_idx);
+    attr->r_ptr = MemStream_ReadBuf (stream, attr->r_ptr_idx);
     if (attr->r_ptr == NULL) {
         HPDF_SetError (stream->error, HPDF_INVALID_OBJECT, 0);
         return HPDF_INVALID_OBJECT;
@@ -1139,7 +1876,7 @@ HPDF_MemStream_GetBufPtr  (HPDF_Stream  stream,
 
     attr = (HPDF_MemStreamAttr)stream->attr;
 
-    ret = (HPDF_BYTE *)HPDF_List_ItemAt (attr->buf, index);
+    ret = MemStream_LoadBuf (stream, index);
     if (ret == NULL) {
         HPDF_SetError (stream->error, HPDF_INVALID_PARAMETER, 0);
         *length = 0;
@@ -1164,16 +1901,53 @@ HPDF_MemStream_FreeData  (HPDF_Stream  stream)
 
     attr = (HPDF_MemStreamAttr)stream->attr;
 
-    for (i = 0; i < attr->buf->count; i++)
-        HPDF_FreeMem (stream->mmgr, HPDF_List_ItemAt (attr->buf, i));
+    for (i = 0; i < attr->buf->count; i++) {
+        void *buf = HPDF_List_ItemAt (attr->buf, i);
+
+        if (buf) {
+            /* full buffers count against the memory budget */
+            if (attr->spill && i < attr->buf->count - 1)
+                attr->spill->used -= (attr->spill->used > attr->buf_siz) ?
+                        attr->buf_siz : attr->spill->used;
+
+            HPDF_FreeMem (stream->mmgr, buf);
+        } else
+            SpillFile_Release (stream->mmgr, attr->spill, attr->recs[i] - 1);
+    }
 
     HPDF_List_Clear(attr->buf);
 
+    if (attr->recs) {
+        HPDF_FreeMem (stream->mmgr, attr->recs);
+        attr->recs = NULL;
+        attr->recs_max = 0;
+    }
+
+    if (attr->cache) {
+        HPDF_FreeMem (stream->mmgr, attr->cache);
+        attr->cache = NULL;
+    }
+
+    if (attr->growable)
+        attr->buf_siz = attr->init_siz;
+
     stream->size = 0;
     attr->w_pos = attr->buf_siz;
     attr->w_ptr = NULL;
     attr->r_ptr_idx = 0;
     attr->r_pos = 0;
+    attr->r_ptr = NULL;
+    attr->spilled = 0;
+    attr->cache_idx = 0;
+}
+
+
+HPDF_BOOL
+HPDF_MemStream_InMemory  (HPDF_Stream  stream)
+{
+    HPDF_MemStreamAttr attr = (HPDF_MemStreamAttr)stream->attr;
+
+    return (attr->spilled == 0);
 }
 
 void
@@ -1229,6 +2003,10 @@ HPDF_MemStream_New  (HPDF_MMgr  mmgr,
         attr->buf_siz = (buf_siz > 0) ? buf_siz : HPDF_STREAM_BUF_SIZ;
         attr->w_pos = attr->buf_siz;
 
+        /* the spill file holds records of the default buffer size */
+        if (attr->buf_siz == HPDF_STREAM_BUF_SIZ)
+            attr->spill = mmgr->spill;
+
         stream->write_fn = HPDF_MemStream_WriteFunc;
         stream->read_fn = HPDF_MemStream_ReadFunc;
         stream->seek_fn = HPDF_MemStream_SeekFunc;
@@ -1240,6 +2018,29 @@ HPDF_MemStream_New  (HPDF_MMgr  mmgr,
     return stream;
 }
 
+
+HPDF_Stream
+HPDF_MemStream_NewGrowable  (HPDF_MMgr  mmgr,
+                             HPDF_UINT  init_siz)
+{
+    HPDF_Stream stream;
+
+    HPDF_PTRACE((" HPDF_MemStream_NewGrowable\n"));
+
+    stream = HPDF_MemStream_New (mmgr, init_siz);
+
+    if (stream) {
+        HPDF_MemStreamAttr attr = (HPDF_MemStreamAttr)stream->attr;
+
+        /* the spill file holds records of a single size */
+        attr->spill = NULL;
+        attr->growable = HPDF_TRUE;
+        attr->init_siz = attr->buf_siz;
+    }
+
+    return stream;
+}
+
 HPDF_UINT
 HPDF_MemStream_GetBufSize  (HPDF_Stream  stream)
 {
@@ -1274,7 +2075,6 @@ HPDF_MemStream_ReadFunc  (HPDF_Stream  stream,
                           HPDF_UINT    *size)
 {
     HPDF_MemStreamAttr attr = (HPDF_MemStreamAttr)stream->attr;
-    HPDF_UINT buf_size;
     HPDF_UINT rlen = *size;
 
     HPDF_PTRACE((" HPDF_MemStream_ReadFunc\n"));
@@ -1294,9 +2094,12 @@ HPDF_MemStream_ReadFunc  (HPDF_Stream  stream,
         else
             return HPDF_STREAM_EOF;
 
-        if (!attr->r_ptr)
-            attr->r_ptr = (HPDF_BYTE*)HPDF_List_ItemAt (attr->buf,
-                            attr->r_ptr_idx);
+        if (!attr->r_ptr) {
+            attr->r_ptr = MemStream_ReadBuf (stream, attr->r_ptr_idx);
+            if (!attr->r_ptr)
+                return HPDF_Error_GetCode (stream->error);
+            attr->r_ptr += attr->r_pos;
+        }
 
         if (tmp_len >= rlen) {
             HPDF_MemCpy (buf, attr->r_ptr, rlen);
@@ -1317,8 +2120,7 @@ HPDF_MemStream_ReadFunc  (HPDF_Stream  stream,
 
             attr->r_ptr_idx++;
             attr->r_pos = 0;
-            attr->r_ptr = HPDF_MemStream_GetBufPtr (stream, attr->r_ptr_idx,
-                    &buf_size);
+            attr->r_ptr = NULL;
         }
     }
 
@@ -1337,6 +2139,15 @@ HPDF_MemStream_Rewrite  (HPDF_Stream  stream,
 
     HPDF_PTRACE((" HPDF_MemStream_Rewrite\n"));
 
+    /* the buffer being rewritten has to be back in memory */
+    if (attr->spilled > 0 && attr->buf->count > attr->r_ptr_idx) {
+        attr->r_ptr = HPDF_MemStream_GetBufPtr (stream, attr->r_ptr_idx,
+                &buf_size);
+        if (!attr->r_ptr)
+            return HPDF_Error_GetCode (stream->error);
+        attr->r_ptr += attr->r_pos;
+    }
+
     while (rlen > 0) {
         HPDF_UINT tmp_len;
 
@@ -1372,6 +2183,270 @@ HPDF_MemStream_Rewrite  (HPDF_Stream  stream,
     return HPDF_OK;
 }
 
+
+/*---------------------------------------------------------------------------*/
+/*----- spill file ----------------------------------------------------------*/
+
+HPDF_STATUS
+HPDF_SpillFile_New  (HPDF_MMgr  mmgr,
+                     HPDF_UINT  budget)
+{
+    HPDF_SpillFile spill;
+
+    HPDF_PTRACE((" HPDF_SpillFile_New\n"));
+
+    if (mmgr->spill) {
+        mmgr->spill->budget = budget;
+        return HPDF_OK;
+    }
+
+    spill = (HPDF_SpillFile)HPDF_GetMem (mmgr, sizeof(HPDF_SpillFile_Rec));
+    if (!spill)
+        return HPDF_Error_GetCode (mmgr->error);
+
+    HPDF_MemSet (spill, 0, sizeof(HPDF_SpillFile_Rec));
+    spill->budget = budget;
+    mmgr->spill = spill;
+
+    return HPDF_OK;
+}
+
+
+void
+HPDF_SpillFile_Free  (HPDF_MMgr  mmgr)
+{
+    HPDF_SpillFile spill = mmgr->spill;
+
+    HPDF_PTRACE((" HPDF_SpillFile_Free\n"));
+
+    if (!spill)
+        return;
+
+    /* a temporary file is removed when it is closed */
+    if (spill->fp)
+        HPDF_FCLOSE ((HPDF_FILEP)spill->fp);
+
+    if (spill->free_recs)
+        HPDF_FreeMem (mmgr, spill->free_recs);
+
+    HPDF_FreeMem (mmgr, spill);
+    mmgr->spill = NULL;
+}
+
+
+/* moves to a record in steps that fit in a long, the file can be larger
+ * than a long can address */
+static HPDF_STATUS
+SpillFile_Seek  (HPDF_SpillFile  spill,
+                 HPDF_UINT32     rec)
+{
+    const HPDF_UINT32 step = 0x40000000 / HPDF_STREAM_BUF_SIZ;
+    HPDF_FILEP fp = (HPDF_FILEP)spill->fp;
+
+    if (HPDF_FSEEK (fp, 0, SEEK_SET) != 0)
+        return HPDF_FILE_IO_ERROR;
+
+    while (rec > 0) {
+        HPDF_UINT32 n = (rec > step) ? step : rec;
+
+        if (HPDF_FSEEK (fp, (long)n * HPDF_STREAM_BUF_SIZ, SEEK_CUR) != 0)
+            return HPDF_FILE_IO_ERROR;
+        rec -= n;
+    }
+
+    return HPDF_OK;
+}
+
+
+/* keeps a record of a freed buffer to be reused, if there is no memory
+ * for the list the record is just left unused */
+static void
+SpillFile_Release  (HPDF_MMgr       mmgr,
+                    HPDF_SpillFile  spill,
+                    HPDF_UINT32     rec)
+{
+    if (spill->free_cnt == spill->free_max) {
+        HPDF_UINT max = (spill->free_max > 0) ? spill->free_max * 2 :
+                HPDF_DEF_ITEMS_PER_BLOCK;
+        HPDF_UINT32 *recs = (HPDF_UINT32 *)HPDF_GetMem (mmgr,
+                sizeof(HPDF_UINT32) * max);
+
+        if (!recs) {
+            HPDF_Error_Reset (mmgr->error);
+            return;
+        }
+
+        if (spill->free_recs) {
+            HPDF_MemCpy ((HPDF_BYTE *)recs, (HPDF_BYTE *)spill->free_recs,
+                    sizeof(HPDF_UINT32) * spill->free_cnt);
+            HPDF_FreeMem (mmgr, spill->free_recs);
+        }
+
+        spill->free_recs = recs;
+        spill->free_max = max;
+    }
+
+    spill->free_recs[spill->free_cnt++] = rec;
+}
+
+
+static HPDF_STATUS
+MemStream_ReadRec  (HPDF_Stream  stream,
+                    HPDF_UINT32  rec,
+                    HPDF_BYTE    *buf)
+{
+    HPDF_MemStreamAttr attr = (HPDF_MemStreamAttr)stream->attr;
+    HPDF_SpillFile spill = attr->spill;
+
+    if (SpillFile_Seek (spill, rec) != HPDF_OK ||
+            HPDF_FREAD (buf, 1, attr->buf_siz, (HPDF_FILEP)spill->fp) !=
+            attr->buf_siz)
+        return HPDF_SetError (stream->error, HPDF_FILE_IO_ERROR, 0);
+
+    return HPDF_OK;
+}
+
+
+/* moves a full buffer of the stream to the spill file. if the file cannot
+ * be created or written, the buffers are left in memory from then on */
+static HPDF_STATUS
+MemStream_Spill  (HPDF_Stream  stream,
+                  HPDF_UINT    index)
+{
+    HPDF_MemStreamAttr attr = (HPDF_MemStreamAttr)stream->attr;
+    HPDF_SpillFile spill = attr->spill;
+    HPDF_BYTE *buf = (HPDF_BYTE *)HPDF_List_ItemAt (attr->buf, index);
+    HPDF_UINT32 rec;
+
+    HPDF_PTRACE((" MemStream_Spill\n"));
+
+    if (!spill->fp) {
+        spill->fp = HPDF_TMPFILE ();
+        if (!spill->fp) {
+            spill->failed = HPDF_TRUE;
+            return HPDF_OK;
+        }
+    }
+
+    if (index >= attr->recs_max) {
+        HPDF_UINT max = (attr->recs_max > 0) ? attr->recs_max * 2 :
+                HPDF_DEF_ITEMS_PER_BLOCK;
+        HPDF_UINT32 *recs;
+
+        while (max <= index)
+            max *= 2;
+
+        recs = (HPDF_UINT32 *)HPDF_GetMem (stream->mmgr,
+                sizeof(HPDF_UINT32) * max);
+        if (!recs)
+            return HPDF_Error_GetCode (stream->error);
+
+        HPDF_MemSet (recs, 0, sizeof(HPDF_UINT32) * max);
+        if (attr->recs) {
+            HPDF_MemCpy ((HPDF_BYTE *)recs, (HPDF_BYTE *)attr->recs,
+                    sizeof(HPDF_UINT32) * attr->recs_max);
+            HPDF_FreeMem (stream->mmgr, attr->recs);
+        }
+
+        attr->recs = recs;
+        attr->recs_max = max;
+    }
+
+    rec = (spill->free_cnt > 0) ? spill->free_recs[--spill->free_cnt] :
+            spill->count;
+
+    if (SpillFile_Seek (spill, rec) != HPDF_OK ||
+            HPDF_FWRITE (buf, 1, attr->buf_siz, (HPDF_FILEP)spill->fp) !=
+            attr->buf_siz) {
+        if (rec != spill->count)
+            spill->free_cnt++;
+        spill->failed = HPDF_TRUE;
+        return HPDF_OK;
+    }
+
+    if (rec == spill->count)
+        spill->count++;
+
+    attr->recs[index] = rec + 1;
+    attr->buf->obj[index] = NULL;
+    attr->spilled++;
+    spill->used -= attr->buf_siz;
+
+    /* a reader positioned in the buffer reads it back when it goes on */
+    if (attr->r_ptr_idx == index)
+        attr->r_ptr = NULL;
+
+    HPDF_FreeMem (stream->mmgr, buf);
+
+    return HPDF_OK;
+}
+
+
+/* the memory of a buffer for reading, a buffer in the spill file is read
+ * into the cache of the stream */
+static HPDF_BYTE*
+MemStream_ReadBuf  (HPDF_Stream  stream,
+                    HPDF_UINT    index)
+{
+    HPDF_MemStreamAttr attr = (HPDF_MemStreamAttr)stream->attr;
+    HPDF_BYTE *buf = (HPDF_BYTE *)HPDF_List_ItemAt (attr->buf, index);
+
+    if (buf || index >= attr->buf->count)
+        return buf;
+
+    if (attr->cache_idx == index + 1)
+        return attr->cache;
+
+    if (!attr->cache) {
+        attr->cache = (HPDF_BYTE *)HPDF_GetMem (stream->mmgr, attr->buf_siz);
+        if (!attr->cache)
+            return NULL;
+    }
+
+    attr->cache_idx = 0;
+    if (MemStream_ReadRec (stream, attr->recs[index] - 1, attr->cache) !=
+            HPDF_OK)
+        return NULL;
+
+    attr->cache_idx = index + 1;
+
+    return attr->cache;
+}
+
+
+/* the memory of a buffer for writing, a buffer in the spill file is moved
+ * back into memory */
+static HPDF_BYTE*
+MemStream_LoadBuf  (HPDF_Stream  stream,
+                    HPDF_UINT    index)
+{
+    HPDF_MemStreamAttr attr = (HPDF_MemStreamAttr)stream->attr;
+    HPDF_BYTE *buf = (HPDF_BYTE *)HPDF_List_ItemAt (attr->buf, index);
+
+    if (buf || index >= attr->buf->count)
+        return buf;
+
+    buf = (HPDF_BYTE *)HPDF_GetMem (stream->mmgr, attr->buf_siz);
+    if (!buf)
+        return NULL;
+
+    if (MemStream_ReadRec (stream, attr->recs[index] - 1, buf) != HPDF_OK) {
+        HPDF_FreeMem (stream->mmgr, buf);
+        return NULL;
+    }
+
+    SpillFile_Release (stream->mmgr, attr->spill, attr->recs[index] - 1);
+    attr->recs[index] = 0;
+    attr->buf->obj[index] = buf;
+    attr->spilled--;
+    attr->spill->used += attr->buf_siz;
+
+    if (attr->cache_idx == index + 1)
+        attr->cache_idx = 0;
+
+    return buf;
+}
+
 /*
  *  HPDF_CallbackReader_new
  *
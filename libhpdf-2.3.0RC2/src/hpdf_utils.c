@@ -16,6 +16,7 @@
  */
 
 #include <stdlib.h>
+#include "hpdf_conf.h"
 #include "hpdf_utils.h"
 #include "hpdf_consts.h"
 
@@ -177,17 +178,34 @@ HPDF_IToA2  (char         *s,
 }
 
 
+/* the two digit numbers 00 to 99, so that a real number is written two
+ * digits at a time */
+static const char HPDF_DIGIT_PAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233"
+    "34353637383940414243444546474849505152535455565758596061626364656667"
+    "6869707172737475767778798081828384858687888990919293949596979899";
+
+/* the powers of 10 up to the largest HPDF_REAL_PRECISION */
+static const HPDF_UINT32 HPDF_REAL_SCALE[] = {
+    1, 10, 100, 1000, 10000, 100000
+};
+
 char*
 HPDF_FToA  (char       *s,
             HPDF_REAL   val,
             char       *eptr)
 {
-    HPDF_INT32 int_val;
-    HPDF_INT32 fpart_val;
-    char buf[HPDF_REAL_LEN + 1];
-    char* sptr = s;
+    HPDF_UINT32 scaled;
+    HPDF_UINT32 int_val;
+    HPDF_UINT32 fpart_val;
+    char buf[HPDF_REAL_LEN + 18];
     char* t;
-    HPDF_UINT32 i;
+    char* end;
+    HPDF_UINT zeros;
+    HPDF_UINT digits;
+    HPDF_UINT i;
+    HPDF_UINT len;
+    HPDF_BOOL neg;
 
     if (val > HPDF_LIMIT_MAX_REAL)
         val = HPDF_LIMIT_MAX_REAL;
@@ -195,55 +213,82 @@ HPDF_FToA  (char       *s,
     if (val < HPDF_LIMIT_MIN_REAL)
         val = HPDF_LIMIT_MIN_REAL;
 
-    t = buf + HPDF_REAL_LEN;
-    *t-- = 0;
+    neg = (val < 0);
+    val = neg ? -val : val;
+
+    /* round to HPDF_REAL_PRECISION digits once, the integer and decimal
+     * parts are then taken from the same value */
+    scaled = (HPDF_UINT32)((double)val * HPDF_REAL_SCALE[HPDF_REAL_PRECISION]
+            + 0.5);
+    int_val = scaled / HPDF_REAL_SCALE[HPDF_REAL_PRECISION];
+    fpart_val = scaled % HPDF_REAL_SCALE[HPDF_REAL_PRECISION];
+
+    /* the digits are always written in full and the unwanted ones are cut
+     * off afterwards, so that the only branches taken are the same for
+     * every value */
+    end = buf + HPDF_REAL_LEN + 1;
+    t = end;
+
+    /* process decimal part, then cut off its trailing zeros, and the
+     * point too if no digits are left */
+    if (HPDF_REAL_PRECISION > 0) {
+        zeros = (fpart_val % 10 == 0) +
+                (HPDF_REAL_PRECISION >= 2 && fpart_val % 100 == 0) +
+                (HPDF_REAL_PRECISION >= 3 && fpart_val % 1000 == 0) +
+                (HPDF_REAL_PRECISION >= 4 && fpart_val % 10000 == 0) +
+                (HPDF_REAL_PRECISION >= 5 && fpart_val % 100000 == 0);
+
+        for (i = HPDF_REAL_PRECISION; i >= 2; i -= 2) {
+            t -= 2;
+            t[0] = HPDF_DIGIT_PAIRS[(fpart_val % 100) * 2];
+            t[1] = HPDF_DIGIT_PAIRS[(fpart_val % 100) * 2 + 1];
+            fpart_val /= 100;
+        }
+        if (i > 0)
+            *--t = (char)('0' + fpart_val);
+        *--t = '.';
 
-    if (val < 0) {
-        *s++ = '-';
-        val = -val;
+        end -= zeros + (zeros == HPDF_REAL_PRECISION);
     }
 
-    /* separate an integer part and a decimal part. */
-    int_val = (HPDF_INT32)(val + 0.000005);
-    fpart_val = (HPDF_INT32)((HPDF_REAL)(val - int_val + 0.000005) * 100000);
-
-    /* process decimal part */
-    for (i = 0; i < 5; i++) {
-        *t = (char)((char)(fpart_val % 10) + '0');
-        fpart_val /= 10;
-        t--;
+    /* process integer part, always as the five digits of the clamped
+     * range, then skip its leading zeros */
+    digits = 1 + (int_val >= 10) + (int_val >= 100) + (int_val >= 1000) +
+            (int_val >= 10000);
+    for (i = 0; i < 2; i++) {
+        t -= 2;
+        t[0] = HPDF_DIGIT_PAIRS[(int_val % 100) * 2];
+        t[1] = HPDF_DIGIT_PAIRS[(int_val % 100) * 2 + 1];
+        int_val /= 100;
     }
+    *--t = (char)('0' + int_val);
+    t += 5 - digits;
 
-    /* process integer part */
-    *t-- = '.';
-    *t = '0';
-    if (int_val == 0)
-        t--;
+    /* no sign for a value which rounds to zero */
+    t[-1] = '-';
+    t -= (neg && scaled > 0);
 
-    while (int_val > 0) {
-        *t = (char)((char)(int_val % 10) + '0');
-        int_val /= 10;
-        t--;
-    }
+    len = (HPDF_UINT)(end - t);
 
-    t++;
-    while (s <= eptr && *t != 0)
-        *s++ = *t++;
-    s--;
-
-    /* delete an excessive decimal portion. */
-    while (s > sptr) {
-        if (*s == '0')
-            *s = 0;
-        else {
-            if (*s == '.')
-                *s = 0;
-            break;
-        }
-        s--;
+    /* when there is room, as in the page operators, copy a fixed 16 bytes
+     * rather than the exact length, the number is still 0 terminated */
+    if (s + 16 <= eptr) {
+        for (i = 0; i < 16; i++)
+            s[i] = t[i];
+        s += len;
+        *s = 0;
+
+        return s;
     }
 
-    return (*s == 0) ? s : ++s;
+    if (s + len > eptr + 1)
+        len = (HPDF_UINT)(eptr + 1 - s);
+    HPDF_MemCpy ((HPDF_BYTE *)s, (HPDF_BYTE *)t, len);
+    s += len;
+    if (s <= eptr)
+        *s = 0;
+
+    return s;
 }
 
 
@@ -19,11 +19,34 @@
 #include "hpdf_utils.h"
 #include "hpdf_objects.h"
 
+/* limits on the streams deflated together by the parallel handler, which
+ * bound the memory held by deflated streams waiting to be written */
+#define HPDF_DEFLATE_WINDOW_TASKS     64
+#define HPDF_DEFLATE_WINDOW_SIZE      (4 * 1024 * 1024)
+
+/* maximum number of objects packed into one object stream */
+#define HPDF_OBJ_STREAM_MAX_OBJECTS   100
+
 static HPDF_STATUS
 WriteTrailer  (HPDF_Xref     xref,
                HPDF_Stream   stream);
 
 
+static HPDF_STATUS
+WriteObject  (HPDF_XrefEntry  entry,
+              HPDF_UINT       obj_id,
+              HPDF_Stream     stream,
+              HPDF_Encrypt    e);
+
+
+static HPDF_STATUS
+DeflateObjects  (HPDF_Xref           xref,
+                 HPDF_Parallel_Func  parallel_fn,
+                 void                *parallel_data,
+                 HPDF_UINT           start,
+                 HPDF_UINT           *end);
+
+
 HPDF_Xref
 HPDF_Xref_New  (HPDF_MMgr     mmgr,
                 HPDF_UINT32   offset)
@@ -66,6 +89,7 @@ HPDF_Xref_New  (HPDF_MMgr     mmgr,
         new_entry->byte_offset = 0;
         new_entry->gen_no = HPDF_MAX_GENERATION_NUM;
         new_entry->obj = NULL;
+        new_entry->written = HPDF_FALSE;
     }
 
     xref->trailer = HPDF_Dict_New (mmgr);
@@ -162,6 +186,7 @@ HPDF_Xref_Add  (HPDF_Xref  xref,
     entry->byte_offset = 0;
     entry->gen_no = 0;
     entry->obj = obj;
+    entry->written = HPDF_FALSE;
     header->obj_id = xref->start_offset + xref->entries->count - 1 +
                     HPDF_OTYPE_INDIRECT;
 
@@ -228,6 +253,7 @@ HPDF_Xref_WriteToStream  (HPDF_Xref    xref,
     char* pbuf;
     char* eptr = buf + HPDF_SHORT_BUF_SIZ - 1;
     HPDF_UINT str_idx;
+    HPDF_UINT deflate_end;
     HPDF_Xref tmp_xref = xref;
 
     /* write each objects of xref to the specified stream */
@@ -240,31 +266,27 @@ HPDF_Xref_WriteToStream  (HPDF_Xref    xref,
         else
             str_idx = 0;
 
+        deflate_end = str_idx;
+
         for (i = str_idx; i < tmp_xref->entries->count; i++) {
-            HPDF_XrefEntry  entry =
-                        (HPDF_XrefEntry)HPDF_List_ItemAt (tmp_xref->entries, i);
+            HPDF_XrefEntry  entry;
             HPDF_UINT obj_id = tmp_xref->start_offset + i;
-            HPDF_UINT16 gen_no = entry->gen_no;
-
-            entry->byte_offset = stream->size;
-
-            pbuf = buf;
-            pbuf = HPDF_IToA (pbuf, obj_id, eptr);
-            *pbuf++ = ' ';
-            pbuf = HPDF_IToA (pbuf, gen_no, eptr);
-            HPDF_StrCpy(pbuf, " obj\012", eptr);
 
-            if ((ret = HPDF_Stream_WriteStr (stream, buf)) != HPDF_OK)
-               return ret;
+            /* deflate the streams of the next objects concurrently, they
+             * are then written in order as usual */
+            if (i >= deflate_end && xref->parallel_fn && !e) {
+                if ((ret = DeflateObjects (tmp_xref, xref->parallel_fn,
+                        xref->parallel_data, i, &deflate_end)) != HPDF_OK)
+                    return ret;
+            }
 
-            if (e)
-                HPDF_Encrypt_InitKey (e, obj_id, gen_no);
+            entry = (HPDF_XrefEntry)HPDF_List_ItemAt (tmp_xref->entries, i);
 
-            if ((ret = HPDF_Obj_WriteValue (entry->obj, stream, e)) != HPDF_OK)
-                return ret;
+            /* objects written ahead keep the offset they were written at */
+            if (entry->written)
+                continue;
 
-            if ((ret = HPDF_Stream_WriteStr (stream, "\012endobj\012"))
-                    != HPDF_OK)
+            if ((ret = WriteObject (entry, obj_id, stream, e)) != HPDF_OK)
                 return ret;
        }
 
@@ -313,6 +335,1420 @@ HPDF_Xref_WriteToStream  (HPDF_Xref    xref,
     return ret;
 }
 
+
+/* calls before_write_fn for every object, before any object is written.
+ * before_write_fn may add new objects, and may fill in the streams of other
+ * objects, so this is needed when objects are not written in order */
+static HPDF_STATUS
+PrepareObjects  (HPDF_Xref  xref)
+{
+    HPDF_STATUS ret;
+    HPDF_UINT i;
+
+    for (i = 1; i < xref->entries->count; i++) {
+        HPDF_XrefEntry entry = HPDF_Xref_GetEntry (xref, i);
+        HPDF_Obj_Header *header = (HPDF_Obj_Header *)entry->obj;
+        HPDF_Dict dict = (HPDF_Dict)entry->obj;
+
+        if (entry->entry_typ != HPDF_IN_USE_ENTRY ||
+                (header->obj_class & HPDF_OCLASS_ANY) != HPDF_OCLASS_DICT)
+            continue;
+
+        if (dict->before_write_fn && !dict->prepared) {
+            if ((ret = dict->before_write_fn (dict)) != HPDF_OK)
+                return ret;
+            dict->prepared = HPDF_TRUE;
+        }
+    }
+
+    return HPDF_OK;
+}
+
+
+/* objects which can be stored in an object stream (PDF 1.5), any object
+ * except streams and objects with a non-zero generation number */
+static HPDF_BOOL
+IsPackable  (HPDF_XrefEntry  entry)
+{
+    HPDF_Obj_Header *header = (HPDF_Obj_Header *)entry->obj;
+
+    if (entry->entry_typ != HPDF_IN_USE_ENTRY || entry->gen_no != 0)
+        return HPDF_FALSE;
+
+    if ((header->obj_class & HPDF_OCLASS_ANY) == HPDF_OCLASS_DICT &&
+            ((HPDF_Dict)entry->obj)->stream)
+        return HPDF_FALSE;
+
+    return HPDF_TRUE;
+}
+
+
+/* writes an indirect stream object whose dictionary has no stream of its
+ * own, such as an object stream or the cross-reference stream */
+static HPDF_STATUS
+WriteStreamObject  (HPDF_Xref    xref,
+                    HPDF_Stream  stream,
+                    HPDF_UINT    obj_id,
+                    HPDF_Dict    dict,
+                    HPDF_Stream  data,
+                    HPDF_UINT    filter)
+{
+    HPDF_STATUS ret = HPDF_OK;
+    HPDF_Stream tmp = NULL;
+    char buf[HPDF_SHORT_BUF_SIZ];
+    char* pbuf;
+    char* eptr = buf + HPDF_SHORT_BUF_SIZ - 1;
+
+    /* the length has to be written ahead of the data, so deflate the data
+     * to a temporary stream first */
+    if (filter & HPDF_STREAM_FILTER_FLATE_DECODE) {
+        tmp = HPDF_MemStream_New (xref->mmgr, HPDF_STREAM_BUF_SIZ);
+        if (!tmp)
+            return HPDF_Error_GetCode (xref->error);
+
+        ret = HPDF_Stream_WriteToStream (data, tmp, filter, NULL);
+        if (ret == HPDF_OK)
+            ret = HPDF_Dict_AddName (dict, "Filter", "FlateDecode");
+        data = tmp;
+    }
+
+    if (ret == HPDF_OK)
+        ret = HPDF_Dict_AddNumber (dict, "Length", HPDF_Stream_Size (data));
+
+    if (ret == HPDF_OK) {
+        pbuf = HPDF_IToA (buf, obj_id, eptr);
+        HPDF_StrCpy (pbuf, " 0 obj\012", eptr);
+        ret = HPDF_Stream_WriteStr (stream, buf);
+    }
+
+    if (ret == HPDF_OK)
+        ret = HPDF_Dict_Write (dict, stream, NULL);
+
+    if (ret == HPDF_OK)
+        ret = HPDF_Stream_WriteStr (stream, "\012stream\015\012");
+
+    if (ret == HPDF_OK)
+        ret = HPDF_Stream_WriteToStream (data, stream,
+                    HPDF_STREAM_FILTER_NONE, NULL);
+
+    if (ret == HPDF_OK)
+        ret = HPDF_Stream_WriteStr (stream, "\012endstream\012endobj\012");
+
+    if (tmp)
+        HPDF_Stream_Free (tmp);
+
+    return ret;
+}
+
+
+/* writes an object stream holding the objects written to body, whose
+ * numbers and offsets have been written to index */
+static HPDF_STATUS
+WriteObjectStream  (HPDF_Xref    xref,
+                    HPDF_Stream  stream,
+                    HPDF_UINT    obj_id,
+                    HPDF_UINT    count,
+                    HPDF_Stream  index,
+                    HPDF_Stream  body,
+                    HPDF_UINT    filter)
+{
+    HPDF_STATUS ret;
+    HPDF_Dict dict;
+    HPDF_UINT first = HPDF_Stream_Size (index);
+
+    if ((ret = HPDF_Stream_WriteToStream (body, index,
+                HPDF_STREAM_FILTER_NONE, NULL)) != HPDF_OK)
+        return ret;
+
+    dict = HPDF_Dict_New (xref->mmgr);
+    if (!dict)
+        return HPDF_Error_GetCode (xref->error);
+
+    ret = HPDF_Dict_AddName (dict, "Type", "ObjStm");
+    ret += HPDF_Dict_AddNumber (dict, "N", count);
+    ret += HPDF_Dict_AddNumber (dict, "First", first);
+
+    if (ret == HPDF_OK)
+        ret = WriteStreamObject (xref, stream, obj_id, dict, index, filter);
+    else
+        ret = HPDF_Error_GetCode (xref->error);
+
+    HPDF_Dict_Free (dict);
+
+    return ret;
+}
+
+
+static HPDF_STATUS
+WriteXrefStreamEntry  (HPDF_Stream  data,
+                       HPDF_BYTE    typ,
+                       HPDF_UINT32  field2,
+                       HPDF_UINT16  field3)
+{
+    HPDF_BYTE buf[7];
+
+    buf[0] = typ;
+    buf[1] = (HPDF_BYTE)(field2 >> 24);
+    buf[2] = (HPDF_BYTE)(field2 >> 16);
+    buf[3] = (HPDF_BYTE)(field2 >> 8);
+    buf[4] = (HPDF_BYTE)field2;
+    buf[5] = (HPDF_BYTE)(field3 >> 8);
+    buf[6] = (HPDF_BYTE)field3;
+
+    return HPDF_Stream_Write (data, buf, 7);
+}
+
+
+/* writes the cross-reference stream, which replaces both the
+ * cross-reference table and the trailer */
+static HPDF_STATUS
+WriteXrefStream  (HPDF_Xref     xref,
+                  HPDF_Stream   stream,
+                  HPDF_UINT32   *loc,
+                  HPDF_UINT32   *stm_addr,
+                  HPDF_UINT     stm_count,
+                  HPDF_UINT     filter)
+{
+    HPDF_STATUS ret = HPDF_OK;
+    HPDF_UINT count = xref->entries->count;
+    HPDF_UINT obj_id = count + stm_count;
+    HPDF_Stream data;
+    HPDF_Array w;
+    HPDF_UINT i;
+
+    data = HPDF_MemStream_New (xref->mmgr, HPDF_STREAM_BUF_SIZ);
+    if (!data)
+        return HPDF_Error_GetCode (xref->error);
+
+    for (i = 0; i < count && ret == HPDF_OK; i++) {
+        HPDF_XrefEntry entry = HPDF_Xref_GetEntry (xref, i);
+
+        if (entry->entry_typ == HPDF_FREE_ENTRY)
+            ret = WriteXrefStreamEntry (data, 0, entry->byte_offset,
+                        entry->gen_no);
+        else if (loc[i * 2])
+            ret = WriteXrefStreamEntry (data, 2, loc[i * 2],
+                        (HPDF_UINT16)loc[i * 2 + 1]);
+        else
+            ret = WriteXrefStreamEntry (data, 1, entry->byte_offset,
+                        entry->gen_no);
+    }
+
+    for (i = 0; i < stm_count && ret == HPDF_OK; i++)
+        ret = WriteXrefStreamEntry (data, 1, stm_addr[i], 0);
+
+    /* the cross-reference stream itself */
+    xref->addr = stream->size;
+    if (ret == HPDF_OK)
+        ret = WriteXrefStreamEntry (data, 1, xref->addr, 0);
+
+    /* the trailer entries are written to the stream dictionary */
+    if (ret == HPDF_OK) {
+        w = HPDF_Array_New (xref->mmgr);
+        if (!w)
+            ret = HPDF_Error_GetCode (xref->error);
+        else if (HPDF_Dict_Add (xref->trailer, "W", w) != HPDF_OK)
+            ret = HPDF_Error_GetCode (xref->error);
+        else {
+            ret += HPDF_Array_AddNumber (w, 1);
+            ret += HPDF_Array_AddNumber (w, 4);
+            ret += HPDF_Array_AddNumber (w, 2);
+            ret += HPDF_Dict_AddName (xref->trailer, "Type", "XRef");
+            ret += HPDF_Dict_AddNumber (xref->trailer, "Size", obj_id + 1);
+            if (ret != HPDF_OK)
+                ret = HPDF_Error_GetCode (xref->error);
+        }
+    }
+
+    if (ret == HPDF_OK)
+        ret = WriteStreamObject (xref, stream, obj_id, xref->trailer, data,
+                    filter);
+
+    HPDF_Stream_Free (data);
+
+    /* leave the trailer as it was, for a later save without object
+     * streams */
+    HPDF_Dict_RemoveElement (xref->trailer, "W");
+    HPDF_Dict_RemoveElement (xref->trailer, "Type");
+    HPDF_Dict_RemoveElement (xref->trailer, "Filter");
+    HPDF_Dict_RemoveElement (xref->trailer, "Length");
+
+    if (ret != HPDF_OK)
+        return ret;
+
+    if ((ret = HPDF_Stream_WriteStr (stream, "startxref\012")) != HPDF_OK)
+        return ret;
+
+    if ((ret = HPDF_Stream_WriteUInt (stream, xref->addr)) != HPDF_OK)
+        return ret;
+
+    return HPDF_Stream_WriteStr (stream, "\012%%EOF\012");
+}
+
+
+/* writes the objects like HPDF_Xref_WriteToStream, but packs the objects
+ * other than streams into compressed object streams, and writes a
+ * cross-reference stream in place of the cross-reference table (PDF 1.5).
+ * filter is used for the object streams and the cross-reference stream */
+HPDF_STATUS
+HPDF_Xref_WriteToStreamCompressed  (HPDF_Xref     xref,
+                                    HPDF_Stream   stream,
+                                    HPDF_UINT     filter)
+{
+    HPDF_STATUS ret = HPDF_OK;
+    HPDF_UINT32 *loc;
+    HPDF_UINT32 *stm_addr;
+    HPDF_UINT stm_count = 0;
+    HPDF_Stream index = NULL;
+    HPDF_Stream body = NULL;
+    HPDF_UINT packed = 0;
+    HPDF_UINT deflate_end = 1;
+    HPDF_UINT count;
+    HPDF_UINT i;
+
+    HPDF_PTRACE((" HPDF_Xref_WriteToStreamCompressed\n"));
+
+    /* only a single cross-reference section is supported */
+    if (xref->prev || xref->start_offset != 0)
+        return HPDF_Xref_WriteToStream (xref, stream, NULL);
+
+    if ((ret = PrepareObjects (xref)) != HPDF_OK)
+        return ret;
+
+    count = xref->entries->count;
+
+    loc = (HPDF_UINT32 *)HPDF_GetMem (xref->mmgr,
+                sizeof(HPDF_UINT32) * count * 2);
+    stm_addr = (HPDF_UINT32 *)HPDF_GetMem (xref->mmgr,
+                sizeof(HPDF_UINT32) * (count / HPDF_OBJ_STREAM_MAX_OBJECTS + 1));
+    index = HPDF_MemStream_New (xref->mmgr, HPDF_STREAM_BUF_SIZ);
+    body = HPDF_MemStream_New (xref->mmgr, HPDF_STREAM_BUF_SIZ);
+
+    if (!loc || !stm_addr || !index || !body) {
+        ret = HPDF_Error_GetCode (xref->error);
+        goto Exit;
+    }
+
+    HPDF_MemSet (loc, 0, sizeof(HPDF_UINT32) * count * 2);
+
+    /* the streams are written first, so that the Length objects packed
+     * into the object streams hold their final values */
+    for (i = 1; i < count; i++) {
+        HPDF_XrefEntry entry = HPDF_Xref_GetEntry (xref, i);
+
+        if (entry->entry_typ != HPDF_IN_USE_ENTRY || IsPackable (entry))
+            continue;
+
+        if (i >= deflate_end && xref->parallel_fn) {
+            if ((ret = DeflateObjects (xref, xref->parallel_fn,
+                    xref->parallel_data, i, &deflate_end)) != HPDF_OK)
+                goto Exit;
+        }
+
+        if ((ret = WriteObject (entry, i, stream, NULL)) != HPDF_OK)
+            goto Exit;
+    }
+
+    /* then the other objects, into object streams numbered from count */
+    for (i = 1; i < count; i++) {
+        HPDF_XrefEntry entry = HPDF_Xref_GetEntry (xref, i);
+
+        if (!IsPackable (entry))
+            continue;
+
+        loc[i * 2] = count + stm_count;
+        loc[i * 2 + 1] = packed;
+
+        ret = HPDF_Stream_WriteUInt (index, i);
+        ret += HPDF_Stream_WriteChar (index, ' ');
+        ret += HPDF_Stream_WriteUInt (index, HPDF_Stream_Size (body));
+        ret += HPDF_Stream_WriteChar (index, ' ');
+        if (ret != HPDF_OK) {
+            ret = HPDF_Error_GetCode (xref->error);
+            goto Exit;
+        }
+
+        if ((ret = HPDF_Obj_WriteValue (entry->obj, body, NULL)) != HPDF_OK ||
+                (ret = HPDF_Stream_WriteStr (body, "\012")) != HPDF_OK)
+            goto Exit;
+
+        if (++packed == HPDF_OBJ_STREAM_MAX_OBJECTS) {
+            stm_addr[stm_count] = stream->size;
+            if ((ret = WriteObjectStream (xref, stream, count + stm_count,
+                    packed, index, body, filter)) != HPDF_OK)
+                goto Exit;
+
+            stm_count++;
+            packed = 0;
+            HPDF_MemStream_FreeData (index);
+            HPDF_MemStream_FreeData (body);
+        }
+    }
+
+    if (packed > 0) {
+        stm_addr[stm_count] = stream->size;
+        if ((ret = WriteObjectStream (xref, stream, count + stm_count,
+                packed, index, body, filter)) != HPDF_OK)
+            goto Exit;
+
+        stm_count++;
+    }
+
+    ret = WriteXrefStream (xref, stream, loc, stm_addr, stm_count, filter);
+
+Exit:
+    if (loc)
+        HPDF_FreeMem (xref->mmgr, loc);
+    if (stm_addr)
+        HPDF_FreeMem (xref->mmgr, stm_addr);
+    if (index)
+        HPDF_Stream_Free (index);
+    if (body)
+        HPDF_Stream_Free (body);
+
+    return ret;
+}
+
+
+/*----------------------------------------------------------------------------*/
+/*----- linearized output ----------------------------------------------------*/
+
+/* owner of an object which is not used by a single page */
+#define HPDF_LIN_UNUSED       -1
+#define HPDF_LIN_SHARED       -2
+
+/* what VisitObject does with the objects used by a page */
+#define HPDF_LIN_FIND_OWNERS  0
+#define HPDF_LIN_COUNT_REFS   1
+#define HPDF_LIN_STORE_REFS   2
+
+typedef struct _HPDF_Linearize_Rec  *HPDF_Linearize;
+
+typedef struct _HPDF_Linearize_Rec {
+    HPDF_Xref     xref;
+    HPDF_UINT     count;        /* number of entries in the xref */
+    HPDF_UINT     mode;         /* HPDF_LIN_FIND_OWNERS, ... */
+
+    /* the page being visited */
+    HPDF_Dict     page;
+    HPDF_INT      page_no;
+    HPDF_UINT     visit_no;
+
+    /* for each object, by its index in the xref */
+    HPDF_UINT     *visit;       /* the last visit which reached the object */
+    HPDF_INT      *owner;       /* page using the object, or HPDF_LIN_... */
+    HPDF_BOOL     *first;       /* used by the first page */
+    HPDF_INT      *ident;       /* identifier in the shared object hint
+                                   table, -1 if none */
+
+    /* the pages, in order */
+    HPDF_UINT     npages;
+    HPDF_UINT     *page_idx;
+
+    /* the objects in the order that they are written, starting with the
+     * catalog, then the first page, the other pages, the objects shared by
+     * the other pages, and the rest. start holds the position of the first
+     * object of each page, then of the shared objects and the rest */
+    HPDF_UINT     npos;
+    HPDF_UINT     *order;
+    HPDF_UINT     *start;
+    HPDF_UINT32   *offset;      /* from the catalog, without the hint
+                                   stream, npos + 1 entries */
+
+    /* the shared objects used by each page after the first */
+    HPDF_UINT     *nrefs;
+    HPDF_UINT     *refs;
+    HPDF_UINT     total_refs;
+} HPDF_Linearize_Rec;
+
+
+typedef struct _HPDF_BitWriter_Rec {
+    HPDF_Stream   stream;
+    HPDF_BYTE     byte;
+    HPDF_UINT     nbits;
+    HPDF_STATUS   ret;
+} HPDF_BitWriter_Rec;
+
+
+static void
+WriteBits  (HPDF_BitWriter_Rec  *w,
+            HPDF_UINT32         value,
+            HPDF_UINT           nbits)
+{
+    while (nbits-- > 0) {
+        w->byte = (HPDF_BYTE)((w->byte << 1) | ((value >> nbits) & 1));
+
+        if (++w->nbits == 8) {
+            if (w->ret == HPDF_OK)
+                w->ret = HPDF_Stream_Write (w->stream, &w->byte, 1);
+            w->byte = 0;
+            w->nbits = 0;
+        }
+    }
+}
+
+
+/* the items of the hint tables each start on a byte boundary */
+static void
+FlushBits  (HPDF_BitWriter_Rec  *w)
+{
+    if (w->nbits > 0)
+        WriteBits (w, 0, 8 - w->nbits);
+}
+
+
+static HPDF_UINT
+BitsNeeded  (HPDF_UINT32  value)
+{
+    HPDF_UINT nbits = 0;
+
+    while (value > 0) {
+        nbits++;
+        value >>= 1;
+    }
+
+    return nbits;
+}
+
+
+static HPDF_UINT
+DigitCount  (HPDF_UINT32  value)
+{
+    HPDF_UINT ndigits = 1;
+
+    while (value >= 10) {
+        ndigits++;
+        value /= 10;
+    }
+
+    return ndigits;
+}
+
+
+/* visits the objects used by the current page, not following the parent
+ * of the page, nor any other page or node of the page tree */
+static void
+VisitObject  (HPDF_Linearize  lin,
+              void            *obj)
+{
+    HPDF_Obj_Header *header = (HPDF_Obj_Header *)obj;
+    HPDF_UINT i;
+
+    if (!obj || header->obj_id & HPDF_OTYPE_HIDDEN)
+        return;
+
+    if (header->obj_class == HPDF_OCLASS_PROXY) {
+        obj = ((HPDF_Proxy)obj)->obj;
+        header = (HPDF_Obj_Header *)obj;
+    }
+
+    if (header->obj_id & HPDF_OTYPE_INDIRECT) {
+        HPDF_UINT idx = header->obj_id & 0x00FFFFFF;
+
+        if (idx >= lin->count || lin->visit[idx] == lin->visit_no)
+            return;
+
+        if (header->obj_class == (HPDF_OCLASS_DICT | HPDF_OSUBCLASS_PAGES) ||
+                (header->obj_class == (HPDF_OCLASS_DICT | HPDF_OSUBCLASS_PAGE)
+                && obj != lin->page))
+            return;
+
+        lin->visit[idx] = lin->visit_no;
+
+        if (lin->mode == HPDF_LIN_FIND_OWNERS) {
+            if (lin->page_no == 0)
+                lin->first[idx] = HPDF_TRUE;
+
+            if (lin->owner[idx] == HPDF_LIN_UNUSED)
+                lin->owner[idx] = lin->page_no;
+            else if (lin->owner[idx] != lin->page_no)
+                lin->owner[idx] = HPDF_LIN_SHARED;
+        } else if (lin->ident[idx] >= 0) {
+            if (lin->mode == HPDF_LIN_STORE_REFS)
+                lin->refs[lin->total_refs] = lin->ident[idx];
+            lin->total_refs++;
+        }
+    }
+
+    switch (header->obj_class & HPDF_OCLASS_ANY) {
+        case HPDF_OCLASS_DICT: {
+            HPDF_List list = ((HPDF_Dict)obj)->list;
+
+            for (i = 0; i < list->count; i++) {
+                HPDF_DictElement element =
+                            (HPDF_DictElement)HPDF_List_ItemAt (list, i);
+
+                if (HPDF_StrCmp (element->key, "Parent") != 0)
+                    VisitObject (lin, element->value);
+            }
+            break;
+        }
+        case HPDF_OCLASS_ARRAY: {
+            HPDF_List list = ((HPDF_Array)obj)->list;
+
+            for (i = 0; i < list->count; i++)
+                VisitObject (lin, HPDF_List_ItemAt (list, i));
+            break;
+        }
+    }
+}
+
+
+static void
+VisitPage  (HPDF_Linearize  lin,
+            HPDF_UINT       page_no)
+{
+    HPDF_XrefEntry entry = HPDF_Xref_GetEntry (lin->xref,
+                lin->page_idx[page_no]);
+
+    lin->page = (HPDF_Dict)entry->obj;
+    lin->page_no = page_no;
+    lin->visit_no++;
+
+    VisitObject (lin, lin->page);
+}
+
+
+/* adds the xref index of each page under pages to lin->page_idx */
+static void
+CollectPages  (HPDF_Linearize  lin,
+               HPDF_Dict       pages)
+{
+    HPDF_Array kids = (HPDF_Array)HPDF_Dict_GetItem (pages, "Kids",
+                HPDF_OCLASS_ARRAY);
+    HPDF_UINT i;
+
+    if (!kids)
+        return;
+
+    for (i = 0; i < kids->list->count; i++) {
+        HPDF_Dict kid = (HPDF_Dict)HPDF_Array_GetItem (kids, i,
+                    HPDF_OCLASS_DICT);
+
+        if (!kid || !(kid->header.obj_id & HPDF_OTYPE_INDIRECT))
+            continue;
+
+        if (kid->header.obj_class == (HPDF_OCLASS_DICT | HPDF_OSUBCLASS_PAGES))
+            CollectPages (lin, kid);
+        else if (kid->header.obj_class ==
+                (HPDF_OCLASS_DICT | HPDF_OSUBCLASS_PAGE) &&
+                lin->npages < lin->count)
+            lin->page_idx[lin->npages++] = kid->header.obj_id & 0x00FFFFFF;
+    }
+}
+
+
+/* sorts the objects into the order they are written in, see
+ * HPDF_Linearize_Rec */
+static void
+OrderObjects  (HPDF_Linearize  lin,
+               HPDF_UINT       catalog_idx)
+{
+    HPDF_UINT ngroups = lin->npages + 2;
+    HPDF_UINT *next = lin->nrefs;     /* used as scratch space here */
+    HPDF_UINT i;
+
+    for (i = 0; i < ngroups; i++)
+        next[i] = 0;
+
+    /* the group of each object, held in ident for now */
+    for (i = 1; i < lin->count; i++) {
+        HPDF_XrefEntry entry = HPDF_Xref_GetEntry (lin->xref, i);
+        HPDF_INT group;
+
+        if (entry->entry_typ != HPDF_IN_USE_ENTRY || i == catalog_idx)
+            group = -1;
+        else if (lin->first[i])
+            group = 0;
+        else if (lin->owner[i] >= 0)
+            group = lin->owner[i];
+        else if (lin->owner[i] == HPDF_LIN_SHARED)
+            group = lin->npages;
+        else
+            group = lin->npages + 1;
+
+        lin->ident[i] = group;
+        if (group >= 0)
+            next[group]++;
+    }
+
+    lin->order[0] = catalog_idx;
+    lin->start[0] = 1;
+    for (i = 0; i < ngroups; i++)
+        lin->start[i + 1] = lin->start[i] + next[i];
+    lin->npos = lin->start[ngroups];
+
+    /* each page starts with the page object */
+    for (i = 0; i < ngroups; i++)
+        next[i] = lin->start[i];
+    for (i = 0; i < lin->npages; i++) {
+        lin->order[next[i]++] = lin->page_idx[i];
+        lin->ident[lin->page_idx[i]] = -1;
+    }
+
+    for (i = 1; i < lin->count; i++) {
+        HPDF_INT group = lin->ident[i];
+
+        if (group >= 0)
+            lin->order[next[group]++] = i;
+    }
+
+    /* the shared object hint table lists the objects of the first page,
+     * then those in the shared objects section */
+    for (i = 0; i < lin->count; i++)
+        lin->ident[i] = -1;
+
+    for (i = lin->start[0]; i < lin->start[1]; i++)
+        lin->ident[lin->order[i]] = i - lin->start[0];
+
+    for (i = lin->start[lin->npages]; i < lin->start[lin->npages + 1]; i++)
+        lin->ident[lin->order[i]] = lin->start[1] - lin->start[0] + i -
+                    lin->start[lin->npages];
+}
+
+
+/* the object number given to the object at position pos. the objects
+ * after the first page are numbered from 1 in the main cross-reference
+ * table, and the linearization dictionary, catalog, first page and hint
+ * stream are numbered after them in the first page cross-reference table */
+static HPDF_UINT
+LinearizedId  (HPDF_Linearize  lin,
+               HPDF_UINT       pos)
+{
+    HPDF_UINT main_count = lin->npos - lin->start[1] + 1;
+
+    if (pos < lin->start[1])
+        return main_count + 1 + pos;
+
+    return pos - lin->start[1] + 1;
+}
+
+
+/* writes the page offset and shared object hint tables, for the catalog
+ * at offset base. offsets in the tables leave out the hint stream */
+static HPDF_STATUS
+WriteHintTables  (HPDF_Linearize  lin,
+                  HPDF_Stream     data,
+                  HPDF_UINT32     base,
+                  HPDF_UINT       *shared_pos)
+{
+    HPDF_BitWriter_Rec w;
+    HPDF_UINT nfirst = lin->start[1] - lin->start[0];
+    HPDF_UINT shared = lin->start[lin->npages];
+    HPDF_UINT nshared = lin->start[lin->npages + 1] - shared;
+    HPDF_UINT32 min_objs = 0xFFFFFFFF, max_objs = 0;
+    HPDF_UINT32 min_len = 0xFFFFFFFF, max_len = 0;
+    HPDF_UINT32 max_refs = 0;
+    HPDF_UINT32 min_group = 0xFFFFFFFF, max_group = 0;
+    HPDF_UINT nbits_objs, nbits_len, nbits_refs, nbits_ident, nbits_group;
+    HPDF_UINT i, j, r;
+
+    for (i = 0; i < lin->npages; i++) {
+        HPDF_UINT32 objs = lin->start[i + 1] - lin->start[i];
+        HPDF_UINT32 len = lin->offset[lin->start[i + 1]] -
+                    lin->offset[lin->start[i]];
+
+        min_objs = (objs < min_objs) ? objs : min_objs;
+        max_objs = (objs > max_objs) ? objs : max_objs;
+        min_len = (len < min_len) ? len : min_len;
+        max_len = (len > max_len) ? len : max_len;
+        max_refs = (lin->nrefs[i] > max_refs) ? lin->nrefs[i] : max_refs;
+    }
+
+    for (i = 0; i < nfirst + nshared; i++) {
+        HPDF_UINT pos = (i < nfirst) ? lin->start[0] + i : shared + i - nfirst;
+        HPDF_UINT32 len = lin->offset[pos + 1] - lin->offset[pos];
+
+        min_group = (len < min_group) ? len : min_group;
+        max_group = (len > max_group) ? len : max_group;
+    }
+
+    nbits_objs = BitsNeeded (max_objs - min_objs);
+    nbits_len = BitsNeeded (max_len - min_len);
+    nbits_refs = BitsNeeded (max_refs);
+    nbits_ident = BitsNeeded (nfirst + nshared);
+    nbits_group = BitsNeeded (max_group - min_group);
+
+    w.stream = data;
+    w.byte = 0;
+    w.nbits = 0;
+    w.ret = HPDF_OK;
+
+    /* page offset hint table header. content streams are not described
+     * separately, each page is treated as one content stream */
+    WriteBits (&w, min_objs, 32);
+    WriteBits (&w, base + lin->offset[lin->start[0]], 32);
+    WriteBits (&w, nbits_objs, 16);
+    WriteBits (&w, min_len, 32);
+    WriteBits (&w, nbits_len, 16);
+    WriteBits (&w, 0, 32);
+    WriteBits (&w, 0, 16);
+    WriteBits (&w, min_len, 32);
+    WriteBits (&w, nbits_len, 16);
+    WriteBits (&w, nbits_refs, 16);
+    WriteBits (&w, nbits_ident, 16);
+    WriteBits (&w, 0, 16);
+    WriteBits (&w, 1, 16);
+
+    /* the per-page entries, one item at a time for every page */
+    for (i = 0; i < lin->npages; i++)
+        WriteBits (&w, lin->start[i + 1] - lin->start[i] - min_objs,
+                    nbits_objs);
+    FlushBits (&w);
+
+    for (i = 0; i < lin->npages; i++)
+        WriteBits (&w, lin->offset[lin->start[i + 1]] -
+                    lin->offset[lin->start[i]] - min_len, nbits_len);
+    FlushBits (&w);
+
+    for (i = 0; i < lin->npages; i++)
+        WriteBits (&w, lin->nrefs[i], nbits_refs);
+    FlushBits (&w);
+
+    for (i = 0, r = 0; i < lin->npages; i++)
+        for (j = 0; j < lin->nrefs[i]; j++)
+            WriteBits (&w, lin->refs[r++], nbits_ident);
+    FlushBits (&w);
+
+    for (i = 0; i < lin->npages; i++)
+        WriteBits (&w, lin->offset[lin->start[i + 1]] -
+                    lin->offset[lin->start[i]] - min_len, nbits_len);
+    FlushBits (&w);
+
+    /* shared object hint table, in which each object is a group */
+    *shared_pos = HPDF_Stream_Size (data);
+
+    WriteBits (&w, nshared ? LinearizedId (lin, shared) : 0, 32);
+    WriteBits (&w, nshared ? base + lin->offset[shared] : 0, 32);
+    WriteBits (&w, nfirst, 32);
+    WriteBits (&w, nfirst + nshared, 32);
+    WriteBits (&w, 0, 16);
+    WriteBits (&w, min_group, 32);
+    WriteBits (&w, nbits_group, 16);
+
+    for (i = 0; i < nfirst + nshared; i++) {
+        HPDF_UINT pos = (i < nfirst) ? lin->start[0] + i : shared + i - nfirst;
+
+        WriteBits (&w, lin->offset[pos + 1] - lin->offset[pos] - min_group,
+                    nbits_group);
+    }
+    FlushBits (&w);
+
+    for (i = 0; i < nfirst + nshared; i++)
+        WriteBits (&w, 0, 1);
+    FlushBits (&w);
+
+    return w.ret;
+}
+
+
+static HPDF_STATUS
+WriteXrefEntry  (HPDF_Stream  stream,
+                 HPDF_UINT32  offset,
+                 HPDF_UINT16  gen_no,
+                 char         entry_typ)
+{
+    char buf[HPDF_SHORT_BUF_SIZ];
+    char* pbuf;
+    char* eptr = buf + HPDF_SHORT_BUF_SIZ - 1;
+
+    pbuf = HPDF_IToA2 (buf, offset, HPDF_BYTE_OFFSET_LEN + 1);
+    *pbuf++ = ' ';
+    pbuf = HPDF_IToA2 (pbuf, gen_no, HPDF_GEN_NO_LEN + 1);
+    *pbuf++ = ' ';
+    *pbuf++ = entry_typ;
+    HPDF_StrCpy (pbuf, "\015\012", eptr);
+
+    return HPDF_Stream_WriteStr (stream, buf);
+}
+
+
+static HPDF_STATUS
+WriteObjectHeader  (HPDF_Stream  stream,
+                    HPDF_UINT    obj_id)
+{
+    HPDF_STATUS ret = HPDF_Stream_WriteUInt (stream, obj_id);
+
+    if (ret == HPDF_OK)
+        ret = HPDF_Stream_WriteStr (stream, " 0 obj\012");
+
+    return ret;
+}
+
+
+/* writes the objects for a document which can be displayed a page at a
+ * time as it is downloaded (linearized, PDF Annex F): the catalog and the
+ * first page come first with their own cross-reference table, followed by
+ * the hint tables which give the location of every other page.
+ * the objects are numbered in that order while writing, and get their own
+ * numbers back afterwards */
+HPDF_STATUS
+HPDF_Xref_WriteToStreamLinearized  (HPDF_Xref     xref,
+                                    HPDF_Stream   stream)
+{
+    HPDF_Linearize_Rec lin;
+    HPDF_STATUS ret = HPDF_OK;
+    HPDF_Dict catalog;
+    HPDF_Dict root;
+    HPDF_UINT catalog_idx;
+    HPDF_Stream head = NULL;
+    HPDF_Stream body = NULL;
+    HPDF_Stream hint_data = NULL;
+    HPDF_Stream hint = NULL;
+    HPDF_Stream prefix = NULL;
+    HPDF_Stream tail = NULL;
+    HPDF_UINT32 header_len = stream->size;
+    HPDF_UINT32 prefix_len = 0;
+    HPDF_UINT32 tail_len = 0;
+    HPDF_UINT main_count;
+    HPDF_UINT first_count;
+    HPDF_UINT deflate_end;
+    HPDF_UINT iter;
+    HPDF_UINT i;
+
+    HPDF_PTRACE((" HPDF_Xref_WriteToStreamLinearized\n"));
+
+    catalog = (HPDF_Dict)HPDF_Dict_GetItem (xref->trailer, "Root",
+                HPDF_OCLASS_DICT);
+    root = catalog ? (HPDF_Dict)HPDF_Dict_GetItem (catalog, "Pages",
+                HPDF_OCLASS_DICT) : NULL;
+
+    if (xref->prev || xref->start_offset != 0 || !root)
+        return HPDF_Xref_WriteToStream (xref, stream, NULL);
+
+    if ((ret = PrepareObjects (xref)) != HPDF_OK)
+        return ret;
+
+    HPDF_MemSet (&lin, 0, sizeof(HPDF_Linearize_Rec));
+    lin.xref = xref;
+    lin.count = xref->entries->count;
+    catalog_idx = catalog->header.obj_id & 0x00FFFFFF;
+
+    lin.visit = (HPDF_UINT *)HPDF_GetMem (xref->mmgr,
+                sizeof(HPDF_UINT) * lin.count);
+    lin.owner = (HPDF_INT *)HPDF_GetMem (xref->mmgr,
+                sizeof(HPDF_INT) * lin.count);
+    lin.first = (HPDF_BOOL *)HPDF_GetMem (xref->mmgr,
+                sizeof(HPDF_BOOL) * lin.count);
+    lin.ident = (HPDF_INT *)HPDF_GetMem (xref->mmgr,
+                sizeof(HPDF_INT) * lin.count);
+    lin.page_idx = (HPDF_UINT *)HPDF_GetMem (xref->mmgr,
+                sizeof(HPDF_UINT) * lin.count);
+    lin.order = (HPDF_UINT *)HPDF_GetMem (xref->mmgr,
+                sizeof(HPDF_UINT) * lin.count);
+    lin.start = (HPDF_UINT *)HPDF_GetMem (xref->mmgr,
+                sizeof(HPDF_UINT) * (lin.count + 3));
+    lin.nrefs = (HPDF_UINT *)HPDF_GetMem (xref->mmgr,
+                sizeof(HPDF_UINT) * (lin.count + 2));
+    lin.offset = (HPDF_UINT32 *)HPDF_GetMem (xref->mmgr,
+                sizeof(HPDF_UINT32) * (lin.count + 1));
+
+    if (!lin.visit || !lin.owner || !lin.first || !lin.ident ||
+            !lin.page_idx || !lin.order || !lin.start || !lin.nrefs ||
+            !lin.offset) {
+        ret = HPDF_Error_GetCode (xref->error);
+        goto Exit;
+    }
+
+    for (i = 0; i < lin.count; i++) {
+        lin.visit[i] = 0;
+        lin.owner[i] = HPDF_LIN_UNUSED;
+        lin.first[i] = HPDF_FALSE;
+    }
+
+    CollectPages (&lin, root);
+    if (lin.npages == 0) {
+        ret = HPDF_Xref_WriteToStream (xref, stream, NULL);
+        goto Exit;
+    }
+
+    /* find the objects used by each page, and the order to write them in */
+    lin.mode = HPDF_LIN_FIND_OWNERS;
+    for (i = 0; i < lin.npages; i++)
+        VisitPage (&lin, i);
+
+    OrderObjects (&lin, catalog_idx);
+
+    /* find the shared objects used by each page after the first */
+    lin.mode = HPDF_LIN_COUNT_REFS;
+    lin.nrefs[0] = 0;
+    for (i = 1; i < lin.npages; i++) {
+        HPDF_UINT total = lin.total_refs;
+
+        VisitPage (&lin, i);
+        lin.nrefs[i] = lin.total_refs - total;
+    }
+
+    if (lin.total_refs > 0) {
+        lin.refs = (HPDF_UINT *)HPDF_GetMem (xref->mmgr,
+                    sizeof(HPDF_UINT) * lin.total_refs);
+        if (!lin.refs) {
+            ret = HPDF_Error_GetCode (xref->error);
+            goto Exit;
+        }
+
+        lin.mode = HPDF_LIN_STORE_REFS;
+        lin.total_refs = 0;
+        for (i = 1; i < lin.npages; i++)
+            VisitPage (&lin, i);
+    }
+
+    /* deflate the streams up front, as they are not written in order */
+    if (xref->parallel_fn) {
+        for (i = 1; i < lin.count; i = deflate_end) {
+            if ((ret = DeflateObjects (xref, xref->parallel_fn,
+                    xref->parallel_data, i, &deflate_end)) != HPDF_OK)
+                goto Exit;
+        }
+    }
+
+    /* number the objects in the order they are written */
+    for (i = 0; i < lin.npos; i++) {
+        HPDF_XrefEntry entry = HPDF_Xref_GetEntry (xref, lin.order[i]);
+        HPDF_Obj_Header *header = (HPDF_Obj_Header *)entry->obj;
+
+        header->obj_id = (header->obj_id & 0xFF000000) |
+                    LinearizedId (&lin, i);
+    }
+
+    main_count = lin.npos - lin.start[1] + 1;
+    first_count = lin.start[1] + 2;
+
+    head = HPDF_MemStream_New (xref->mmgr, HPDF_STREAM_BUF_SIZ);
+    body = HPDF_MemStream_New (xref->mmgr, HPDF_STREAM_BUF_SIZ);
+    hint_data = HPDF_MemStream_New (xref->mmgr, HPDF_STREAM_BUF_SIZ);
+    hint = HPDF_MemStream_New (xref->mmgr, HPDF_STREAM_BUF_SIZ);
+    prefix = HPDF_MemStream_New (xref->mmgr, HPDF_STREAM_BUF_SIZ);
+    tail = HPDF_MemStream_New (xref->mmgr, HPDF_STREAM_BUF_SIZ);
+
+    if (!head || !body || !hint_data || !hint || !prefix || !tail) {
+        ret = HPDF_Error_GetCode (xref->error);
+        goto Exit;
+    }
+
+    /* the catalog, then everything else. the hint stream goes between
+     * them, but offsets are worked out as if it were not there */
+    for (i = 0; i < lin.npos && ret == HPDF_OK; i++) {
+        HPDF_XrefEntry entry = HPDF_Xref_GetEntry (xref, lin.order[i]);
+
+        lin.offset[i] = HPDF_Stream_Size (head) + HPDF_Stream_Size (body);
+        ret = WriteObject (entry, LinearizedId (&lin, i), i ? body : head,
+                    NULL);
+    }
+    lin.offset[lin.npos] = HPDF_Stream_Size (head) + HPDF_Stream_Size (body);
+
+    if (ret != HPDF_OK)
+        goto Exit;
+
+    /* the values in the linearization dictionary and the cross-reference
+     * tables depend on the lengths of the parts written before them, so
+     * repeat until the lengths no longer change */
+    for (iter = 0; iter < 8; iter++) {
+        HPDF_UINT32 body_start = header_len + prefix_len;
+        HPDF_UINT32 hint_len;
+        HPDF_UINT32 first_page_end;
+        HPDF_UINT32 main_xref;
+        HPDF_UINT32 lin_len;
+        HPDF_UINT shared_pos = 0;
+
+        HPDF_MemStream_FreeData (hint_data);
+        HPDF_MemStream_FreeData (hint);
+        HPDF_MemStream_FreeData (prefix);
+        HPDF_MemStream_FreeData (tail);
+
+        /* primary hint stream */
+        ret = WriteHintTables (&lin, hint_data, body_start, &shared_pos);
+        ret += WriteObjectHeader (hint, main_count + first_count - 1);
+        ret += HPDF_Stream_WriteStr (hint, "<<\012/Length ");
+        ret += HPDF_Stream_WriteUInt (hint, HPDF_Stream_Size (hint_data));
+        ret += HPDF_Stream_WriteStr (hint, "\012/S ");
+        ret += HPDF_Stream_WriteUInt (hint, shared_pos);
+        ret += HPDF_Stream_WriteStr (hint, "\012>>\012stream\015\012");
+        ret += HPDF_Stream_WriteToStream (hint_data, hint,
+                    HPDF_STREAM_FILTER_NONE, NULL);
+        ret += HPDF_Stream_WriteStr (hint, "\012endstream\012endobj\012");
+        if (ret != HPDF_OK)
+            break;
+
+        hint_len = HPDF_Stream_Size (hint);
+        first_page_end = body_start + hint_len + lin.offset[lin.start[1]];
+        main_xref = body_start + hint_len + lin.offset[lin.npos];
+
+        /* linearization parameter dictionary */
+        ret += WriteObjectHeader (prefix, main_count);
+        ret += HPDF_Stream_WriteStr (prefix, "<<\012/Linearized 1\012/L ");
+        ret += HPDF_Stream_WriteUInt (prefix, main_xref + tail_len);
+        ret += HPDF_Stream_WriteStr (prefix, "\012/H [ ");
+        ret += HPDF_Stream_WriteUInt (prefix, body_start + lin.offset[1]);
+        ret += HPDF_Stream_WriteStr (prefix, " ");
+        ret += HPDF_Stream_WriteUInt (prefix, hint_len);
+        ret += HPDF_Stream_WriteStr (prefix, " ]\012/O ");
+        ret += HPDF_Stream_WriteUInt (prefix, LinearizedId (&lin, 1));
+        ret += HPDF_Stream_WriteStr (prefix, "\012/E ");
+        ret += HPDF_Stream_WriteUInt (prefix, first_page_end);
+        ret += HPDF_Stream_WriteStr (prefix, "\012/N ");
+        ret += HPDF_Stream_WriteUInt (prefix, lin.npages);
+        /* the end of line before the first entry of the main table, which
+         * starts with "xref\0120 <main_count>\012" */
+        ret += HPDF_Stream_WriteStr (prefix, "\012/T ");
+        ret += HPDF_Stream_WriteUInt (prefix, main_xref + 7 +
+                    DigitCount (main_count));
+        ret += HPDF_Stream_WriteStr (prefix, "\012>>\012endobj\012");
+        if (ret != HPDF_OK)
+            break;
+
+        lin_len = HPDF_Stream_Size (prefix);
+
+        /* first page cross-reference table and trailer */
+        ret += HPDF_Stream_WriteStr (prefix, "xref\012");
+        ret += HPDF_Stream_WriteUInt (prefix, main_count);
+        ret += HPDF_Stream_WriteStr (prefix, " ");
+        ret += HPDF_Stream_WriteUInt (prefix, first_count);
+        ret += HPDF_Stream_WriteStr (prefix, "\012");
+        ret += WriteXrefEntry (prefix, header_len, 0, HPDF_IN_USE_ENTRY);
+        for (i = 0; i < lin.start[1]; i++)
+            ret += WriteXrefEntry (prefix, body_start + lin.offset[i] +
+                        (i ? hint_len : 0), 0, HPDF_IN_USE_ENTRY);
+        ret += WriteXrefEntry (prefix, body_start + lin.offset[1], 0,
+                    HPDF_IN_USE_ENTRY);
+
+        ret += HPDF_Dict_AddNumber (xref->trailer, "Size",
+                    main_count + first_count);
+        ret += HPDF_Dict_AddNumber (xref->trailer, "Prev", main_xref);
+        if (ret != HPDF_OK)
+            break;
+
+        ret += HPDF_Stream_WriteStr (prefix, "trailer\012");
+        ret += HPDF_Dict_Write (xref->trailer, prefix, NULL);
+        ret += HPDF_Stream_WriteStr (prefix, "\012startxref\0120\012%%EOF\012");
+
+        /* main cross-reference table and trailer */
+        ret += HPDF_Stream_WriteStr (tail, "xref\0120 ");
+        ret += HPDF_Stream_WriteUInt (tail, main_count);
+        ret += HPDF_Stream_WriteStr (tail, "\012");
+        ret += WriteXrefEntry (tail, 0, HPDF_MAX_GENERATION_NUM,
+                    HPDF_FREE_ENTRY);
+        for (i = lin.start[1]; i < lin.npos; i++)
+            ret += WriteXrefEntry (tail, body_start + hint_len +
+                        lin.offset[i], 0, HPDF_IN_USE_ENTRY);
+        ret += HPDF_Stream_WriteStr (tail, "trailer\012<<\012/Size ");
+        ret += HPDF_Stream_WriteUInt (tail, main_count);
+        ret += HPDF_Stream_WriteStr (tail, "\012>>\012startxref\012");
+        ret += HPDF_Stream_WriteUInt (tail, header_len + lin_len);
+        ret += HPDF_Stream_WriteStr (tail, "\012%%EOF\012");
+        if (ret != HPDF_OK)
+            break;
+
+        if (HPDF_Stream_Size (prefix) == prefix_len &&
+                HPDF_Stream_Size (tail) == tail_len)
+            break;
+
+        prefix_len = HPDF_Stream_Size (prefix);
+        tail_len = HPDF_Stream_Size (tail);
+    }
+
+    if (ret != HPDF_OK) {
+        ret = HPDF_Error_GetCode (xref->error);
+        goto Exit;
+    }
+
+    ret += HPDF_Stream_WriteToStream (prefix, stream, HPDF_STREAM_FILTER_NONE,
+                NULL);
+    ret += HPDF_Stream_WriteToStream (head, stream, HPDF_STREAM_FILTER_NONE,
+                NULL);
+    ret += HPDF_Stream_WriteToStream (hint, stream, HPDF_STREAM_FILTER_NONE,
+                NULL);
+    ret += HPDF_Stream_WriteToStream (body, stream, HPDF_STREAM_FILTER_NONE,
+                NULL);
+    ret += HPDF_Stream_WriteToStream (tail, stream, HPDF_STREAM_FILTER_NONE,
+                NULL);
+    if (ret != HPDF_OK)
+        ret = HPDF_Error_GetCode (stream->error);
+
+Exit:
+    /* give the objects back their own numbers */
+    for (i = 1; i < lin.count; i++) {
+        HPDF_XrefEntry entry = HPDF_Xref_GetEntry (xref, i);
+        HPDF_Obj_Header *header = (HPDF_Obj_Header *)entry->obj;
+
+        if (header)
+            header->obj_id = (header->obj_id & 0xFF000000) | i;
+    }
+    HPDF_Dict_RemoveElement (xref->trailer, "Prev");
+
+    if (lin.visit)
+        HPDF_FreeMem (xref->mmgr, lin.visit);
+    if (lin.owner)
+        HPDF_FreeMem (xref->mmgr, lin.owner);
+    if (lin.first)
+        HPDF_FreeMem (xref->mmgr, lin.first);
+    if (lin.ident)
+        HPDF_FreeMem (xref->mmgr, lin.ident);
+    if (lin.page_idx)
+        HPDF_FreeMem (xref->mmgr, lin.page_idx);
+    if (lin.order)
+        HPDF_FreeMem (xref->mmgr, lin.order);
+    if (lin.start)
+        HPDF_FreeMem (xref->mmgr, lin.start);
+    if (lin.nrefs)
+        HPDF_FreeMem (xref->mmgr, lin.nrefs);
+    if (lin.offset)
+        HPDF_FreeMem (xref->mmgr, lin.offset);
+    if (lin.refs)
+        HPDF_FreeMem (xref->mmgr, lin.refs);
+
+    if (head)
+        HPDF_Stream_Free (head);
+    if (body)
+        HPDF_Stream_Free (body);
+    if (hint_data)
+        HPDF_Stream_Free (hint_data);
+    if (hint)
+        HPDF_Stream_Free (hint);
+    if (prefix)
+        HPDF_Stream_Free (prefix);
+    if (tail)
+        HPDF_Stream_Free (tail);
+
+    return ret;
+}
+
+
+static HPDF_STATUS
+WriteObject  (HPDF_XrefEntry  entry,
+              HPDF_UINT       obj_id,
+              HPDF_Stream     stream,
+              HPDF_Encrypt    e)
+{
+    HPDF_STATUS ret;
+    char buf[HPDF_SHORT_BUF_SIZ];
+    char* pbuf;
+    char* eptr = buf + HPDF_SHORT_BUF_SIZ - 1;
+
+    entry->byte_offset = stream->size;
+
+    pbuf = buf;
+    pbuf = HPDF_IToA (pbuf, obj_id, eptr);
+    *pbuf++ = ' ';
+    pbuf = HPDF_IToA (pbuf, entry->gen_no, eptr);
+    HPDF_StrCpy(pbuf, " obj\012", eptr);
+
+    if ((ret = HPDF_Stream_WriteStr (stream, buf)) != HPDF_OK)
+       return ret;
+
+    if (e)
+        HPDF_Encrypt_InitKey (e, obj_id, entry->gen_no);
+
+    if ((ret = HPDF_Obj_WriteValue (entry->obj, stream, e)) != HPDF_OK)
+        return ret;
+
+    return HPDF_Stream_WriteStr (stream, "\012endobj\012");
+}
+
+
+/* streams which can be deflated ahead of being written */
+static HPDF_BOOL
+IsDeflatable  (HPDF_Dict  dict)
+{
+    return (dict->stream && dict->stream->type == HPDF_STREAM_MEMORY &&
+            (dict->filter & HPDF_STREAM_FILTER_FLATE_DECODE) &&
+            !dict->after_write_fn && !dict->deflated &&
+            HPDF_Stream_Size (dict->stream) > 0 &&
+            HPDF_MemStream_InMemory (dict->stream));
+}
+
+
+/* deflates the streams of count dicts concurrently with parallel_fn. count
+ * is at most HPDF_DEFLATE_WINDOW_TASKS */
+static HPDF_STATUS
+DeflateDicts  (HPDF_Xref           xref,
+               HPDF_Parallel_Func  parallel_fn,
+               void                *parallel_data,
+               HPDF_Dict           *dicts,
+               HPDF_UINT           count)
+{
+    HPDF_DeflateTask_Rec tasks[HPDF_DEFLATE_WINDOW_TASKS];
+    void *ptrs[HPDF_DEFLATE_WINDOW_TASKS];
+    HPDF_UINT i;
+    HPDF_STATUS ret = HPDF_OK;
+
+    HPDF_PTRACE((" DeflateDicts\n"));
+
+    for (i = 0; i < count; i++) {
+        tasks[i].src = dicts[i]->stream;
+        tasks[i].filter = dicts[i]->filter;
+        tasks[i].len = HPDF_Stream_DeflateBound (dicts[i]->stream);
+        tasks[i].done = HPDF_FALSE;
+        tasks[i].buf = (HPDF_BYTE *)HPDF_GetMem (xref->mmgr, tasks[i].len);
+        if (!tasks[i].buf) {
+            ret = HPDF_Error_GetCode (xref->error);
+            break;
+        }
+
+        ptrs[i] = &tasks[i];
+    }
+
+    count = i;
+
+    if (count > 0 && ret == HPDF_OK)
+        parallel_fn (count, HPDF_Stream_DeflateTask, ptrs, parallel_data);
+
+    /* streams which failed to deflate are written in the usual way */
+    for (i = 0; i < count; i++) {
+        if (tasks[i].done && ret == HPDF_OK) {
+            dicts[i]->deflated = tasks[i].buf;
+            dicts[i]->deflated_len = tasks[i].len;
+        } else
+            HPDF_FreeMem (xref->mmgr, tasks[i].buf);
+    }
+
+    return ret;
+}
+
+
+/* prepares the objects from start onwards for writing, and deflates the
+ * streams among them concurrently with parallel_fn.
+ * end is set to the first object which has not been prepared */
+static HPDF_STATUS
+DeflateObjects  (HPDF_Xref           xref,
+                 HPDF_Parallel_Func  parallel_fn,
+                 void                *parallel_data,
+                 HPDF_UINT           start,
+                 HPDF_UINT           *end)
+{
+    HPDF_Dict dicts[HPDF_DEFLATE_WINDOW_TASKS];
+    HPDF_UINT count = 0;
+    HPDF_UINT size = 0;
+    HPDF_UINT i;
+    HPDF_STATUS ret;
+
+    HPDF_PTRACE((" DeflateObjects\n"));
+
+    for (i = start; i < xref->entries->count; i++) {
+        HPDF_XrefEntry entry =
+                    (HPDF_XrefEntry)HPDF_List_ItemAt (xref->entries, i);
+        HPDF_Obj_Header *header = (HPDF_Obj_Header *)entry->obj;
+        HPDF_Dict dict;
+
+        if (count == HPDF_DEFLATE_WINDOW_TASKS ||
+                size >= HPDF_DEFLATE_WINDOW_SIZE)
+            break;
+
+        if (!header || entry->written ||
+                (header->obj_class & HPDF_OCLASS_ANY) != HPDF_OCLASS_DICT)
+            continue;
+
+        dict = (HPDF_Dict)entry->obj;
+
+        /* before_write_fn may still add to the contents of the stream,
+         * or add new objects to the end of the xref */
+        if (dict->before_write_fn && !dict->prepared) {
+            if ((ret = dict->before_write_fn (dict)) != HPDF_OK)
+                return ret;
+            dict->prepared = HPDF_TRUE;
+        }
+
+        if (!IsDeflatable (dict))
+            continue;
+
+        dicts[count++] = dict;
+        size += HPDF_Stream_Size (dict->stream);
+    }
+
+    *end = i;
+
+    return DeflateDicts (xref, parallel_fn, parallel_data, dicts, count);
+}
+
+
+/* deflates the streams of the given objects concurrently with parallel_fn,
+ * for objects which are written ahead with HPDF_Xref_WriteObject. the
+ * objects must already be prepared for writing */
+HPDF_STATUS
+HPDF_Xref_DeflateStreams  (HPDF_Xref           xref,
+                           HPDF_Parallel_Func  parallel_fn,
+                           void                *parallel_data,
+                           HPDF_Dict           *dicts,
+                           HPDF_UINT           count)
+{
+    HPDF_Dict window[HPDF_DEFLATE_WINDOW_TASKS];
+    HPDF_UINT i = 0;
+    HPDF_STATUS ret = HPDF_OK;
+
+    HPDF_PTRACE((" HPDF_Xref_DeflateStreams\n"));
+
+    while (i < count && ret == HPDF_OK) {
+        HPDF_UINT n = 0;
+        HPDF_UINT size = 0;
+
+        for (; i < count && n < HPDF_DEFLATE_WINDOW_TASKS &&
+                size < HPDF_DEFLATE_WINDOW_SIZE; i++) {
+            if (!IsDeflatable (dicts[i]))
+                continue;
+
+            window[n++] = dicts[i];
+            size += HPDF_Stream_Size (dicts[i]->stream);
+        }
+
+        ret = DeflateDicts (xref, parallel_fn, parallel_data, window, n);
+    }
+
+    return ret;
+}
+
+
+/* writes an object ahead of the rest of the document, which is written by
+ * HPDF_Xref_WriteToStream to the same stream later on. the object must
+ * not be changed afterwards */
+HPDF_STATUS
+HPDF_Xref_WriteObject  (HPDF_Xref     xref,
+                        void          *obj,
+                        HPDF_Stream   stream)
+{
+    HPDF_Obj_Header *header = (HPDF_Obj_Header *)obj;
+    HPDF_UINT obj_id = header->obj_id & 0x00FFFFFF;
+    HPDF_XrefEntry entry;
+    HPDF_STATUS ret;
+
+    HPDF_PTRACE((" HPDF_Xref_WriteObject\n"));
+
+    if (!(header->obj_id & HPDF_OTYPE_INDIRECT) || xref->prev ||
+            obj_id >= xref->entries->count)
+        return HPDF_SetError (xref->error, HPDF_INVALID_OBJECT, 0);
+
+    entry = HPDF_Xref_GetEntry (xref, obj_id);
+    if (entry->written)
+        return HPDF_OK;
+
+    if ((ret = WriteObject (entry, obj_id, stream, NULL)) != HPDF_OK)
+        return ret;
+
+    entry->written = HPDF_TRUE;
+
+    return HPDF_OK;
+}
+
+
+/* frees an object written by HPDF_Xref_WriteObject. it must no longer be
+ * referred to by any object which has still to be written */
+void
+HPDF_Xref_ReleaseObject  (HPDF_Xref   xref,
+                          void        *obj)
+{
+    HPDF_Obj_Header *header = (HPDF_Obj_Header *)obj;
+    HPDF_XrefEntry entry;
+
+    HPDF_PTRACE((" HPDF_Xref_ReleaseObject\n"));
+
+    entry = HPDF_Xref_GetEntry (xref, header->obj_id & 0x00FFFFFF);
+    if (!entry || entry->obj != obj || !entry->written)
+        return;
+
+    HPDF_Obj_ForceFree (xref->mmgr, obj);
+    entry->obj = NULL;
+}
+
+
 static HPDF_STATUS
 WriteTrailer  (HPDF_Xref     xref,
                HPDF_Stream   stream)